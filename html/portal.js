@@ -390,6 +390,7 @@ function updateCardsListUI() {
                     <button onclick="deleteCard(${index})" class="delete-card-btn">Delete</button>
                 </div>
             </div>
+            ${REFRESHABLE_CARD_TYPES.includes(card.type) ? renderRefreshEditor(card, index) : ''}
         `;
         
         // Add drag event listeners
@@ -406,6 +407,95 @@ function updateCardsListUI() {
     container.appendChild(list);
 }
 
+// Card types fetched from PostHog, which take a refresh policy
+const REFRESHABLE_CARD_TYPES = ['INSIGHT', 'HOGQL'];
+const REFRESH_INTERVALS = [
+    [0, 'Automatic'], [10, 'Every 10 seconds'], [30, 'Every 30 seconds'], [60, 'Every minute'],
+    [300, 'Every 5 minutes'], [900, 'Every 15 minutes'], [3600, 'Every hour'], [21600, 'Every 6 hours']
+];
+
+// The device keeps active hours in UTC; the editor shows them in the browser's time zone
+function utcOffsetHours() {
+    return Math.round(-new Date().getTimezoneOffset() / 60);
+}
+
+function utcToLocalHour(hour) {
+    return (hour + utcOffsetHours() + 24) % 24;
+}
+
+function localToUtcHour(hour) {
+    return (hour - utcOffsetHours() + 24) % 24;
+}
+
+function describeRefreshPolicy(refresh) {
+    if (!refresh) return 'Automatic';
+    const parts = [];
+    const interval = REFRESH_INTERVALS.find(([seconds]) => seconds === (refresh.interval || 0));
+    parts.push(interval ? interval[1] : `Every ${refresh.interval} seconds`);
+    if (refresh.from !== undefined && refresh.to !== undefined) {
+        parts.push(`${utcToLocalHour(refresh.from)}:00–${utcToLocalHour(refresh.to)}:00`);
+    }
+    if (refresh.onView) parts.push('only while shown');
+    return parts.join(', ');
+}
+
+function renderRefreshEditor(card, index) {
+    const refresh = card.refresh || {};
+    const hasHours = refresh.from !== undefined && refresh.to !== undefined;
+    const hourOptions = (selected) => Array.from({ length: 24 }, (_, hour) =>
+        `<option value="${hour}" ${hour === selected ? 'selected' : ''}>${hour}:00</option>`).join('');
+    const intervalOptions = REFRESH_INTERVALS.map(([seconds, label]) =>
+        `<option value="${seconds}" ${seconds === (refresh.interval || 0) ? 'selected' : ''}>${label}</option>`).join('');
+
+    return `
+        <details class="refresh-editor">
+            <summary>Refresh: ${describeRefreshPolicy(card.refresh)}</summary>
+            <label>Interval
+                <select id="refresh-interval-${index}">${intervalOptions}</select>
+            </label>
+            <label>
+                <input type="checkbox" id="refresh-hours-${index}" ${hasHours ? 'checked' : ''}>
+                Only between
+                <select id="refresh-from-${index}">${hourOptions(hasHours ? utcToLocalHour(refresh.from) : 8)}</select>
+                and
+                <select id="refresh-to-${index}">${hourOptions(hasHours ? utcToLocalHour(refresh.to) : 18)}</select>
+            </label>
+            <label>
+                <input type="checkbox" id="refresh-onview-${index}" ${refresh.onView ? 'checked' : ''}>
+                Only while the card is on screen
+            </label>
+            <button onclick="saveRefreshPolicy(${index})">Save refresh settings</button>
+        </details>
+    `;
+}
+
+// Read the refresh editor of a card and save it to the device
+function saveRefreshPolicy(index) {
+    const sortedCards = [...configuredCards].sort((a, b) => a.order - b.order);
+    const card = sortedCards[index];
+    if (!card) return;
+
+    const refresh = {};
+    const interval = parseInt(document.getElementById(`refresh-interval-${index}`).value);
+    if (interval > 0) refresh.interval = interval;
+    if (document.getElementById(`refresh-hours-${index}`).checked) {
+        const from = localToUtcHour(parseInt(document.getElementById(`refresh-from-${index}`).value));
+        const to = localToUtcHour(parseInt(document.getElementById(`refresh-to-${index}`).value));
+        if (from !== to) {
+            refresh.from = from;
+            refresh.to = to;
+        }
+    }
+    if (document.getElementById(`refresh-onview-${index}`).checked) refresh.onView = true;
+
+    if (Object.keys(refresh).length > 0) {
+        card.refresh = refresh;
+    } else {
+        delete card.refresh;
+    }
+    saveCardConfiguration();
+}
+
 // Drag and drop variables
 let draggedElement = null;
 let draggedIndex = null;
@@ -701,6 +791,7 @@ function requestScanNetworks() {
 let lastProcessedAction = null;
 let lastProcessedActionMessage = "";
 let initialDeviceConfigLoaded = false;
+let pushTokenRevealed = false;
 let lastWifiUpdateTime = 0;
 const WIFI_UPDATE_INTERVAL = 10000; // Update WiFi list every 10 seconds
 
@@ -860,6 +951,45 @@ function _updateDeviceConfigUI(config) {
         }
         initialDeviceConfigLoaded = true;
     }
+    if (config.push_token_display && !pushTokenRevealed) {
+        const tokenField = document.getElementById('push-token');
+        if (tokenField) {
+            tokenField.textContent = config.push_token_display;
+        }
+    }
+}
+
+// Fetch the full push token on request; /api/status only carries a masked copy
+function revealPushToken() {
+    fetch('/api/actions/reveal-push-token', { method: 'POST' })
+        .then(response => response.json())
+        .then(data => {
+            if (data.success && data.push_token) {
+                pushTokenRevealed = true;
+                _updatePushUI(data.push_token);
+            }
+        })
+        .catch(error => {
+            console.error('Error revealing push token:', error);
+        });
+}
+
+// Show the push token and an example request for PUSH cards
+function _updatePushUI(token) {
+    const tokenField = document.getElementById('push-token');
+    const exampleField = document.getElementById('push-example');
+    if (!tokenField || tokenField.textContent === token) {
+        return;
+    }
+    tokenField.textContent = token;
+    if (exampleField) {
+        exampleField.textContent =
+            `curl -X POST http://${window.location.host}/api/push \\\n` +
+            `  -H "Authorization: Bearer ${token}" \\\n` +
+            `  -d '{"card": "<card ID>", "title": "Orders", "value": 42}'\n\n` +
+            `Series: {"card": "<card ID>", "series": [["2025-01-01", 3], ["2025-01-02", 5]]}\n` +
+            `Several cards at once: send an array of these objects.`;
+    }
 }
 
 // Initialize page
@@ -881,6 +1011,11 @@ document.addEventListener('DOMContentLoaded', function() {
         installUpdateBtn.addEventListener('click', requestStartFirmwareUpdate);
     }
 
+    const revealPushTokenBtn = document.getElementById('reveal-push-token-btn');
+    if (revealPushTokenBtn) {
+        revealPushTokenBtn.addEventListener('click', revealPushToken);
+    }
+
     pollApiStatus();
     setInterval(pollApiStatus, 3000); // Poll every 3 seconds for responsiveness
 
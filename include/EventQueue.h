@@ -26,7 +26,8 @@ enum class EventType {
     OTA_PROCESS_START,
     OTA_PROCESS_END,
     CARD_CONFIG_CHANGED,
-    CARD_TITLE_UPDATED
+    CARD_TITLE_UPDATED,
+    QUERY_DATA_RECEIVED
 };
 
 /**
@@ -38,6 +39,8 @@ struct Event {
     std::shared_ptr<InsightParser> parser;  // Optional parsed insight data
     String jsonData;                        // Raw JSON data for insights
     String title;                           // Title/name for card title updates
+    bool stale = false;                     // Insight data is a cached copy awaiting refresh
+    double value = 0.0;                     // Result of a HogQL query, with its column name in title
     
     Event() {}
     
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stdlib.h>
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+/**
+ * @brief ArduinoJson allocator that places documents in PSRAM
+ *
+ * Falls back to the regular heap when the board has no PSRAM or when not
+ * building for the ESP32. Implements reallocate(), so shrinkToFit() on a
+ * document releases the unused tail in place.
+ */
+struct PsramAllocator {
+    // Check whether the board has PSRAM
+    static bool psramAvailable() {
+#ifdef ESP32
+        return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+#else
+        return false;
+#endif
+    }
+
+    void* allocate(size_t size) {
+#ifdef ESP32
+        if (psramAvailable()) {
+            return heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        }
+#endif
+        return malloc(size);
+    }
+
+    void deallocate(void* pointer) {
+        // heap_caps_free() and free() both handle either heap on the ESP32
+        free(pointer);
+    }
+
+    void* reallocate(void* pointer, size_t new_size) {
+#ifdef ESP32
+        if (pointer && esp_ptr_external_ram(pointer)) {
+            return heap_caps_realloc(pointer, new_size, MALLOC_CAP_SPIRAM);
+        }
+#endif
+        return realloc(pointer, new_size);
+    }
+};
+
+/**
+ * @brief JSON document allocated in PSRAM
+ */
+typedef BasicJsonDocument<PsramAllocator> PsramJsonDocument;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+class TimeFormat {
+public:
+    // Parse an ISO 8601 timestamp such as "2025-05-01T12:34:56.789Z" or
+    // "2025-05-01T12:34:56+02:00" into Unix time (UTC)
+    static bool parseIso8601(const char* text, time_t* result) {
+        if (!text || !result) {
+            return false;
+        }
+
+        int year, month, day, hour, minute, second;
+        int consumed = 0;
+        if (sscanf(text, "%4d-%2d-%2dT%2d:%2d:%2d%n", &year, &month, &day, &hour, &minute, &second, &consumed) != 6) {
+            return false;
+        }
+
+        // Skip fractional seconds
+        const char* rest = text + consumed;
+        if (*rest == '.') {
+            rest++;
+            while (*rest >= '0' && *rest <= '9') {
+                rest++;
+            }
+        }
+
+        long offset_seconds = 0;
+        if (*rest == '+' || *rest == '-') {
+            int offset_hours = 0;
+            int offset_minutes = 0;
+            if (sscanf(rest + 1, "%2d:%2d", &offset_hours, &offset_minutes) < 1) {
+                return false;
+            }
+            offset_seconds = offset_hours * 3600L + offset_minutes * 60L;
+            if (*rest == '-') {
+                offset_seconds = -offset_seconds;
+            }
+        } else if (*rest != 'Z' && *rest != '\0') {
+            return false;
+        }
+
+        if (!toEpoch(year, month, day, hour, minute, second, result)) {
+            return false;
+        }
+        *result -= offset_seconds;
+        return true;
+    }
+
+    // Parse an HTTP date such as "Sun, 06 Nov 1994 08:49:37 GMT" into Unix time
+    static bool parseHttpDate(const char* text, time_t* result) {
+        if (!text || !result) {
+            return false;
+        }
+
+        static const char* MONTHS = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        char month_name[4] = "";
+        int year, day, hour, minute, second;
+        if (sscanf(text, "%*3s, %d %3s %d %d:%d:%d", &day, month_name, &year, &hour, &minute, &second) != 6) {
+            return false;
+        }
+
+        const char* match = strstr(MONTHS, month_name);
+        if (strlen(month_name) != 3 || !match || (match - MONTHS) % 3 != 0) {
+            return false;
+        }
+        int month = (int)(match - MONTHS) / 3 + 1;
+
+        return toEpoch(year, month, day, hour, minute, second, result);
+    }
+
+private:
+    // Days since 1970-01-01 for a proleptic Gregorian date, without relying on the timezone
+    static bool toEpoch(int year, int month, int day, int hour, int minute, int second, time_t* result) {
+        if (month < 1 || month > 12 || day < 1 || day > 31 ||
+            hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60) {
+            return false;
+        }
+
+        year -= month <= 2 ? 1 : 0;
+        long era = (year >= 0 ? year : year - 399) / 400;
+        long year_of_era = year - era * 400;
+        long day_of_year = (153L * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        long days = era * 146097 + day_of_era - 719468;
+
+        *result = (time_t)days * 86400 + hour * 3600L + minute * 60L + second;
+        return true;
+    }
+};
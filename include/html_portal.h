@@ -407,6 +407,40 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 ".drag-handle:active {\n"
 "    cursor: grabbing;\n"
 "}\n"
+"/* Per-card refresh settings */\n"
+".refresh-editor {\n"
+"    margin-top: 0.5rem;\n"
+"    font-size: 0.9rem;\n"
+"    cursor: default;\n"
+"}\n"
+"\n"
+".refresh-editor summary {\n"
+"    color: var(--label-color);\n"
+"    cursor: pointer;\n"
+"}\n"
+"\n"
+".refresh-editor label {\n"
+"    display: block;\n"
+"    margin: 0.4rem 0;\n"
+"}\n"
+"\n"
+".refresh-editor select {\n"
+"    width: auto;\n"
+"    margin: 0 0.25rem;\n"
+"}\n"
+"\n"
+"/* Example request for pushed data cards */\n"
+".push-example {\n"
+"    font-family: monospace;\n"
+"    font-size: 0.85rem;\n"
+"    white-space: pre-wrap;\n"
+"    word-wrap: break-word;\n"
+"    background-color: #f8f9fa;\n"
+"    border: 1px solid #dee2e6;\n"
+"    padding: 10px;\n"
+"    border-radius: var(--radius);\n"
+"}\n"
+"\n"
 "</style>\n"
 "    <script>\n"
 "function showScreen(screenId) {\n"
@@ -801,6 +835,7 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "                    <button onclick=\"deleteCard(${index})\" class=\"delete-card-btn\">Delete</button>\n"
 "                </div>\n"
 "            </div>\n"
+"            ${REFRESHABLE_CARD_TYPES.includes(card.type) ? renderRefreshEditor(card, index) : ''}\n"
 "        `;\n"
 "        \n"
 "        // Add drag event listeners\n"
@@ -817,6 +852,95 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "    container.appendChild(list);\n"
 "}\n"
 "\n"
+"// Card types fetched from PostHog, which take a refresh policy\n"
+"const REFRESHABLE_CARD_TYPES = ['INSIGHT', 'HOGQL'];\n"
+"const REFRESH_INTERVALS = [\n"
+"    [0, 'Automatic'], [10, 'Every 10 seconds'], [30, 'Every 30 seconds'], [60, 'Every minute'],\n"
+"    [300, 'Every 5 minutes'], [900, 'Every 15 minutes'], [3600, 'Every hour'], [21600, 'Every 6 hours']\n"
+"];\n"
+"\n"
+"// The device keeps active hours in UTC; the editor shows them in the browser's time zone\n"
+"function utcOffsetHours() {\n"
+"    return Math.round(-new Date().getTimezoneOffset() / 60);\n"
+"}\n"
+"\n"
+"function utcToLocalHour(hour) {\n"
+"    return (hour + utcOffsetHours() + 24) % 24;\n"
+"}\n"
+"\n"
+"function localToUtcHour(hour) {\n"
+"    return (hour - utcOffsetHours() + 24) % 24;\n"
+"}\n"
+"\n"
+"function describeRefreshPolicy(refresh) {\n"
+"    if (!refresh) return 'Automatic';\n"
+"    const parts = [];\n"
+"    const interval = REFRESH_INTERVALS.find(([seconds]) => seconds === (refresh.interval || 0));\n"
+"    parts.push(interval ? interval[1] : `Every ${refresh.interval} seconds`);\n"
+"    if (refresh.from !== undefined && refresh.to !== undefined) {\n"
+"        parts.push(`${utcToLocalHour(refresh.from)}:00–${utcToLocalHour(refresh.to)}:00`);\n"
+"    }\n"
+"    if (refresh.onView) parts.push('only while shown');\n"
+"    return parts.join(', ');\n"
+"}\n"
+"\n"
+"function renderRefreshEditor(card, index) {\n"
+"    const refresh = card.refresh || {};\n"
+"    const hasHours = refresh.from !== undefined && refresh.to !== undefined;\n"
+"    const hourOptions = (selected) => Array.from({ length: 24 }, (_, hour) =>\n"
+"        `<option value=\"${hour}\" ${hour === selected ? 'selected' : ''}>${hour}:00</option>`).join('');\n"
+"    const intervalOptions = REFRESH_INTERVALS.map(([seconds, label]) =>\n"
+"        `<option value=\"${seconds}\" ${seconds === (refresh.interval || 0) ? 'selected' : ''}>${label}</option>`).join('');\n"
+"\n"
+"    return `\n"
+"        <details class=\"refresh-editor\">\n"
+"            <summary>Refresh: ${describeRefreshPolicy(card.refresh)}</summary>\n"
+"            <label>Interval\n"
+"                <select id=\"refresh-interval-${index}\">${intervalOptions}</select>\n"
+"            </label>\n"
+"            <label>\n"
+"                <input type=\"checkbox\" id=\"refresh-hours-${index}\" ${hasHours ? 'checked' : ''}>\n"
+"                Only between\n"
+"                <select id=\"refresh-from-${index}\">${hourOptions(hasHours ? utcToLocalHour(refresh.from) : 8)}</select>\n"
+"                and\n"
+"                <select id=\"refresh-to-${index}\">${hourOptions(hasHours ? utcToLocalHour(refresh.to) : 18)}</select>\n"
+"            </label>\n"
+"            <label>\n"
+"                <input type=\"checkbox\" id=\"refresh-onview-${index}\" ${refresh.onView ? 'checked' : ''}>\n"
+"                Only while the card is on screen\n"
+"            </label>\n"
+"            <button onclick=\"saveRefreshPolicy(${index})\">Save refresh settings</button>\n"
+"        </details>\n"
+"    `;\n"
+"}\n"
+"\n"
+"// Read the refresh editor of a card and save it to the device\n"
+"function saveRefreshPolicy(index) {\n"
+"    const sortedCards = [...configuredCards].sort((a, b) => a.order - b.order);\n"
+"    const card = sortedCards[index];\n"
+"    if (!card) return;\n"
+"\n"
+"    const refresh = {};\n"
+"    const interval = parseInt(document.getElementById(`refresh-interval-${index}`).value);\n"
+"    if (interval > 0) refresh.interval = interval;\n"
+"    if (document.getElementById(`refresh-hours-${index}`).checked) {\n"
+"        const from = localToUtcHour(parseInt(document.getElementById(`refresh-from-${index}`).value));\n"
+"        const to = localToUtcHour(parseInt(document.getElementById(`refresh-to-${index}`).value));\n"
+"        if (from !== to) {\n"
+"            refresh.from = from;\n"
+"            refresh.to = to;\n"
+"        }\n"
+"    }\n"
+"    if (document.getElementById(`refresh-onview-${index}`).checked) refresh.onView = true;\n"
+"\n"
+"    if (Object.keys(refresh).length > 0) {\n"
+"        card.refresh = refresh;\n"
+"    } else {\n"
+"        delete card.refresh;\n"
+"    }\n"
+"    saveCardConfiguration();\n"
+"}\n"
+"\n"
 "// Drag and drop variables\n"
 "let draggedElement = null;\n"
 "let draggedIndex = null;\n"
@@ -1112,6 +1236,7 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "let lastProcessedAction = null;\n"
 "let lastProcessedActionMessage = \"\";\n"
 "let initialDeviceConfigLoaded = false;\n"
+"let pushTokenRevealed = false;\n"
 "let lastWifiUpdateTime = 0;\n"
 "const WIFI_UPDATE_INTERVAL = 10000; // Update WiFi list every 10 seconds\n"
 "\n"
@@ -1271,6 +1396,45 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "        }\n"
 "        initialDeviceConfigLoaded = true;\n"
 "    }\n"
+"    if (config.push_token_display && !pushTokenRevealed) {\n"
+"        const tokenField = document.getElementById('push-token');\n"
+"        if (tokenField) {\n"
+"            tokenField.textContent = config.push_token_display;\n"
+"        }\n"
+"    }\n"
+"}\n"
+"\n"
+"// Fetch the full push token on request; /api/status only carries a masked copy\n"
+"function revealPushToken() {\n"
+"    fetch('/api/actions/reveal-push-token', { method: 'POST' })\n"
+"        .then(response => response.json())\n"
+"        .then(data => {\n"
+"            if (data.success && data.push_token) {\n"
+"                pushTokenRevealed = true;\n"
+"                _updatePushUI(data.push_token);\n"
+"            }\n"
+"        })\n"
+"        .catch(error => {\n"
+"            console.error('Error revealing push token:', error);\n"
+"        });\n"
+"}\n"
+"\n"
+"// Show the push token and an example request for PUSH cards\n"
+"function _updatePushUI(token) {\n"
+"    const tokenField = document.getElementById('push-token');\n"
+"    const exampleField = document.getElementById('push-example');\n"
+"    if (!tokenField || tokenField.textContent === token) {\n"
+"        return;\n"
+"    }\n"
+"    tokenField.textContent = token;\n"
+"    if (exampleField) {\n"
+"        exampleField.textContent =\n"
+"            `curl -X POST http://${window.location.host}/api/push \\\\\\n` +\n"
+"            `  -H \"Authorization: Bearer ${token}\" \\\\\\n` +\n"
+"            `  -d '{\"card\": \"<card ID>\", \"title\": \"Orders\", \"value\": 42}'\\n\\n` +\n"
+"            `Series: {\"card\": \"<card ID>\", \"series\": [[\"2025-01-01\", 3], [\"2025-01-02\", 5]]}\\n` +\n"
+"            `Several cards at once: send an array of these objects.`;\n"
+"    }\n"
 "}\n"
 "\n"
 "// Initialize page\n"
@@ -1292,6 +1456,11 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "        installUpdateBtn.addEventListener('click', requestStartFirmwareUpdate);\n"
 "    }\n"
 "\n"
+"    const revealPushTokenBtn = document.getElementById('reveal-push-token-btn');\n"
+"    if (revealPushTokenBtn) {\n"
+"        revealPushTokenBtn.addEventListener('click', revealPushToken);\n"
+"    }\n"
+"\n"
 "    pollApiStatus();\n"
 "    setInterval(pollApiStatus, 3000); // Poll every 3 seconds for responsiveness\n"
 "\n"
@@ -1515,7 +1684,7 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "        <div class=\"config-section\">\n"
 "            <form id=\"device-form\" onsubmit=\"return saveDeviceConfig()\">\n"
 "                <div class=\"form-group region-group\">\n"
-"                    <label>Region</label>\n"
+"                    <label for=\"region\">Region</label>\n"
 "                    <div class=\"region-options\">\n"
 "                        <label for=\"region-us\">\n"
 "                            <input type=\"radio\" name=\"region\" id=\"region-us\" value=\"us\">\n"
@@ -1562,6 +1731,13 @@ static const char PORTAL_HTML[] PROGMEM = "<!DOCTYPE html>\n"
 "            </div>\n"
 "        </div>\n"
 "\n"
+"        <h2>Push data</h2>\n"
+"        <div class=\"config-section\" id=\"push-section\">\n"
+"            <p>Add a \"Pushed data\" card, then send it numbers or series from your own systems on this network. Nothing is fetched from PostHog for these cards.</p>\n"
+"            <p>Push token: <code id=\"push-token\">Loading...</code> <button type=\"button\" id=\"reveal-push-token-btn\">Show token</button></p>\n"
+"            <pre id=\"push-example\" class=\"push-example\"></pre>\n"
+"        </div>\n"
+"\n"
 "        <!-- Firmware Update Section -->\n"
 "        <h2>Firmware update</h2>\n"
 "        <div class=\"config-section\" id=\"firmware-update-section\">\n"
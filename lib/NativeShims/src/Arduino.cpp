@@ -0,0 +1,81 @@
+#include "Arduino.h"
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static std::chrono::steady_clock::time_point bootTime() {
+    static const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+    return boot;
+}
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime()).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime()).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+static std::mt19937& generator() {
+    static std::mt19937 engine(std::random_device{}());
+    return engine;
+}
+
+// random() and esp_random() are called from several tasks
+static std::mutex generatorLock;
+
+long random(long max) {
+    return random(0, max);
+}
+
+long random(long min, long max) {
+    if (max <= min) {
+        return min;
+    }
+    std::lock_guard<std::mutex> guard(generatorLock);
+    std::uniform_int_distribution<long> distribution(min, max - 1);
+    return distribution(generator());
+}
+
+uint32_t esp_random() {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    return generator()();
+}
+
+bool psramFound() {
+    return true;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stack_buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(stack_buffer, sizeof(stack_buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t)length < sizeof(stack_buffer)) {
+        return write(reinterpret_cast<const uint8_t*>(stack_buffer), length);
+    }
+
+    std::string heap_buffer(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&heap_buffer[0], heap_buffer.size(), format, args);
+    va_end(args);
+    return write(reinterpret_cast<const uint8_t*>(heap_buffer.data()), length);
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core used by the PostHog fetch
+// pipeline, so it builds and runs in the native test environment. Only what
+// the pipeline calls is implemented, with the same semantics as the ESP32 core.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long max);
+long random(long min, long max);
+uint32_t esp_random();
+bool psramFound();
+
+/**
+ * @class String
+ * @brief Arduino String backed by std::string
+ */
+class String {
+public:
+    String() {}
+    String(const char* text) : _text(text ? text : "") {}
+    String(const char* text, size_t length) : _text(text ? text : "", text ? length : 0) {}
+    String(const std::string& text) : _text(text) {}
+    explicit String(char c) : _text(1, c) {}
+    explicit String(int value, unsigned char base = 10) : _text(formatInteger(value, base)) {}
+    explicit String(unsigned int value, unsigned char base = 10) : _text(formatUnsigned(value, base)) {}
+    explicit String(long value, unsigned char base = 10) : _text(formatInteger(value, base)) {}
+    explicit String(unsigned long value, unsigned char base = 10) : _text(formatUnsigned(value, base)) {}
+    explicit String(long long value, unsigned char base = 10) : _text(formatInteger(value, base)) {}
+    explicit String(unsigned long long value, unsigned char base = 10) : _text(formatUnsigned(value, base)) {}
+    explicit String(float value, unsigned int decimals = 2) : _text(formatDouble(value, decimals)) {}
+    explicit String(double value, unsigned int decimals = 2) : _text(formatDouble(value, decimals)) {}
+
+    const char* c_str() const { return _text.c_str(); }
+    unsigned int length() const { return _text.length(); }
+    bool isEmpty() const { return _text.empty(); }
+    bool reserve(unsigned int size) { _text.reserve(size); return true; }
+    void clear() { _text.clear(); }
+
+    bool concat(const String& other) { _text += other._text; return true; }
+    bool concat(const char* text) { if (!text) return false; _text += text; return true; }
+    bool concat(const char* text, unsigned int length) { if (!text) return false; _text.append(text, length); return true; }
+    bool concat(char c) { _text += c; return true; }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+
+    template <typename T>
+    String& operator+=(const T& value) { concat(value); return *this; }
+
+    char operator[](unsigned int index) const { return index < _text.length() ? _text[index] : 0; }
+    char& operator[](unsigned int index) { return _text[index]; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+    void setCharAt(unsigned int index, char c) { if (index < _text.length()) _text[index] = c; }
+
+    bool equals(const String& other) const { return _text == other._text; }
+    bool equalsIgnoreCase(const String& other) const {
+        if (_text.length() != other._text.length()) return false;
+        for (size_t i = 0; i < _text.length(); i++) {
+            if (tolower((unsigned char)_text[i]) != tolower((unsigned char)other._text[i])) return false;
+        }
+        return true;
+    }
+    bool startsWith(const String& prefix) const { return _text.compare(0, prefix._text.length(), prefix._text) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _text.length() >= suffix._text.length() &&
+               _text.compare(_text.length() - suffix._text.length(), suffix._text.length(), suffix._text) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return toIndex(_text.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return toIndex(_text.find(text._text, from)); }
+    int lastIndexOf(char c) const { return toIndex(_text.rfind(c)); }
+    int lastIndexOf(const String& text) const { return toIndex(_text.rfind(text._text)); }
+
+    String substring(unsigned int from) const { return from < _text.length() ? String(_text.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= _text.length()) return String();
+        return String(_text.substr(from, to - from));
+    }
+
+    void remove(unsigned int index) { if (index < _text.length()) _text.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < _text.length()) _text.erase(index, count); }
+    void replace(const String& find, const String& replacement) {
+        if (find._text.empty()) return;
+        size_t pos = 0;
+        while ((pos = _text.find(find._text, pos)) != std::string::npos) {
+            _text.replace(pos, find._text.length(), replacement._text);
+            pos += replacement._text.length();
+        }
+    }
+    void trim() {
+        size_t start = _text.find_first_not_of(" \t\r\n");
+        size_t end = _text.find_last_not_of(" \t\r\n");
+        _text = (start == std::string::npos) ? std::string() : _text.substr(start, end - start + 1);
+    }
+    void toLowerCase() { for (char& c : _text) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : _text) c = toupper((unsigned char)c); }
+
+    long toInt() const { return strtol(_text.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_text.c_str(), nullptr); }
+    double toDouble() const { return strtod(_text.c_str(), nullptr); }
+
+    friend bool operator==(const String& a, const String& b) { return a._text == b._text; }
+    friend bool operator==(const String& a, const char* b) { return a._text == (b ? b : ""); }
+    friend bool operator==(const char* a, const String& b) { return b == a; }
+    friend bool operator!=(const String& a, const String& b) { return !(a == b); }
+    friend bool operator!=(const String& a, const char* b) { return !(a == b); }
+    friend bool operator!=(const char* a, const String& b) { return !(b == a); }
+    friend bool operator<(const String& a, const String& b) { return a._text < b._text; }
+    friend bool operator>(const String& a, const String& b) { return a._text > b._text; }
+
+private:
+    std::string _text;
+
+    static int toIndex(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+    static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+        if (base < 2 || base > 36) base = 10;
+        char buffer[66];
+        char* p = buffer + sizeof(buffer) - 1;
+        *p = '\0';
+        do {
+            unsigned digit = value % base;
+            *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+            value /= base;
+        } while (value > 0);
+        return std::string(p);
+    }
+
+    static std::string formatInteger(long long value, unsigned char base) {
+        if (value < 0 && base == 10) {
+            return "-" + formatUnsigned(0ULL - (unsigned long long)value, base);
+        }
+        return formatUnsigned((unsigned long long)value, base);
+    }
+
+    static std::string formatDouble(double value, unsigned int decimals) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        return std::string(buffer);
+    }
+};
+
+// ArduinoJson's String support names this type; concatenation returns plain Strings here
+class StringSumHelper : public String {
+public:
+    using String::String;
+};
+
+// Concatenation, as StringSumHelper allows on the device
+template <typename T>
+inline String operator+(const String& a, const T& b) { String result(a); result += b; return result; }
+inline String operator+(const char* a, const String& b) { String result(a); result += b; return result; }
+inline String operator+(char a, const String& b) { String result(a); result += b; return result; }
+
+/**
+ * @class Print
+ * @brief Byte sink with the print helpers the pipeline uses
+ */
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t written = 0;
+        while (size-- > 0 && write(*buffer++) == 1) {
+            written++;
+        }
+        return written;
+    }
+    size_t write(const char* text) { return text ? write(reinterpret_cast<const uint8_t*>(text), strlen(text)) : 0; }
+    virtual void flush() {}
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned int value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+/**
+ * @class Stream
+ * @brief Readable byte source with a timeout, as ArduinoJson and the HTTP body readers use it
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    /**
+     * @brief Read up to length bytes, waiting up to the timeout for each
+     * @return Number of bytes read; fewer than asked means the stream ended or timed out
+     */
+    virtual size_t readBytes(char* buffer, size_t length) {
+        size_t count = 0;
+        while (count < length) {
+            int c = timedRead();
+            if (c < 0) {
+                break;
+            }
+            buffer[count++] = (char)c;
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+
+    String readString() {
+        String text;
+        int c;
+        while ((c = timedRead()) >= 0) {
+            text += (char)c;
+        }
+        return text;
+    }
+
+protected:
+    unsigned long _timeout = 1000;
+
+    int timedRead() {
+        unsigned long start = millis();
+        do {
+            int c = read();
+            if (c >= 0) {
+                return c;
+            }
+            yield();
+        } while (millis() - start < _timeout);
+        return -1;
+    }
+};
+
+/**
+ * @class HardwareSerial
+ * @brief Serial port that writes to stdout
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    void flush() override { fflush(stdout); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @class EspClass
+ * @brief Memory figures of the board the firmware ships on (ESP32-S3, 2MB PSRAM)
+ *
+ * The host heap isn't limited by these; they only let budget checks such
+ * as PostHogClient's PSRAM headroom take the same branches as on the device.
+ */
+class EspClass {
+public:
+    uint32_t getHeapSize() { return 320 * 1024; }
+    uint32_t getFreeHeap() { return 200 * 1024; }
+    uint32_t getMaxAllocHeap() { return 110 * 1024; }
+    uint32_t getPsramSize() { return 2 * 1024 * 1024; }
+    uint32_t getFreePsram() { return 2 * 1024 * 1024 - 64 * 1024; }
+    uint32_t getMaxAllocPsram() { return 2 * 1024 * 1024 - 96 * 1024; }
+};
+
+extern EspClass ESP;
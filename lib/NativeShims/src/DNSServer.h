@@ -0,0 +1,17 @@
+#pragma once
+
+// Captive-portal DNS server, named by WifiInterface.h. The host never runs the portal.
+
+#include <WiFi.h>
+
+class DNSServer {
+public:
+    bool start(uint16_t port, const String& domain, const IPAddress& resolved_ip) {
+        (void)port;
+        (void)domain;
+        (void)resolved_ip;
+        return false;
+    }
+    void stop() {}
+    void processNextRequest() {}
+};
@@ -0,0 +1,197 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Wait until ready() holds, or give up after ticks (portMAX_DELAY waits forever)
+template <typename Predicate>
+static bool waitFor(std::condition_variable& changed, std::unique_lock<std::mutex>& lock,
+                    TickType_t ticks, Predicate ready) {
+    if (ticks == portMAX_DELAY) {
+        changed.wait(lock, ready);
+        return true;
+    }
+    return changed.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+// Tasks
+
+struct TaskDefinition {
+    std::string name;
+    BaseType_t core;
+    std::mutex lock;
+    std::condition_variable finished_changed;
+    bool finished = false;
+};
+
+// Thrown by vTaskDelete(NULL) to unwind the calling task back to its thread entry
+struct TaskDeleted {};
+
+static thread_local TaskDefinition* currentTask = nullptr;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth,
+                                   void* parameters, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core_id) {
+    (void)stack_depth;
+    (void)priority;
+
+    // Never freed, so a handle stays safe to pass to vTaskDelete after its task has ended
+    TaskDefinition* task = new TaskDefinition();
+    task->name = name ? name : "";
+    task->core = core_id == tskNO_AFFINITY ? 1 : core_id;
+
+    try {
+        std::thread([task, code, parameters]() {
+            currentTask = task;
+            try {
+                code(parameters);
+            } catch (const TaskDeleted&) {
+            }
+            std::lock_guard<std::mutex> guard(task->lock);
+            task->finished = true;
+            task->finished_changed.notify_all();
+        }).detach();
+    } catch (const std::system_error&) {
+        delete task;
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+
+    if (created) {
+        *created = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stack_depth,
+                       void* parameters, UBaseType_t priority, TaskHandle_t* created) {
+    return xTaskCreatePinnedToCore(code, name, stack_depth, parameters, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == currentTask) {
+        throw TaskDeleted();
+    }
+
+    std::unique_lock<std::mutex> lock(task->lock);
+    if (!task->finished_changed.wait_for(lock, std::chrono::seconds(1), [task] { return task->finished; })) {
+        fprintf(stderr, "vTaskDelete: task %s is still running and was left to run\n", task->name.c_str());
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+BaseType_t xPortGetCoreID() {
+    return currentTask ? currentTask->core : 1;
+}
+
+// Queues
+
+struct QueueDefinition {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    if (length == 0) {
+        return nullptr;
+    }
+    QueueDefinition* queue = new QueueDefinition();
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+static BaseType_t queueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait, bool to_front) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->changed, lock, ticks_to_wait,
+                 [queue] { return queue->items.size() < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    std::vector<uint8_t> copy(bytes, bytes + queue->item_size);
+    if (to_front) {
+        queue->items.push_front(std::move(copy));
+    } else {
+        queue->items.push_back(std::move(copy));
+    }
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    return queueSend(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    return queueSend(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->changed, lock, ticks_to_wait, [queue] { return !queue->items.empty(); })) {
+        return errQUEUE_EMPTY;
+    }
+
+    memcpy(buffer, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return (UBaseType_t)queue->items.size();
+}
+
+// Mutexes
+
+struct SemaphoreDefinition {
+    std::timed_mutex mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new SemaphoreDefinition();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    if (ticks_to_wait == portMAX_DELAY) {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+    return semaphore->mutex.try_lock_for(std::chrono::milliseconds(ticks_to_wait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
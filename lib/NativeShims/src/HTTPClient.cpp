@@ -0,0 +1,241 @@
+#include "HTTPClient.h"
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+    _client = &client;
+    _headers = "";
+    _size = -1;
+    _returnCode = 0;
+
+    int scheme_end = url.indexOf("://");
+    if (scheme_end < 0) {
+        return false;
+    }
+    String scheme = url.substring(0, scheme_end);
+    if (scheme == "https") {
+        _port = 443;
+    } else if (scheme == "http") {
+        _port = 80;
+    } else {
+        return false;
+    }
+
+    String rest = url.substring(scheme_end + 3);
+    int path_start = rest.indexOf('/');
+    String authority = path_start < 0 ? rest : rest.substring(0, path_start);
+    _uri = path_start < 0 ? String("/") : rest.substring(path_start);
+
+    int colon = authority.indexOf(':');
+    if (colon >= 0) {
+        _port = (uint16_t)authority.substring(colon + 1).toInt();
+        authority = authority.substring(0, colon);
+    }
+    _host = authority;
+    return _host.length() > 0;
+}
+
+void HTTPClient::end() {
+    if (_client && _client->connected() && !(_reuse && _canReuse)) {
+        _client->stop();
+    }
+    _headers = "";
+    _size = -1;
+    _returnCode = 0;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    _headers += name;
+    _headers += ": ";
+    _headers += value;
+    _headers += "\r\n";
+}
+
+void HTTPClient::collectHeaders(const char* header_keys[], const size_t count) {
+    _collected.clear();
+    for (size_t i = 0; i < count; i++) {
+        _collected.push_back({String(header_keys[i]), String()});
+    }
+}
+
+String HTTPClient::header(const char* name) {
+    for (const Header& collected : _collected) {
+        if (collected.key.equalsIgnoreCase(name)) {
+            return collected.value;
+        }
+    }
+    return String();
+}
+
+bool HTTPClient::hasHeader(const char* name) {
+    return header(name).length() > 0;
+}
+
+int HTTPClient::GET() {
+    return sendRequest("GET");
+}
+
+int HTTPClient::POST(const String& payload) {
+    return sendRequest("POST", reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length());
+}
+
+int HTTPClient::POST(uint8_t* payload, size_t size) {
+    return sendRequest("POST", payload, size);
+}
+
+int HTTPClient::sendRequest(const char* type, const uint8_t* payload, size_t size) {
+    if (!_client) {
+        return HTTPC_ERROR_NOT_CONNECTED;
+    }
+
+    if (_client->connected()) {
+        // Anything left of the previous response would be read as this one
+        while (_client->available() > 0) {
+            _client->read();
+        }
+    } else if (!_client->connect(_host.c_str(), _port)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    String request = type;
+    request += " ";
+    request += _uri;
+    request += " HTTP/1.1\r\nHost: ";
+    request += _host;
+    if (_port != 80 && _port != 443) {
+        request += ":";
+        request += String((unsigned int)_port);
+    }
+    request += "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: ";
+    request += _reuse ? "keep-alive" : "close";
+    request += "\r\n";
+    if (payload || strcmp(type, "POST") == 0) {
+        request += "Content-Length: ";
+        request += String((unsigned int)size);
+        request += "\r\n";
+    }
+    request += _headers;
+    request += "\r\n";
+    if (payload && size > 0) {
+        request.concat(reinterpret_cast<const char*>(payload), size);
+    }
+
+    // One write, so the request leaves in as few segments as possible
+    if (_client->write(reinterpret_cast<const uint8_t*>(request.c_str()), request.length()) != request.length()) {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    return handleHeaderResponse();
+}
+
+int HTTPClient::handleHeaderResponse() {
+    for (Header& collected : _collected) {
+        collected.value = "";
+    }
+    _size = -1;
+    _canReuse = _reuse;
+
+    unsigned long start = millis();
+    String line;
+    if (!readLine(line, start)) {
+        return _client->connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+    }
+    // "HTTP/1.1 200 OK"
+    if (!line.startsWith("HTTP/1.") || line.length() < 12) {
+        return HTTPC_ERROR_NO_HTTP_SERVER;
+    }
+    if (line[7] == '0') {
+        _canReuse = false;
+    }
+    _returnCode = (int)line.substring(9, 12).toInt();
+
+    while (true) {
+        if (!readLine(line, start)) {
+            return _client->connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+        }
+        if (line.length() == 0) {
+            break;
+        }
+        int colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+
+        if (name.equalsIgnoreCase("Content-Length")) {
+            _size = (int)value.toInt();
+        } else if (name.equalsIgnoreCase("Connection")) {
+            String lower = value;
+            lower.toLowerCase();
+            if (lower.indexOf("close") >= 0) {
+                _canReuse = false;
+            }
+        }
+        for (Header& collected : _collected) {
+            if (collected.key.equalsIgnoreCase(name)) {
+                if (collected.value.length() > 0) {
+                    collected.value += ",";
+                }
+                collected.value += value;
+            }
+        }
+    }
+
+    return _returnCode > 0 ? _returnCode : HTTPC_ERROR_NO_HTTP_SERVER;
+}
+
+bool HTTPClient::readLine(String& line, unsigned long start) {
+    line = "";
+    char c;
+    while (millis() - start < _tcpTimeout) {
+        if (_client->readBytes(&c, 1) != 1) {
+            if (!_client->connected()) {
+                return false;
+            }
+            continue;
+        }
+        if (c == '\n') {
+            line.trim();
+            return true;
+        }
+        line += c;
+    }
+    return false;
+}
+
+String HTTPClient::getString() {
+    if (!_client) {
+        return String();
+    }
+    String body;
+    char buffer[512];
+    int remaining = _size;
+    while (remaining != 0) {
+        size_t want = remaining < 0 ? sizeof(buffer) : std::min(sizeof(buffer), (size_t)remaining);
+        size_t got = _client->readBytes(buffer, want);
+        if (got == 0) {
+            break;
+        }
+        body.concat(buffer, got);
+        if (remaining > 0) {
+            remaining -= got;
+        }
+    }
+    return body;
+}
+
+String HTTPClient::errorToString(int error) {
+    switch (error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+        case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+        case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+        case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+        case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+        case HTTPC_ERROR_NO_STREAM: return "no stream";
+        case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+        case HTTPC_ERROR_TOO_LESS_RAM: return "too less ram";
+        case HTTPC_ERROR_ENCODING: return "Transfer-Encoding not supported";
+        case HTTPC_ERROR_STREAM_WRITE: return "Stream write error";
+        case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+        default: return String();
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+// Host stand-in for the ESP32 HTTPClient: HTTP/1.1 requests over a
+// caller-supplied WiFiClient, with keep-alive and collected response headers.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT (5000)
+
+typedef enum {
+    HTTP_CODE_CONTINUE = 100,
+    HTTP_CODE_OK = 200,
+    HTTP_CODE_CREATED = 201,
+    HTTP_CODE_ACCEPTED = 202,
+    HTTP_CODE_NO_CONTENT = 204,
+    HTTP_CODE_PARTIAL_CONTENT = 206,
+    HTTP_CODE_MOVED_PERMANENTLY = 301,
+    HTTP_CODE_FOUND = 302,
+    HTTP_CODE_SEE_OTHER = 303,
+    HTTP_CODE_NOT_MODIFIED = 304,
+    HTTP_CODE_TEMPORARY_REDIRECT = 307,
+    HTTP_CODE_PERMANENT_REDIRECT = 308,
+    HTTP_CODE_BAD_REQUEST = 400,
+    HTTP_CODE_UNAUTHORIZED = 401,
+    HTTP_CODE_FORBIDDEN = 403,
+    HTTP_CODE_NOT_FOUND = 404,
+    HTTP_CODE_METHOD_NOT_ALLOWED = 405,
+    HTTP_CODE_REQUEST_TIMEOUT = 408,
+    HTTP_CODE_TOO_MANY_REQUESTS = 429,
+    HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+    HTTP_CODE_BAD_GATEWAY = 502,
+    HTTP_CODE_SERVICE_UNAVAILABLE = 503,
+    HTTP_CODE_GATEWAY_TIMEOUT = 504
+} t_http_codes;
+
+/**
+ * @class HTTPClient
+ * @brief HTTP/1.1 client over a WiFiClient the caller owns
+ *
+ * Uses the client's connection if it's already open, otherwise connects to
+ * the URL's host. Only the response headers are read; the body is left on
+ * the stream for the caller (or getString(), which doesn't decode chunked
+ * bodies).
+ */
+class HTTPClient {
+public:
+    HTTPClient() {}
+    ~HTTPClient() { end(); }
+
+    /**
+     * @brief Point the next request at a URL
+     * @return false if the URL isn't http:// or https://
+     */
+    bool begin(WiFiClient& client, const String& url);
+
+    /**
+     * @brief Finish the request, keeping the connection if both sides allow it
+     */
+    void end();
+
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void setTimeout(uint16_t timeout) { _tcpTimeout = timeout; }
+
+    void addHeader(const String& name, const String& value);
+    void collectHeaders(const char* header_keys[], const size_t count);
+    String header(const char* name);
+    bool hasHeader(const char* name);
+
+    int GET();
+    int POST(const String& payload);
+    int POST(uint8_t* payload, size_t size);
+
+    /**
+     * @brief Send a request and read the response headers
+     * @return HTTP status, or a negative HTTPC_ERROR_* code
+     */
+    int sendRequest(const char* type, const uint8_t* payload = nullptr, size_t size = 0);
+
+    // Content-Length of the response, -1 if not given (chunked or read to close)
+    int getSize() { return _size; }
+    WiFiClient& getStream() { return *_client; }
+    WiFiClient* getStreamPtr() { return _client; }
+    String getString();
+    bool connected() { return _client && _client->connected(); }
+
+    static String errorToString(int error);
+
+private:
+    struct Header {
+        String key;
+        String value;
+    };
+
+    WiFiClient* _client = nullptr;
+    String _host;
+    uint16_t _port = 0;
+    String _uri;
+    String _headers;                  // Added request headers, each ending in CRLF
+    std::vector<Header> _collected;   // Response headers asked for by collectHeaders()
+    bool _reuse = true;
+    bool _canReuse = false;
+    uint16_t _tcpTimeout = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
+    int _size = -1;
+    int _returnCode = 0;
+
+    int handleHeaderResponse();
+    bool readLine(String& line, unsigned long start);
+};
@@ -0,0 +1,173 @@
+#include "Preferences.h"
+#include <map>
+#include <mutex>
+
+// Matches the nvs partition in partitions.csv: 6 pages of 126 entries, one page kept free
+static const size_t NVS_PARTITION_SIZE = 0x6000;
+static const size_t NVS_PAGE_SIZE = 4096;
+static const size_t NVS_ENTRIES_PER_PAGE = 126;
+static const size_t NVS_ENTRY_SIZE = 32;
+static const size_t NVS_KEY_MAX_LENGTH = 15;
+
+typedef std::map<std::string, std::map<std::string, std::string>> Storage;
+
+static Storage& storage() {
+    static Storage namespaces;
+    return namespaces;
+}
+
+static std::mutex storageLock;
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition_label) {
+    (void)partition_label;
+    if (_started || !name || strlen(name) > NVS_KEY_MAX_LENGTH) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (readOnly && storage().find(name) == storage().end()) {
+        // NVS can't open a namespace read-only before anything was written to it
+        return false;
+    }
+    storage()[name];
+    _namespace = name;
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    storage()[_namespace].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_started || _readOnly || !key) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    return storage()[_namespace].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    std::string value;
+    return get(key, value);
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t length) {
+    if (!_started || _readOnly || !key || strlen(key) > NVS_KEY_MAX_LENGTH) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    storage()[_namespace][key] = std::string(static_cast<const char*>(value), length);
+    return length;
+}
+
+bool Preferences::get(const char* key, std::string& value) {
+    if (!_started || !key) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    const std::map<std::string, std::string>& entries = storage()[_namespace];
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return false;
+    }
+    value = found->second;
+    return true;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    uint8_t byte = value ? 1 : 0;
+    return put(key, &byte, sizeof(byte));
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    if (!value) {
+        return 0;
+    }
+    return put(key, value, strlen(value));
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!value || length == 0) {
+        return 0;
+    }
+    return put(key, value, length);
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    std::string value;
+    return get(key, value) && value.size() == 1 ? value[0] != 0 : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    std::string value;
+    int32_t result = defaultValue;
+    if (get(key, value) && value.size() == sizeof(result)) {
+        memcpy(&result, value.data(), sizeof(result));
+    }
+    return result;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    std::string value;
+    uint32_t result = defaultValue;
+    if (get(key, value) && value.size() == sizeof(result)) {
+        memcpy(&result, value.data(), sizeof(result));
+    }
+    return result;
+}
+
+String Preferences::getString(const char* key, String defaultValue) {
+    std::string value;
+    return get(key, value) ? String(value) : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    std::string value;
+    return get(key, value) ? value.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    std::string value;
+    if (!buffer || !get(key, value) || value.size() > maxLength) {
+        return 0;
+    }
+    memcpy(buffer, value.data(), value.size());
+    return value.size();
+}
+
+size_t Preferences::freeEntries() {
+    size_t total = (NVS_PARTITION_SIZE / NVS_PAGE_SIZE - 1) * NVS_ENTRIES_PER_PAGE;
+    size_t used = 0;
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (const auto& entries : storage()) {
+        for (const auto& entry : entries.second) {
+            // Integers fit in their key's entry; strings and blobs add one per 32 bytes of data
+            size_t length = entry.second.size();
+            used += length <= 8 ? 1 : 1 + (length + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+        }
+    }
+    return used < total ? total - used : 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @class Preferences
+ * @brief NVS key-value store, held in memory for the life of the process
+ *
+ * Instances that open the same namespace share its entries, as on the
+ * device; nothing survives a restart. Keys longer than 15 characters are
+ * refused like NVS refuses them, and freeEntries() counts 32-byte entries
+ * against the size of the firmware's nvs partition.
+ */
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partition_label = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBool(const char* key, bool value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+
+    bool getBool(const char* key, bool defaultValue = false);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    String getString(const char* key, String defaultValue = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+
+    size_t freeEntries();
+
+private:
+    std::string _namespace;
+    bool _started = false;
+    bool _readOnly = false;
+
+    size_t put(const char* key, const void* value, size_t length);
+    bool get(const char* key, std::string& value);
+};
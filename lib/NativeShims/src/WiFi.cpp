@@ -0,0 +1,228 @@
+#include "WiFi.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+WiFiClass WiFi;
+
+struct WiFiClient::Socket {
+    int fd = -1;
+    bool closed = false;
+    uint8_t buffer[1460];
+    size_t position = 0;
+    size_t length = 0;
+
+    size_t buffered() const { return length - position; }
+
+    ~Socket() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+WiFiClient::WiFiClient() {}
+
+WiFiClient::~WiFiClient() {}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, CONNECT_TIMEOUT_MS);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeout_ms) {
+    stop();
+
+    std::shared_ptr<Socket> socket = std::make_shared<Socket>();
+    socket->fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (socket->fd < 0) {
+        return 0;
+    }
+
+    // Requests go out in one write; don't hold it back waiting for an ACK
+    int enable = 1;
+    setsockopt(socket->fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = (uint32_t)ip;
+
+    // Connect without blocking so the timeout applies, then go back to blocking writes
+    int flags = fcntl(socket->fd, F_GETFL, 0);
+    fcntl(socket->fd, F_SETFL, flags | O_NONBLOCK);
+    int result = ::connect(socket->fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    if (result < 0 && errno == EINPROGRESS) {
+        pollfd waiting = {socket->fd, POLLOUT, 0};
+        if (poll(&waiting, 1, timeout_ms) == 1) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(socket->fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            result = error == 0 ? 0 : -1;
+        }
+    }
+    if (result < 0) {
+        return 0;
+    }
+    fcntl(socket->fd, F_SETFL, flags);
+
+    _socket = socket;
+    return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, CONNECT_TIMEOUT_MS);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeout_ms) {
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) {
+        return 0;
+    }
+    return connect(ip, port, timeout_ms);
+}
+
+size_t WiFiClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (!_socket || _socket->closed) {
+        return 0;
+    }
+    size_t written = 0;
+    while (written < size) {
+        ssize_t sent = send(_socket->fd, buffer + written, size - written, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            _socket->closed = true;
+            break;
+        }
+        written += sent;
+    }
+    return written;
+}
+
+int WiFiClient::fill(int timeout_ms) {
+    if (!_socket || _socket->closed) {
+        return -1;
+    }
+
+    pollfd waiting = {_socket->fd, POLLIN, 0};
+    int ready = poll(&waiting, 1, timeout_ms);
+    if (ready == 0 || (ready < 0 && errno == EINTR)) {
+        return 0;
+    }
+
+    ssize_t received = ready < 0 ? -1 : recv(_socket->fd, _socket->buffer, sizeof(_socket->buffer), MSG_DONTWAIT);
+    if (received > 0) {
+        _socket->position = 0;
+        _socket->length = received;
+        return 1;
+    }
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    // Peer closed the connection, or it failed
+    _socket->closed = true;
+    return -1;
+}
+
+int WiFiClient::available() {
+    if (!_socket) {
+        return 0;
+    }
+    if (_socket->buffered() == 0) {
+        fill(0);
+    }
+    return (int)_socket->buffered();
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (available() <= 0) {
+        return -1;
+    }
+    size_t count = std::min(size, _socket->buffered());
+    memcpy(buffer, _socket->buffer + _socket->position, count);
+    _socket->position += count;
+    return (int)count;
+}
+
+int WiFiClient::peek() {
+    if (available() <= 0) {
+        return -1;
+    }
+    return _socket->buffer[_socket->position];
+}
+
+size_t WiFiClient::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    unsigned long start = millis();
+    while (count < length && _socket) {
+        if (_socket->buffered() > 0) {
+            size_t chunk = std::min(length - count, _socket->buffered());
+            memcpy(buffer + count, _socket->buffer + _socket->position, chunk);
+            _socket->position += chunk;
+            count += chunk;
+            continue;
+        }
+
+        unsigned long elapsed = millis() - start;
+        if (elapsed >= _timeout || fill((int)(_timeout - elapsed)) < 0) {
+            break;
+        }
+    }
+    return count;
+}
+
+void WiFiClient::stop() {
+    _socket.reset();
+}
+
+uint8_t WiFiClient::connected() {
+    if (!_socket) {
+        return 0;
+    }
+    if (_socket->buffered() > 0) {
+        return 1;
+    }
+    if (_socket->closed) {
+        return 0;
+    }
+
+    uint8_t c;
+    ssize_t received = recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (received > 0 || (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))) {
+        return 1;
+    }
+    _socket->closed = true;
+    return 0;
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (!host || getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) {
+        return 0;
+    }
+    result = IPAddress((uint32_t)reinterpret_cast<sockaddr_in*>(found->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(found);
+    return 1;
+}
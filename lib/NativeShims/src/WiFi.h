@@ -0,0 +1,113 @@
+#pragma once
+
+// Host stand-in for the ESP32 WiFi library: the host's network is always up,
+// and WiFiClient is a plain TCP socket.
+
+#include <Arduino.h>
+#include <memory>
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+// Only named by event handler signatures in the firmware
+typedef int WiFiEvent_t;
+
+/**
+ * @class IPAddress
+ * @brief IPv4 address, stored in network byte order
+ */
+class IPAddress {
+public:
+    IPAddress() : _bytes{0, 0, 0, 0} {}
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+        : _bytes{first, second, third, fourth} {}
+    IPAddress(uint32_t address) { memcpy(_bytes, &address, sizeof(_bytes)); }
+
+    operator uint32_t() const {
+        uint32_t address;
+        memcpy(&address, _bytes, sizeof(address));
+        return address;
+    }
+    uint8_t operator[](int index) const { return _bytes[index]; }
+    uint8_t& operator[](int index) { return _bytes[index]; }
+    bool operator==(const IPAddress& other) const { return memcmp(_bytes, other._bytes, sizeof(_bytes)) == 0; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+        return String(text);
+    }
+
+private:
+    uint8_t _bytes[4];
+};
+
+/**
+ * @class WiFiClient
+ * @brief TCP client over a POSIX socket
+ *
+ * Copies share the socket, which closes when the last of them stops. Reads
+ * never block except readBytes(), which waits up to the stream timeout.
+ */
+class WiFiClient : public Stream {
+public:
+    WiFiClient();
+    ~WiFiClient() override;
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int32_t timeout_ms);
+    int connect(const char* host, uint16_t port);
+    int connect(const char* host, uint16_t port, int32_t timeout_ms);
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size);
+    int peek() override;
+    using Stream::readBytes;
+    size_t readBytes(char* buffer, size_t length) override;
+
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+
+protected:
+    struct Socket;
+    std::shared_ptr<Socket> _socket;
+
+private:
+    static const int32_t CONNECT_TIMEOUT_MS = 3000;
+
+    // Wait up to timeout_ms for more bytes: 1 if some arrived, 0 if not yet, -1 if the socket closed
+    int fill(int timeout_ms);
+};
+
+/**
+ * @class WiFiClass
+ * @brief Station status and name lookup
+ */
+class WiFiClass {
+public:
+    wl_status_t status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+
+    /**
+     * @brief Resolve a host name to its first IPv4 address
+     * @return 1 on success, 0 if the name didn't resolve
+     */
+    int hostByName(const char* host, IPAddress& result);
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for WiFiClientSecure. There is no TLS off-device: connections
+// are plain TCP (the mock server runs with --plain-http), and sslclient stays
+// empty, so there is never a session to save or offer.
+
+#include <WiFi.h>
+#include <mbedtls/ssl.h>
+
+struct sslclient_context {
+    mbedtls_ssl_context ssl_ctx;
+};
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    using WiFiClient::connect;
+    int connect(IPAddress ip, uint16_t port, const char* host, const char* root_ca,
+                const char* client_cert, const char* client_key) {
+        (void)host;
+        (void)root_ca;
+        (void)client_cert;
+        (void)client_key;
+        return WiFiClient::connect(ip, port);
+    }
+
+    void setInsecure() {}
+    void setCACert(const char* root_ca) { (void)root_ca; }
+
+protected:
+    std::shared_ptr<sslclient_context> sslclient;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+// Capability-based allocation on the host, where there is a single heap:
+// capabilities are accepted and ignored.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+inline void* heap_caps_realloc(void* pointer, size_t size, uint32_t caps) {
+    (void)caps;
+    return realloc(pointer, size);
+}
+
+inline void heap_caps_free(void* pointer) {
+    free(pointer);
+}
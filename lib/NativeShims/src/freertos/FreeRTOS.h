@@ -0,0 +1,34 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS kernel API the firmware uses: tasks run on
+// threads, queues and mutexes on the standard library. A tick is one
+// millisecond, as configured on the device.
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define errQUEUE_EMPTY ((BaseType_t)0)
+#define errQUEUE_FULL ((BaseType_t)0)
+#define errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY ((BaseType_t)-1)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+
+/**
+ * @brief Core the calling task is pinned to
+ * @return The core given to xTaskCreatePinnedToCore, or 1 (the Arduino loop's
+ *         core) for unpinned tasks and threads the shim didn't start
+ */
+BaseType_t xPortGetCoreID();
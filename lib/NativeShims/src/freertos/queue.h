@@ -0,0 +1,22 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+struct QueueDefinition;
+typedef QueueDefinition* QueueHandle_t;
+
+/**
+ * @brief Bounded queue of fixed-size items, copied in and out as on the device
+ * @return NULL if length is 0
+ */
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait) {
+    return xQueueSendToBack(queue, item, ticks_to_wait);
+}
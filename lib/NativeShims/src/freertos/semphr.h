@@ -0,0 +1,19 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+struct SemaphoreDefinition;
+typedef SemaphoreDefinition* SemaphoreHandle_t;
+
+/**
+ * @brief Mutex for xSemaphoreTake/xSemaphoreGive
+ *
+ * Not recursive, and only the task holding it may give it, as with a
+ * FreeRTOS mutex.
+ */
+SemaphoreHandle_t xSemaphoreCreateMutex();
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
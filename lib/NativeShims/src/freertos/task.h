@@ -0,0 +1,32 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+struct TaskDefinition;
+typedef TaskDefinition* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+/**
+ * @brief Start a task on its own thread
+ *
+ * Stack depth and priority are accepted and ignored; the host scheduler
+ * runs every task whenever it's ready.
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stack_depth,
+                                   void* parameters, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core_id);
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stack_depth,
+                       void* parameters, UBaseType_t priority, TaskHandle_t* created);
+
+/**
+ * @brief Delete a task
+ *
+ * With NULL (or the caller's own handle) the calling task ends there. A
+ * thread can't be stopped from outside, so deleting another task waits up
+ * to a second for it to return on its own, as it does once its owner has
+ * cleared the flag its loop checks.
+ */
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
@@ -0,0 +1,38 @@
+#pragma once
+
+// The mbedTLS session API as ConnectionManager names it. The host has no TLS
+// layer, so sessions stay empty and can't be exported or installed.
+
+#include <stddef.h>
+#include <string.h>
+
+#define MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE -0x7080
+
+typedef struct mbedtls_ssl_session {
+    size_t id_len;
+    unsigned char id[32];
+} mbedtls_ssl_session;
+
+typedef struct mbedtls_ssl_context {
+    int unused;
+} mbedtls_ssl_context;
+
+inline void mbedtls_ssl_session_init(mbedtls_ssl_session* session) {
+    memset(session, 0, sizeof(*session));
+}
+
+inline void mbedtls_ssl_session_free(mbedtls_ssl_session* session) {
+    memset(session, 0, sizeof(*session));
+}
+
+inline int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+    (void)ssl;
+    (void)session;
+    return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+}
+
+inline int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+    (void)ssl;
+    (void)session;
+    return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+}
@@ -0,0 +1,394 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the PostHog API, for measuring and debugging the device's fetch pipeline.
+
+Replays recorded responses for the endpoints PostHogClient uses:
+  GET  /api/projects/<team>/insights/?short_id=<id>   -> recordings/insights/<id>.json
+  POST /api/projects/<team>/query/                    -> recordings/queries/<hash>.json
+  GET  /api/projects/<team>/query/<query id>/         -> status of an async query
+
+A query with no recording of its own is answered from the insight recording whose
+query source it is, the way the device refreshes an insight it already holds: the
+results alone, and only the newest buckets for a series tail (date_from narrowed).
+
+Latency, response size and failures can be injected, so retries, the circuit breaker,
+the rate limiter and slow-network behaviour can be reproduced on the desk. The host
+pipeline test (test/test_fetch_pipeline) runs against it with test/recordings. Point the
+firmware at it with the POSTHOG_API_HOST and POSTHOG_API_PORT build flags.
+
+Record real responses first (the API key is passed through, never written to disk):
+  python3 mock_posthog.py --record https://us.posthog.com
+
+Then replay them:
+  python3 mock_posthog.py --latency 300 --jitter 200 --error-rate 0.1 --throttle-rate 0.05
+
+Counters are served at GET /_mock/stats and printed on exit.
+"""
+import argparse
+import gzip
+import hashlib
+import json
+import os
+import random
+import ssl
+import subprocess
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+import uuid
+from datetime import datetime, timedelta, timezone
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlsplit
+
+args = None
+stats_lock = threading.Lock()
+stats = {"requests": 0, "replayed": 0, "recorded": 0, "missing": 0, "errors": 0,
+         "results_only": 0, "throttled": 0, "dropped": 0, "bytes_sent": 0, "latency_ms_total": 0}
+async_queries = {}  # query id -> [polls left, recording path]
+warm_recordings = set()  # recordings whose async query has completed
+failures = {}  # recording path -> injected --fail-first failures so far
+
+
+def result_node(data):
+    """The object holding the result: the insight for the insights endpoint, the root for queries"""
+    results = data.get("results") if isinstance(data, dict) else None
+    if isinstance(results, list) and results and isinstance(results[0], dict):
+        return results[0]
+    return data
+
+
+def count(key, amount=1):
+    with stats_lock:
+        stats[key] += amount
+
+
+def query_hash(body):
+    """Recordings are keyed by the query itself, not the refresh mode"""
+    try:
+        query = json.loads(body).get("query")
+    except (ValueError, AttributeError):
+        query = None
+    text = json.dumps(query, sort_keys=True, separators=(",", ":"))
+    return hashlib.sha1(text.encode("utf-8")).hexdigest()[:16]
+
+
+def recording_path(kind, name):
+    safe = "".join(c for c in name if c.isalnum() or c in "-_")
+    return os.path.join(args.recordings, kind, safe + ".json")
+
+
+def iso(moment):
+    return moment.strftime("%Y-%m-%dT%H:%M:%S.%fZ")
+
+
+def refresh_freshness(node, now):
+    """Move recorded freshness timestamps to now so replays aren't treated as stale"""
+    if isinstance(node, dict):
+        if "last_refresh" in node:
+            node["last_refresh"] = iso(now)
+        if "next_allowed_client_refresh" in node:
+            node["next_allowed_client_refresh"] = iso(now + timedelta(seconds=args.min_refresh))
+        if "cache_target_age" in node:
+            node["cache_target_age"] = iso(now + timedelta(seconds=args.cache_age))
+        if result_node(node) is not node:
+            refresh_freshness(result_node(node), now)
+
+
+def without_date_from(query):
+    """The query minus its range start, so a narrowed series-tail query matches its insight"""
+    if not isinstance(query, dict):
+        return query
+    query = dict(query)
+    date_range = dict(query.get("dateRange") or {})
+    date_range.pop("date_from", None)
+    query["dateRange"] = date_range
+    return query
+
+
+def insight_for_query(query):
+    """Path and query source of the insight recording this query was taken from, or None"""
+    directory = os.path.join(args.recordings, "insights")
+    if not isinstance(query, dict) or not os.path.isdir(directory):
+        return None
+    wanted = without_date_from(query)
+    for name in sorted(os.listdir(directory)):
+        if not name.endswith(".json"):
+            continue
+        path = os.path.join(directory, name)
+        try:
+            with open(path, "r", encoding="utf-8") as f:
+                source = result_node(json.load(f)).get("query", {}).get("source")
+        except (ValueError, OSError, AttributeError):
+            continue
+        if isinstance(source, dict) and without_date_from(source) == wanted:
+            return path, source
+    return None
+
+
+def load_recording(path):
+    with open(path, "r", encoding="utf-8") as f:
+        data = json.load(f)
+    if not args.keep_freshness:
+        refresh_freshness(data, datetime.now(timezone.utc))
+    if args.pad > 0 and isinstance(data, dict):
+        # Unknown keys are dropped by the device's filter, but still cost transfer and parse time
+        data["_padding"] = " " * args.pad
+    return data
+
+
+class MockHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # Keep-alive, like the real API
+
+    def log_message(self, fmt, *fmt_args):
+        if not args.quiet:
+            sys.stderr.write("%s %s\n" % (self.log_date_time_string(), fmt % fmt_args))
+
+    def do_GET(self):
+        self.handle_request(b"")
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        self.handle_request(self.rfile.read(length) if length else b"")
+
+    def handle_request(self, body):
+        url = urlsplit(self.path)
+        parts = [p for p in url.path.split("/") if p]
+
+        if parts == ["_mock", "stats"]:
+            with stats_lock:
+                snapshot = dict(stats)
+            self.send_json(200, snapshot)
+            return
+        count("requests")
+
+        delay = max(0, args.latency + random.uniform(-args.jitter, args.jitter)) / 1000.0
+        time.sleep(delay)
+        count("latency_ms_total", int(delay * 1000))
+
+        roll = random.random()
+        if roll < args.drop_rate:
+            # Connection closed mid-request, as on a flaky network
+            count("dropped")
+            self.close_connection = True
+            self.connection.shutdown(2)
+            return
+        roll -= args.drop_rate
+        if roll < args.throttle_rate:
+            count("throttled")
+            self.send_json(429, {"type": "throttled_error", "detail": "Request was throttled."},
+                           {"Retry-After": str(args.retry_after)})
+            return
+        roll -= args.throttle_rate
+        if roll < args.error_rate:
+            count("errors")
+            self.send_json(500, {"type": "server_error", "detail": "Injected failure."})
+            return
+
+        if len(parts) >= 4 and parts[:2] == ["api", "projects"]:
+            if parts[3] == "insights" and self.command == "GET":
+                params = parse_qs(url.query)
+                short_id = params.get("short_id", [""])[0]
+                refresh = params.get("refresh", [""])[0]
+                self.serve(recording_path("insights", short_id), body, refresh)
+                return
+            if parts[3] == "query" and len(parts) == 4 and self.command == "POST":
+                try:
+                    request = json.loads(body)
+                    refresh, query = request.get("refresh"), request.get("query")
+                except (ValueError, AttributeError):
+                    refresh, query = None, None
+                path = recording_path("queries", query_hash(body))
+                insight = None if args.record or os.path.exists(path) else insight_for_query(query)
+                if insight:
+                    self.serve_results(insight[0], query, insight[1], refresh)
+                else:
+                    self.serve(path, body, refresh)
+                return
+            if parts[3] == "query" and len(parts) == 5 and self.command == "GET":
+                self.serve_query_status(parts[4])
+                return
+
+        self.send_json(404, {"type": "invalid_request", "detail": "Not found."})
+
+    def serve(self, path, body, refresh):
+        if args.record:
+            self.record(path, body)
+            return
+        if not os.path.exists(path):
+            count("missing")
+            self.send_json(404, {"type": "invalid_request", "detail": "No recording at %s" % path})
+            return
+        if self.fail_first(path):
+            return
+        self.serve_data(path, load_recording(path), refresh)
+
+    def serve_results(self, path, query, source, refresh):
+        """Answer a results-only query from the insight recording it was taken from"""
+        if self.fail_first(path):
+            return
+        insight = result_node(load_recording(path))
+        results = insight.get("result")
+        narrowed = (query.get("dateRange") or {}).get("date_from")
+        if narrowed != (source.get("dateRange") or {}).get("date_from") and isinstance(results, list):
+            # A series tail starts one interval back: the current bucket and the one before it
+            results = results[-2:]
+        data = {key: insight[key] for key in ("last_refresh", "next_allowed_client_refresh",
+                                              "cache_target_age", "is_cached") if key in insight}
+        data["results"] = results
+        count("results_only")
+        self.serve_data(path, data, refresh, results_only=True)
+
+    def fail_first(self, path):
+        """Answer with a 500 if this recording hasn't yet failed --fail-first times"""
+        with stats_lock:
+            failed = failures.get(path, 0)
+            if failed >= args.fail_first:
+                return False
+            failures[path] = failed + 1
+        count("errors")
+        self.send_json(500, {"type": "server_error", "detail": "Injected failure."})
+        return True
+
+    def serve_data(self, path, data, refresh, results_only=False):
+        with stats_lock:
+            cold = args.cold_polls > 0 and path not in warm_recordings
+        if cold:
+            # Mimic a cold server cache: no result until an async query has run
+            node = data if results_only else result_node(data)
+            node["result" if node is not data else "results"] = None
+            if refresh == "async":
+                query_id = uuid.uuid4().hex
+                with stats_lock:
+                    async_queries[query_id] = [args.cold_polls, path]
+                node["query_status"] = {"id": query_id, "complete": False, "error": False}
+        count("replayed")
+        self.send_json(200, data)
+
+    def serve_query_status(self, query_id):
+        with stats_lock:
+            entry = async_queries.get(query_id)
+            if entry:
+                entry[0] -= 1
+                if entry[0] <= 0:
+                    async_queries.pop(query_id)
+                    warm_recordings.add(entry[1])
+        if not entry:
+            self.send_json(404, {"type": "invalid_request", "detail": "Unknown query."})
+            return
+        complete = entry[0] <= 0
+        self.send_json(200, {"query_status": {"id": query_id, "complete": complete, "error": False}})
+
+    def record(self, path, body):
+        target = args.record.rstrip("/") + self.path
+        request = urllib.request.Request(target, data=body or None, method=self.command)
+        if body:
+            request.add_header("Content-Type", "application/json")
+        try:
+            with urllib.request.urlopen(request, timeout=120) as response:
+                status, payload = response.status, response.read()
+        except urllib.error.HTTPError as e:
+            status, payload = e.code, e.read()
+        except urllib.error.URLError as e:
+            count("errors")
+            self.send_json(502, {"type": "server_error", "detail": str(e.reason)})
+            return
+
+        if status == 200:
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+            with open(path, "wb") as f:
+                f.write(payload)
+            count("recorded")
+            self.log_message("recorded %s (%d bytes)", path, len(payload))
+        self.send_bytes(status, payload)
+
+    def send_json(self, status, data, headers=None):
+        self.send_bytes(status, json.dumps(data).encode("utf-8"), headers)
+
+    def send_bytes(self, status, payload, headers=None):
+        encoding = None
+        if args.gzip and "gzip" in self.headers.get("Accept-Encoding", ""):
+            payload = gzip.compress(payload)
+            encoding = "gzip"
+
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(payload)))
+        if encoding:
+            self.send_header("Content-Encoding", encoding)
+        for key, value in (headers or {}).items():
+            self.send_header(key, value)
+        self.end_headers()
+        self.wfile.write(payload)
+        count("bytes_sent", len(payload))
+
+
+def ensure_certificate(cert, key):
+    """The device doesn't verify certificates yet, so a self-signed one is enough"""
+    if os.path.exists(cert) and os.path.exists(key):
+        return
+    print("Generating self-signed certificate %s" % cert)
+    subprocess.check_call(["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes",
+                           "-keyout", key, "-out", cert, "-days", "365",
+                           "-subj", "/CN=mock-posthog"])
+
+
+def main():
+    global args
+    parser = argparse.ArgumentParser(description="Replay recorded PostHog API responses for DeskHog")
+    parser.add_argument("--port", type=int, default=8443, help="Port to listen on (default 8443)")
+    parser.add_argument("--recordings", default="recordings", help="Directory of recorded responses")
+    parser.add_argument("--record", metavar="UPSTREAM",
+                        help="Forward requests to UPSTREAM (e.g. https://us.posthog.com) and save the responses")
+    parser.add_argument("--plain-http", action="store_true",
+                        help="Serve without TLS, for driving the server from curl or scripts")
+    parser.add_argument("--cert", default="mock_posthog.crt", help="TLS certificate, created if missing")
+    parser.add_argument("--key", default="mock_posthog.key", help="TLS private key, created if missing")
+    parser.add_argument("--latency", type=float, default=0, help="Added delay per request in ms")
+    parser.add_argument("--jitter", type=float, default=0, help="Random +/- variation on the delay in ms")
+    parser.add_argument("--pad", type=int, default=0, help="Bytes of padding added to each replayed response")
+    parser.add_argument("--gzip", action="store_true", help="Compress responses when the client accepts gzip")
+    parser.add_argument("--error-rate", type=float, default=0, help="Fraction of requests answered with 500")
+    parser.add_argument("--throttle-rate", type=float, default=0, help="Fraction of requests answered with 429")
+    parser.add_argument("--retry-after", type=int, default=30, help="Retry-After seconds sent with a 429")
+    parser.add_argument("--fail-first", type=int, default=0,
+                        help="Answer the first N requests for each recording with 500, to exercise retries")
+    parser.add_argument("--drop-rate", type=float, default=0, help="Fraction of connections closed without a response")
+    parser.add_argument("--cold-polls", type=int, default=0,
+                        help="Start with a cold cache: results need an async query that completes after "
+                             "this many status polls (default 0, always warm)")
+    parser.add_argument("--min-refresh", type=int, default=60,
+                        help="Seconds until next_allowed_client_refresh in replayed responses")
+    parser.add_argument("--cache-age", type=int, default=300,
+                        help="Seconds until cache_target_age in replayed responses")
+    parser.add_argument("--keep-freshness", action="store_true", help="Replay freshness timestamps as recorded")
+    parser.add_argument("--quiet", action="store_true", help="Don't log each request")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(("0.0.0.0", args.port), MockHandler)
+    scheme = "http"
+    if not args.plain_http:
+        ensure_certificate(args.cert, args.key)
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+        scheme = "https"
+
+    mode = "recording from %s" % args.record if args.record else "replaying %s" % args.recordings
+    print("Mock PostHog listening on %s://0.0.0.0:%d, %s" % (scheme, args.port, mode))
+    started = time.time()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        elapsed = max(time.time() - started, 1e-3)
+        with stats_lock:
+            summary = dict(stats)
+        summary["requests_per_minute"] = round(summary["requests"] * 60 / elapsed, 1)
+        print(json.dumps(summary, indent=2))
+
+
+if __name__ == "__main__":
+    main()
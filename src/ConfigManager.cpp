@@ -270,6 +270,23 @@ void ConfigManager::clearApiKey() {
     SystemController::setApiState(ApiState::API_AWAITING_CONFIG);
 }
 
+String ConfigManager::getPushToken() {
+    String token = _preferences.getString(_pushTokenKey, "");
+    if (token.length() == PUSH_TOKEN_BYTES * 2) {
+        return token;
+    }
+
+    token = "";
+    for (size_t i = 0; i < PUSH_TOKEN_BYTES; i++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", (unsigned int)(esp_random() & 0xFF));
+        token += hex;
+    }
+    _preferences.putString(_pushTokenKey, token);
+    commit();
+    return token;
+}
+
 std::vector<CardConfig> ConfigManager::getCardConfigs() {
     std::vector<CardConfig> configs;
     
@@ -282,7 +299,7 @@ std::vector<CardConfig> ConfigManager::getCardConfigs() {
     String jsonString = _cardPrefs.getString("config_list", "[]");
     
     // Parse JSON
-    DynamicJsonDocument doc(2048);
+    DynamicJsonDocument doc(CARD_CONFIGS_DOC_SIZE);
     DeserializationError error = deserializeJson(doc, jsonString);
     
     if (error) {
@@ -300,6 +317,7 @@ std::vector<CardConfig> ConfigManager::getCardConfigs() {
             config.config = obj["config"].as<String>();
             config.order = obj["order"].as<int>();
             config.name = obj["name"].as<String>();
+            config.refresh = RefreshPolicy::fromJson(obj["refresh"]);
             configs.push_back(config);
         }
     }
@@ -309,7 +327,7 @@ std::vector<CardConfig> ConfigManager::getCardConfigs() {
 
 bool ConfigManager::saveCardConfigs(const std::vector<CardConfig>& configs) {
     // Create JSON document
-    DynamicJsonDocument doc(2048);
+    DynamicJsonDocument doc(CARD_CONFIGS_DOC_SIZE);
     JsonArray array = doc.to<JsonArray>();
     
     // Convert vector to JSON array
@@ -319,6 +337,7 @@ bool ConfigManager::saveCardConfigs(const std::vector<CardConfig>& configs) {
         obj["config"] = config.config;
         obj["order"] = config.order;
         obj["name"] = config.name;
+        config.refresh.toJson(obj);
     }
     
     // Serialize to string
@@ -23,6 +23,7 @@
 class ConfigManager {
 public:
     static const int NO_TEAM_ID = -1;  // Sentinel value for no team ID
+    static const size_t CARD_CONFIGS_DOC_SIZE = 4096;  // JSON document size for the card list; HogQL queries are long
 
     /**
      * @brief Default constructor
@@ -126,6 +127,12 @@ public:
      */
     void clearApiKey();
 
+    /**
+     * @brief Retrieve the token that authorizes pushes to /api/push
+     * @return The token, generated and stored on first use
+     */
+    String getPushToken();
+
     /**
      * @brief Store insight configuration
      * @param id Unique insight identifier
@@ -217,6 +224,7 @@ private:
     const char* _teamIdKey = "team_id";           ///< Key for stored team ID
     const char* _apiKeyKey = "api_key";           ///< Key for stored API key
     const char* _regionKey = "region";           ///< Key for stored region
+    const char* _pushTokenKey = "push_token";    ///< Key for the local push token
 
 
     // Storage size limits
@@ -230,6 +238,8 @@ private:
     static const size_t MAX_API_KEY_LENGTH = 64;
     /** @brief Maximum length for insight identifier */
     static const size_t MAX_INSIGHT_ID_LENGTH = 64;
+    /** @brief Random bytes in the push token, shown as twice as many hex digits */
+    static const size_t PUSH_TOKEN_BYTES = 16;
 
     // Event system
     EventQueue* _eventQueue = nullptr;  ///< Optional event queue for state notifications
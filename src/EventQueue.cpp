@@ -1,8 +1,9 @@
 #include "EventQueue.h"
 
 EventQueue::EventQueue(size_t queueSize) : isRunning(false), taskHandle(nullptr) {
-    // Create the event queue
-    eventQueue = xQueueCreate(queueSize, sizeof(Event));
+    // Create the event queue. Events own a String and a shared_ptr, so the queue
+    // carries heap-allocated Event pointers rather than byte copies of the struct.
+    eventQueue = xQueueCreate(queueSize, sizeof(Event*));
     
     // Create mutex for callback access
     callbackMutex = xSemaphoreCreateMutex();
@@ -14,6 +15,10 @@ EventQueue::~EventQueue() {
     
     // Clean up resources
     if (eventQueue) {
+        Event* pending = nullptr;
+        while (xQueueReceive(eventQueue, &pending, 0) == pdPASS) {
+            delete pending;
+        }
         vQueueDelete(eventQueue);
         eventQueue = nullptr;
     }
@@ -45,10 +50,14 @@ bool EventQueue::publishEvent(EventType eventType, const String& insightId, cons
 }
 
 bool EventQueue::publishEvent(const Event& event) {
+    // Copy the event so its members stay alive until the processing task is done with it
+    Event* queued = new Event(event);
+    
     // Add the event to the queue
-    if (xQueueSend(eventQueue, &event, 0) == pdPASS) {
+    if (xQueueSend(eventQueue, &queued, 0) == pdPASS) {
         return true;
     }
+    delete queued;
     return false;
 }
 
@@ -90,7 +99,7 @@ void EventQueue::end() {
 
 void EventQueue::eventProcessingTask(void* parameter) {
     EventQueue* self = static_cast<EventQueue*>(parameter);
-    Event event;
+    Event* event = nullptr;
     
     // Process events in a loop
     while (self->isRunning) {
@@ -99,10 +108,14 @@ void EventQueue::eventProcessingTask(void* parameter) {
             // Process the event by calling all registered callbacks
             if (xSemaphoreTake(self->callbackMutex, portMAX_DELAY) == pdTRUE) {
                 for (const auto& callback : self->eventCallbacks) {
-                    callback(event);
+                    callback(*event);
                 }
                 xSemaphoreGive(self->callbackMutex);
             }
+            
+            // Releases the event's String and parser references
+            delete event;
+            event = nullptr;
         }
         // Small delay to prevent CPU hogging
         vTaskDelay(1);
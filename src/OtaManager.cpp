@@ -5,6 +5,7 @@
 #include "esp_task_wdt.h"
 #include <WiFi.h> // For WiFi.status() and WL_CONNECTED
 #include "esp_ota_ops.h" // Needed for esp_ota_get_running_partition()
+#include "PsramAllocator.h" // PSRAM-backed JSON documents
 
 // For heap_caps_malloc and esp_ptr_external_ram, ensure correct include if not already covered by Arduino.h/ESP-IDF basics
 // #include "esp_heap_caps.h" // Already in OtaManager.h but good to be mindful
@@ -27,48 +28,6 @@
     #endif
 #endif
 
-#if OTAMANAGER_ARDUINOJSON_ENABLE_PSRAM && BOARD_HAS_PSRAM
-struct PsramAllocator {
-    // Check if PSRAM is available and initialized.
-    // This function can be called once at setup or less frequently.
-    static bool psramAvailable() {
-        return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
-    }
-
-    void* allocate(size_t size) {
-        if (psramAvailable()) {
-            // Serial.printf("PsramAllocator: Attempting to allocate %u bytes from PSRAM\n", size);
-            void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
-            // if (!p) Serial.println("PsramAllocator: heap_caps_malloc failed!");
-            return p;
-        }
-        // Serial.printf("PsramAllocator: PSRAM not available, falling back to internal RAM for %u bytes\n", size);
-        return malloc(size); // Fallback to internal RAM
-    }
-
-    void deallocate(void* pointer) {
-        if (!pointer) return;
-        if (esp_ptr_external_ram(pointer)) {
-            // Serial.println("PsramAllocator: Deallocating from PSRAM");
-            heap_caps_free(pointer);
-        } else {
-            // Serial.println("PsramAllocator: Deallocating from internal RAM");
-            free(pointer);
-        }
-    }
-
-    void* reallocate(void* ptr, size_t new_size) {
-        if (esp_ptr_external_ram(ptr)) {
-            // Serial.printf("PsramAllocator: Reallocating from PSRAM, new size %u\n", new_size);
-            return heap_caps_realloc(ptr, new_size, MALLOC_CAP_SPIRAM);
-        } else {
-            // Serial.printf("PsramAllocator: Reallocating from internal RAM, new size %u\n", new_size);
-            return realloc(ptr, new_size);
-        }
-    }
-};
-#endif
-
 // Structure to pass parameters to the update task
 struct UpdateTaskParams {
     OtaManager* otaManagerInstance;
@@ -82,7 +41,8 @@ OtaManager::OtaManager(const String& currentVersion, const String& repoOwner, co
       _repoName(repoName),
       _checkTaskHandle(NULL),
       _updateTaskHandle(NULL),
-      _timeSynced(false) { // Initialize _timeSynced
+      _timeSynced(false), // Initialize _timeSynced
+      _eventQueue(nullptr) {
     _currentStatus.status = UpdateStatus::State::IDLE;
     _currentStatus.message = "Idle";
     _currentStatus.progress = 0;
@@ -96,6 +56,10 @@ OtaManager::OtaManager(const String& currentVersion, const String& repoOwner, co
     }
 }
 
+void OtaManager::setEventQueue(EventQueue* queue) {
+    _eventQueue = queue;
+}
+
 // Public methods
 bool OtaManager::checkForUpdate() {
     if (_dataMutex) {
@@ -299,6 +263,15 @@ void OtaManager::process() {
 }
 
 // Private helper methods
+void OtaManager::_publishOtaEvent(EventType type) {
+    if (_eventQueue == nullptr) {
+        return;
+    }
+    if (!_eventQueue->publishEvent(type, "")) {
+        Serial.printf("OtaManager: Event queue full, dropped OTA event %d\n", static_cast<int>(type));
+    }
+}
+
 void OtaManager::_setUpdateStatus(UpdateStatus::State state, const String& message, int progress) {
     Serial.printf("OtaManager: [_setUpdateStatus] Entered. Requested State: %d, Msg: %s, Prog: %d\n", static_cast<int>(state), message.c_str(), progress);
 
@@ -398,7 +371,7 @@ UpdateInfo OtaManager::_parseGithubApiResponse(const String& jsonPayload) {
     // Capacity can be larger when using PSRAM, e.g., 10KB or 20KB depending on expected payload size
     // Let's try 10KB first. Max GitHub API response for releases is 30 items, but we only parse the first.
     // However, release notes can be long.
-    BasicJsonDocument<PsramAllocator> doc(10240); 
+    PsramJsonDocument doc(10240);
 #else
     Serial.println("OtaManager: Using default allocator (internal RAM) for JSON parsing.");
     DynamicJsonDocument doc(1536); // Previous reduced size for internal RAM fallback
@@ -631,6 +604,10 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
         return;
     }
     Serial.printf("OtaManager: [_updateTaskRunner] self (OtaManager instance) address: %p\n", (void*)self);
+
+    // Let the PostHog client pause and close its sockets before the download needs the memory
+    self->_publishOtaEvent(EventType::OTA_PROCESS_START);
+    vTaskDelay(pdMS_TO_TICKS(OTA_SETTLE_DELAY_MS));
     
     char* downloadUrlCStr_task = params->downloadUrl; // Keep a C-string pointer before creating String
     if (!downloadUrlCStr_task) {
@@ -638,6 +615,7 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
         self->_setUpdateStatus(UpdateStatus::State::ERROR_INTERNAL, "Task started with NULL download URL");
         // self is valid here, so we can use _setUpdateStatus if needed, though probably implies bigger issues.
         free(params); // Free the params struct itself
+        self->_publishOtaEvent(EventType::OTA_PROCESS_END);
         vTaskDelete(NULL);
         return;
     }
@@ -684,6 +662,7 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
              self->_updateTaskHandle = NULL; // Attempt to clear handle anyway
         }
         esp_task_wdt_delete(NULL);
+        self->_publishOtaEvent(EventType::OTA_PROCESS_END);
         vTaskDelete(NULL);
         return;
     }
@@ -761,6 +740,7 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
                 }
                 http.end();
                 esp_task_wdt_delete(NULL);
+                self->_publishOtaEvent(EventType::OTA_PROCESS_END);
                 vTaskDelete(NULL);
                 return; // Essential to exit the task here
             }
@@ -813,6 +793,7 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
                             http.end();
                             Serial.println("OtaManager: [_updateTaskRunner] Called http.end() after write error.");
                             esp_task_wdt_delete(NULL);
+                            self->_publishOtaEvent(EventType::OTA_PROCESS_END);
                             vTaskDelete(NULL);
                             Serial.println("OtaManager: [_updateTaskRunner] Task deleted after write error.");
                             return;
@@ -837,6 +818,7 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
                         Update.abort();
                         http.end();
                         esp_task_wdt_delete(NULL);
+                        self->_publishOtaEvent(EventType::OTA_PROCESS_END);
                         vTaskDelete(NULL);
                         return;
                     } // If c == 0, it means no data was available right now, loop will continue based on http.connected()
@@ -902,5 +884,6 @@ void OtaManager::_updateTaskRunner(void* pvParameters) {
     }
 
     esp_task_wdt_delete(NULL); // Remove current task from WDT
+    self->_publishOtaEvent(EventType::OTA_PROCESS_END);
     vTaskDelete(NULL);
 }
@@ -13,6 +13,8 @@
 // Add these includes for FreeRTOS mutex
 #include <freertos/semphr.h>
 
+#include "EventQueue.h"
+
 // Forward declarations if needed, e.g., if using WiFiClientSecure pointer
 // class WiFiClientSecure;
 
@@ -62,6 +64,13 @@ public:
      */
     OtaManager(const String& currentVersion, const String& repoOwner, const String& repoName);
 
+    /**
+     * @brief Set the event queue for OTA_PROCESS_START/OTA_PROCESS_END notifications.
+     * Published around a firmware download so other network users can step aside.
+     * @param queue Pointer to the event queue
+     */
+    void setEventQueue(EventQueue* queue);
+
     /**
      * @brief Initiates a check for firmware updates in a non-blocking manner.
      * Spawns a FreeRTOS task to perform the actual check.
@@ -156,9 +165,12 @@ private:
     TaskHandle_t _checkTaskHandle;
     TaskHandle_t _updateTaskHandle;
     bool _timeSynced = false;
+    EventQueue* _eventQueue; // Receives OTA start/end events; may be null
 
     SemaphoreHandle_t _dataMutex; // Mutex for _currentStatus and _lastCheckResult
 
+    static const uint32_t OTA_SETTLE_DELAY_MS = 1000; // Time for PostHog fetches to pause before downloading
+
     // Static task runners
     static void _checkUpdateTaskRunner(void* pvParameters);
     static void _updateTaskRunner(void* pvParameters);
@@ -168,6 +180,7 @@ private:
     String _performHttpsRequest(const char* url, const char* rootCa);
     UpdateInfo _parseGithubApiResponse(const String& jsonPayload);
     bool _ensureTimeSynced(); // Added for NTP
+    void _publishOtaEvent(EventType type); // Publish an OTA event if a queue is set
 
     // void _performUpdate(String url); // Function to run in a task
 }; 
\ No newline at end of file
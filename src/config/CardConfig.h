@@ -3,13 +3,16 @@
 #include <Arduino.h>
 #include <functional>
 #include <lvgl.h>
+#include "RefreshPolicy.h"
 
 /**
  * @brief Enum to uniquely identify each type of card available in the system
  */
 enum class CardType {
     INSIGHT,    ///< PostHog insight visualization card
-    FRIEND      ///< Walking animation/encouragement card
+    FRIEND,     ///< Walking animation/encouragement card
+    HOGQL,      ///< Single value computed by a HogQL query
+    PUSH        ///< Value or series pushed over the local network
     // New card types can be added here
 };
 
@@ -21,19 +24,20 @@ enum class CardType {
  */
 struct CardConfig {
     CardType type;      ///< The type of card (enum value)
-    String config;      ///< Configuration string (e.g., insight ID, animation speed)
+    String config;      ///< Configuration string (e.g., insight ID, HogQL query, animation speed)
     int order;          ///< Display order in the card stack
     String name;        ///< Human-readable name (e.g., "PostHog Insight", "Walking Animation")
+    RefreshPolicy refresh; ///< Refresh schedule for cards that fetch data
 
     /**
      * @brief Default constructor
      */
-    CardConfig() : type(CardType::INSIGHT), config(""), order(0), name("") {}
+    CardConfig() : type(CardType::INSIGHT), config(""), order(0), name(""), refresh() {}
     
     /**
      * @brief Constructor with parameters
      */
-    CardConfig(CardType t, const String& c, int o, const String& n) : type(t), config(c), order(o), name(n) {}
+    CardConfig(CardType t, const String& c, int o, const String& n) : type(t), config(c), order(o), name(n), refresh() {}
 };
 
 /**
@@ -77,6 +81,8 @@ inline String cardTypeToString(CardType type) {
     switch (type) {
         case CardType::INSIGHT: return "INSIGHT";
         case CardType::FRIEND: return "FRIEND";
+        case CardType::HOGQL: return "HOGQL";
+        case CardType::PUSH: return "PUSH";
         default: return "UNKNOWN";
     }
 }
@@ -89,5 +95,7 @@ inline String cardTypeToString(CardType type) {
 inline CardType stringToCardType(const String& str) {
     if (str == "INSIGHT") return CardType::INSIGHT;
     if (str == "FRIEND") return CardType::FRIEND;
+    if (str == "HOGQL") return CardType::HOGQL;
+    if (str == "PUSH") return CardType::PUSH;
     return CardType::INSIGHT; // Default fallback
 }
\ No newline at end of file
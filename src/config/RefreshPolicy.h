@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief How often a data card is refreshed
+ *
+ * Set per card in the portal and stored with the card's CardConfig as a
+ * "refresh" object, which is left out entirely when every field is at its
+ * default. The defaults keep the adaptive schedule: fast while the card is
+ * on screen, backing off while it is hidden.
+ */
+struct RefreshPolicy {
+    static const uint32_t MIN_INTERVAL_S = 10;      ///< Shortest interval a card can ask for
+    static const uint32_t MAX_INTERVAL_S = 86400;   ///< Longest interval, one day
+
+    uint32_t interval_s;    ///< Fixed refresh interval in seconds, 0 for the adaptive schedule
+    int8_t active_from;     ///< First UTC hour refreshes run in (0-23), -1 for all day
+    int8_t active_to;       ///< UTC hour refreshes stop at (0-23, exclusive), -1 for all day
+    bool on_view_only;      ///< Only refresh while the card is on screen
+
+    /**
+     * @brief Default constructor - adaptive schedule, all day, visible or not
+     */
+    RefreshPolicy() : interval_s(0), active_from(-1), active_to(-1), on_view_only(false) {}
+
+    /**
+     * @brief Check whether the policy only restricts some hours of the day
+     */
+    bool hasActiveHours() const {
+        return active_from >= 0 && active_to >= 0 && active_from != active_to;
+    }
+
+    /**
+     * @brief Check whether refreshes may run in a given hour
+     *
+     * @param utc_hour Current UTC hour, or -1 if the clock isn't set yet
+     * @return true if inside the active hours, if there are none, or if the time is unknown
+     *
+     * Hours may wrap past midnight, e.g. 22 to 6.
+     */
+    bool isActiveAt(int utc_hour) const {
+        if (!hasActiveHours() || utc_hour < 0) {
+            return true;
+        }
+        if (active_from < active_to) {
+            return utc_hour >= active_from && utc_hour < active_to;
+        }
+        return utc_hour >= active_from || utc_hour < active_to;
+    }
+
+    /**
+     * @brief Check whether every field is at its default
+     */
+    bool isDefault() const {
+        return interval_s == 0 && !hasActiveHours() && !on_view_only;
+    }
+
+    /**
+     * @brief Add this policy to a card's JSON object as "refresh"
+     *
+     * @param card Card object to add to; nothing is added for the default policy
+     */
+    void toJson(JsonObject card) const {
+        if (isDefault()) {
+            return;
+        }
+        JsonObject refresh = card.createNestedObject("refresh");
+        if (interval_s > 0) {
+            refresh["interval"] = interval_s;
+        }
+        if (hasActiveHours()) {
+            refresh["from"] = active_from;
+            refresh["to"] = active_to;
+        }
+        if (on_view_only) {
+            refresh["onView"] = true;
+        }
+    }
+
+    /**
+     * @brief Read a policy from a card's "refresh" object
+     *
+     * @param refresh The "refresh" value, which may be missing
+     * @return Policy with out-of-range values clamped or dropped
+     */
+    static RefreshPolicy fromJson(JsonVariantConst refresh) {
+        RefreshPolicy policy;
+        if (!refresh.is<JsonObjectConst>()) {
+            return policy;
+        }
+
+        uint32_t interval = refresh["interval"] | 0u;
+        if (interval > 0 && interval < MIN_INTERVAL_S) {
+            interval = MIN_INTERVAL_S;
+        } else if (interval > MAX_INTERVAL_S) {
+            interval = MAX_INTERVAL_S;
+        }
+        policy.interval_s = interval;
+
+        int from = refresh["from"] | -1;
+        int to = refresh["to"] | -1;
+        if (from >= 0 && from < 24 && to >= 0 && to < 24) {
+            policy.active_from = (int8_t)from;
+            policy.active_to = (int8_t)to;
+        }
+
+        policy.on_view_only = refresh["onView"] | false;
+        return policy;
+    }
+};
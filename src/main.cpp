@@ -269,9 +269,10 @@ void setup() {
     
     // Initialize OtaManager
     otaManager = new OtaManager(CURRENT_FIRMWARE_VERSION, "PostHog", "DeskHog");
+    otaManager->setEventQueue(eventQueue);
     
     // Initialize captive portal
-    captivePortal = new CaptivePortal(*configManager, *wifiInterface, *eventQueue, *otaManager, *cardController);
+    captivePortal = new CaptivePortal(*configManager, *wifiInterface, *eventQueue, *otaManager, *cardController, *posthogClient);
     captivePortal->begin();
     
     // Create task for WiFi operations
@@ -0,0 +1,66 @@
+#include "CircuitBreaker.h"
+
+CircuitBreaker::CircuitBreaker(uint8_t failure_threshold, unsigned long open_duration)
+    : _state(State::CLOSED)
+    , _failure_threshold(failure_threshold)
+    , _open_duration(open_duration)
+    , _consecutive_failures(0)
+    , _opened_at(0)
+    , _probe_in_flight(false) {
+}
+
+bool CircuitBreaker::allowRequest(unsigned long now) {
+    switch (_state) {
+        case State::CLOSED:
+            return true;
+
+        case State::OPEN:
+            if (now - _opened_at < _open_duration) {
+                return false;
+            }
+            Serial.println("Circuit breaker half-open, sending probe request");
+            _state = State::HALF_OPEN;
+            _probe_in_flight = true;
+            return true;
+
+        case State::HALF_OPEN:
+            // Only one probe at a time
+            if (_probe_in_flight) {
+                return false;
+            }
+            _probe_in_flight = true;
+            return true;
+    }
+    return false;
+}
+
+void CircuitBreaker::abortProbe() {
+    _probe_in_flight = false;
+}
+
+void CircuitBreaker::recordSuccess() {
+    if (_state != State::CLOSED) {
+        Serial.println("Circuit breaker closed");
+    }
+    _state = State::CLOSED;
+    _consecutive_failures = 0;
+    _probe_in_flight = false;
+}
+
+void CircuitBreaker::recordFailure(unsigned long now) {
+    _probe_in_flight = false;
+
+    if (_consecutive_failures < 255) {
+        _consecutive_failures++;
+    }
+
+    // A failed probe re-opens immediately; otherwise wait for the threshold
+    if (_state == State::HALF_OPEN || _consecutive_failures >= _failure_threshold) {
+        if (_state != State::OPEN) {
+            Serial.printf("Circuit breaker open after %u consecutive failures, pausing for %lu ms\n",
+                          _consecutive_failures, _open_duration);
+        }
+        _state = State::OPEN;
+        _opened_at = now;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @class CircuitBreaker
+ * @brief Stops traffic to a host that keeps failing
+ *
+ * Classic three-state breaker:
+ * - CLOSED: requests flow; consecutive host failures are counted
+ * - OPEN: requests are refused until the cool-down has elapsed
+ * - HALF_OPEN: a single probe request is let through; its outcome
+ *   closes the breaker again or re-opens it
+ *
+ * Only host-level failures (transport errors, 5xx) should be recorded
+ * as failures. Any response that proves the host is reachable counts
+ * as a success. Not thread-safe on its own.
+ */
+class CircuitBreaker {
+public:
+    /**
+     * @enum State
+     * @brief Breaker states
+     */
+    enum class State {
+        CLOSED,     ///< Normal operation
+        OPEN,       ///< Host considered down, requests refused
+        HALF_OPEN   ///< Cool-down elapsed, probing with one request
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param failure_threshold Consecutive failures that open the breaker
+     * @param open_duration How long the breaker stays open, in milliseconds
+     */
+    CircuitBreaker(uint8_t failure_threshold = 5, unsigned long open_duration = 30000);
+
+    /**
+     * @brief Check whether a request may be sent now
+     *
+     * @param now Current time in milliseconds
+     * @return true if the request may proceed
+     *
+     * Moves an open breaker to HALF_OPEN once the cool-down has elapsed
+     * and admits exactly one probe request.
+     */
+    bool allowRequest(unsigned long now);
+
+    /**
+     * @brief Give back an admission that was never sent
+     *
+     * Called when a request passed allowRequest() but could not be
+     * handed to a worker. Frees the HALF_OPEN probe slot so a later
+     * request can probe instead; no outcome is recorded.
+     */
+    void abortProbe();
+
+    /**
+     * @brief Record a request that reached the host
+     */
+    void recordSuccess();
+
+    /**
+     * @brief Record a host-level failure
+     * @param now Current time in milliseconds
+     */
+    void recordFailure(unsigned long now);
+
+    /**
+     * @brief Get current breaker state
+     * @return Current state
+     */
+    State getState() const { return _state; }
+
+private:
+    State _state;                    ///< Current state
+    uint8_t _failure_threshold;      ///< Failures needed to open
+    unsigned long _open_duration;    ///< Cool-down length
+    uint8_t _consecutive_failures;   ///< Failures since last success
+    unsigned long _opened_at;        ///< When the breaker last opened
+    bool _probe_in_flight;           ///< HALF_OPEN probe already admitted
+};
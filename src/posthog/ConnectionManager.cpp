@@ -0,0 +1,205 @@
+#include "ConnectionManager.h"
+
+bool ResumableSecureClient::connectPlain(IPAddress ip, uint16_t port, const char* host) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    // Defer the handshake so a saved session can be installed first
+    setPlainStart();
+#endif
+    return WiFiClientSecure::connect(ip, port, host, nullptr, nullptr, nullptr) == 1;
+}
+
+bool ResumableSecureClient::offerSession(const mbedtls_ssl_session* session) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    if (!sslclient || session == nullptr) {
+        return false;
+    }
+    return mbedtls_ssl_set_session(&sslclient->ssl_ctx, session) == 0;
+#else
+    // Older cores finish the handshake inside connect(), too late to offer a session
+    (void)session;
+    return false;
+#endif
+}
+
+bool ResumableSecureClient::handshake() {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    return startTLS() == 1;
+#else
+    return connected();
+#endif
+}
+
+bool ResumableSecureClient::saveSession(mbedtls_ssl_session* session) {
+    if (!sslclient || session == nullptr) {
+        return false;
+    }
+    return mbedtls_ssl_get_session(&sslclient->ssl_ctx, session) == 0;
+}
+
+// Copies a session's ID; its fields are private from mbedTLS 3 on
+static size_t copySessionId(const mbedtls_ssl_session& session, unsigned char* id) {
+#ifdef MBEDTLS_PRIVATE
+    size_t len = session.MBEDTLS_PRIVATE(id_len);
+    memcpy(id, session.MBEDTLS_PRIVATE(id), len);
+#else
+    size_t len = session.id_len;
+    memcpy(id, session.id, len);
+#endif
+    return len;
+}
+
+ConnectionManager::ConnectionManager()
+    : _mutex(xSemaphoreCreateMutex())
+    , _hasSession(false) {
+    mbedtls_ssl_session_init(&_session);
+}
+
+ConnectionManager::~ConnectionManager() {
+    mbedtls_ssl_session_free(&_session);
+    if (_mutex) {
+        vSemaphoreDelete(_mutex);
+        _mutex = nullptr;
+    }
+}
+
+bool ConnectionManager::connect(ResumableSecureClient& client, const String& host, uint16_t port, ConnectionTiming& timing) {
+    timing = ConnectionTiming();
+
+    // Keep-alive: the worker's socket from the previous request is still open
+    if (client.connected()) {
+        timing.reused = true;
+        return true;
+    }
+    client.stop();
+
+    IPAddress address;
+    if (!resolve(host, address, timing)) {
+        Serial.printf("DNS lookup for %s failed\n", host.c_str());
+        return false;
+    }
+
+    unsigned long start_time = millis();
+    if (!client.connectPlain(address, port, host.c_str())) {
+        Serial.printf("TCP connect to %s failed\n", host.c_str());
+        invalidate(host);
+        return false;
+    }
+    timing.connect_ms = millis() - start_time;
+
+    unsigned char offered_id[32];
+    size_t offered_id_len = 0;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_hasSession && _sessionHost == host) {
+        timing.resumption_offered = client.offerSession(&_session);
+        if (timing.resumption_offered) {
+            offered_id_len = copySessionId(_session, offered_id);
+        }
+    }
+    xSemaphoreGive(_mutex);
+
+    start_time = millis();
+    bool secured = client.handshake();
+    timing.tls_ms = millis() - start_time;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!secured) {
+        // A rejected session could be the cause, so don't offer it again
+        if (timing.resumption_offered) {
+            _hasSession = false;
+        }
+        xSemaphoreGive(_mutex);
+        Serial.printf("TLS handshake with %s failed\n", host.c_str());
+        client.stop();
+        return false;
+    }
+
+    // Keep the newest session (and ticket) for the next connection
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _hasSession = client.saveSession(&_session);
+    _sessionHost = host;
+
+    // A TLS 1.2 server that resumes echoes the offered session ID; one that turns
+    // the session or ticket down does a full handshake under a new ID
+    if (offered_id_len > 0 && _hasSession) {
+        unsigned char new_id[32];
+        timing.resumed = copySessionId(_session, new_id) == offered_id_len &&
+                         memcmp(new_id, offered_id, offered_id_len) == 0;
+    }
+
+    if (timing.resumption_offered) {
+        _stats.offered_sessions++;
+    }
+    if (timing.resumed) {
+        _stats.resumed_handshakes++;
+        _stats.resumed_ms_total += timing.tls_ms;
+    } else {
+        _stats.full_handshakes++;
+        _stats.handshake_ms_total += timing.tls_ms;
+    }
+    xSemaphoreGive(_mutex);
+
+    Serial.printf("Connected to %s: dns %lu ms, connect %lu ms, TLS %lu ms (%s)\n",
+                  host.c_str(), timing.dns_ms, timing.connect_ms, timing.tls_ms,
+                  timing.resumed ? "resumed" :
+                  timing.resumption_offered ? "session declined, full handshake" : "full handshake");
+    return true;
+}
+
+void ConnectionManager::invalidate(const String& host) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _dnsCache.erase(host);
+    if (_sessionHost == host) {
+        _hasSession = false;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void ConnectionManager::recordRequest(const ConnectionTiming& timing, unsigned long request_ms) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (timing.reused) {
+        _stats.reused_requests++;
+        _stats.reused_request_ms_total += request_ms;
+    } else {
+        _stats.new_requests++;
+        _stats.new_request_ms_total += request_ms;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+ConnectionManager::Stats ConnectionManager::getStats() const {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    Stats snapshot = _stats;
+    xSemaphoreGive(_mutex);
+    return snapshot;
+}
+
+bool ConnectionManager::resolve(const String& host, IPAddress& address, ConnectionTiming& timing) {
+    unsigned long now = millis();
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    auto cached = _dnsCache.find(host);
+    if (cached != _dnsCache.end() && now - cached->second.resolved_at < DNS_CACHE_TTL) {
+        address = cached->second.address;
+        _stats.dns_cache_hits++;
+        xSemaphoreGive(_mutex);
+        return true;
+    }
+    xSemaphoreGive(_mutex);
+
+    // Look up outside the lock; other workers may still use their cached entries
+    unsigned long start_time = millis();
+    if (WiFi.hostByName(host.c_str(), address) != 1) {
+        return false;
+    }
+    timing.dns_ms = millis() - start_time;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    DnsEntry entry;
+    entry.address = address;
+    entry.resolved_at = millis();
+    _dnsCache[host] = entry;
+    _stats.dns_lookups++;
+    xSemaphoreGive(_mutex);
+    return true;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <map>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <mbedtls/ssl.h>
+
+/**
+ * @class ResumableSecureClient
+ * @brief WiFiClientSecure that can offer a saved TLS session
+ *
+ * Splits the TCP connect from the TLS handshake (plain start) so a
+ * session captured from an earlier connection can be installed before
+ * the handshake begins. If the server still holds the session or
+ * accepts the ticket, the handshake skips the certificate exchange and
+ * key agreement.
+ */
+class ResumableSecureClient : public WiFiClientSecure {
+public:
+    /**
+     * @brief Open the TCP connection without starting TLS
+     *
+     * @param ip Resolved server address
+     * @param port Server port
+     * @param host Host name used for SNI
+     * @return true if the socket is connected
+     */
+    bool connectPlain(IPAddress ip, uint16_t port, const char* host);
+
+    /**
+     * @brief Offer a saved session for the upcoming handshake
+     * @param session Session captured from a previous connection
+     * @return true if mbedTLS accepted the session
+     */
+    bool offerSession(const mbedtls_ssl_session* session);
+
+    /**
+     * @brief Run the TLS handshake on the connected socket
+     * @return true if the handshake succeeded
+     */
+    bool handshake();
+
+    /**
+     * @brief Export the current session for later resumption
+     * @param session Initialized session that receives a copy
+     * @return true if the session was exported
+     */
+    bool saveSession(mbedtls_ssl_session* session);
+};
+
+/**
+ * @struct ConnectionTiming
+ * @brief Where the time went while establishing a connection
+ */
+struct ConnectionTiming {
+    bool reused = false;            ///< Kept-alive socket was used; no setup cost
+    bool resumption_offered = false; ///< A saved TLS session was offered
+    bool resumed = false;           ///< The server accepted it and skipped the full handshake
+    unsigned long dns_ms = 0;       ///< Host name lookup (0 when served from cache)
+    unsigned long connect_ms = 0;   ///< TCP connect
+    unsigned long tls_ms = 0;       ///< TLS handshake
+};
+
+/**
+ * @class ConnectionManager
+ * @brief Shared connection state for the fetch workers
+ *
+ * Features:
+ * - DNS cache so the region host is resolved once, not per request
+ * - TLS session store so new connections can resume instead of doing a full handshake
+ * - Counters comparing handshake cost against requests on reused sockets
+ *
+ * Each worker keeps its own socket alive between requests; this class
+ * only holds what can be shared between them. Thread-safe.
+ */
+class ConnectionManager {
+public:
+    /**
+     * @struct Stats
+     * @brief Aggregate connection counters
+     */
+    struct Stats {
+        uint32_t dns_lookups = 0;           ///< Lookups that went to the network
+        uint32_t dns_cache_hits = 0;        ///< Lookups served from the cache
+        uint32_t offered_sessions = 0;      ///< Handshakes that offered a saved session
+        uint32_t full_handshakes = 0;       ///< Handshakes that did not resume, offered or not
+        uint32_t resumed_handshakes = 0;    ///< Handshakes the server actually resumed
+        uint32_t handshake_ms_total = 0;    ///< Time spent in full handshakes
+        uint32_t resumed_ms_total = 0;      ///< Time spent in resumed handshakes
+        uint32_t reused_requests = 0;       ///< Requests sent on a kept-alive socket
+        uint32_t reused_request_ms_total = 0; ///< Time to response headers on reused sockets
+        uint32_t new_requests = 0;          ///< Requests that needed a new connection
+        uint32_t new_request_ms_total = 0;  ///< Time to response headers including connection setup
+    };
+
+    ConnectionManager();
+    ~ConnectionManager();
+
+    // Delete copy constructor and assignment operator
+    ConnectionManager(const ConnectionManager&) = delete;
+    void operator=(const ConnectionManager&) = delete;
+
+    /**
+     * @brief Connect a client to a host, reusing whatever can be reused
+     *
+     * @param client Worker's client; left untouched if already connected
+     * @param host Server host name
+     * @param port Server port
+     * @param timing Receives the connection setup breakdown
+     * @return true if the client is connected and ready for a request
+     */
+    bool connect(ResumableSecureClient& client, const String& host, uint16_t port, ConnectionTiming& timing);
+
+    /**
+     * @brief Forget the cached address and session for a host
+     * @param host Server host name
+     *
+     * Called after connection failures in case the address moved.
+     */
+    void invalidate(const String& host);
+
+    /**
+     * @brief Record how long a request took to get response headers
+     *
+     * @param timing Setup breakdown from connect()
+     * @param request_ms Time from starting the request to response headers
+     */
+    void recordRequest(const ConnectionTiming& timing, unsigned long request_ms);
+
+    /**
+     * @brief Get a snapshot of the connection counters
+     */
+    Stats getStats() const;
+
+private:
+    /**
+     * @struct DnsEntry
+     * @brief Cached host name resolution
+     */
+    struct DnsEntry {
+        IPAddress address;          ///< Resolved address
+        unsigned long resolved_at;  ///< When it was resolved
+    };
+
+    SemaphoreHandle_t _mutex;                 ///< Guards everything below
+    std::map<String, DnsEntry> _dnsCache;     ///< Resolved hosts
+    mbedtls_ssl_session _session;             ///< Last session captured for _sessionHost
+    String _sessionHost;                      ///< Host the saved session belongs to
+    bool _hasSession;                         ///< _session holds a usable session
+    Stats _stats;                             ///< Aggregate counters
+
+    // Constants
+    static const unsigned long DNS_CACHE_TTL = 600000;   ///< Re-resolve every 10 minutes
+
+    /**
+     * @brief Resolve a host, using the cache when fresh
+     *
+     * @param host Host name
+     * @param address Receives the address
+     * @param timing Receives the lookup time
+     * @return true if the host resolved
+     */
+    bool resolve(const String& host, IPAddress& address, ConnectionTiming& timing);
+};
@@ -0,0 +1,116 @@
+#include "FetchMetrics.h"
+#include <algorithm>
+
+const char* FetchMetrics::PHASE_NAMES[PHASE_COUNT] = {
+    "dns", "connect", "tls", "ttfb", "transfer", "parse"
+};
+
+FetchMetrics::FetchMetrics()
+    : _mutex(xSemaphoreCreateMutex()) {
+}
+
+FetchMetrics::~FetchMetrics() {
+    if (_mutex) {
+        vSemaphoreDelete(_mutex);
+        _mutex = nullptr;
+    }
+}
+
+void FetchMetrics::record(const String& insight_id, const RequestTiming& timing) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    auto it = _samples.find(insight_id);
+    if (it == _samples.end()) {
+        Samples empty = {};
+        it = _samples.emplace(insight_id, empty).first;
+    }
+    Samples& samples = it->second;
+
+    samples.values[PHASE_DNS][samples.next] = timing.dns_ms;
+    samples.values[PHASE_CONNECT][samples.next] = timing.connect_ms;
+    samples.values[PHASE_TLS][samples.next] = timing.tls_ms;
+    samples.values[PHASE_TTFB][samples.next] = timing.ttfb_ms;
+    samples.values[PHASE_TRANSFER][samples.next] = timing.transfer_ms;
+    samples.values[PHASE_PARSE][samples.next] = timing.parse_ms;
+
+    samples.next = (samples.next + 1) % SAMPLE_COUNT;
+    if (samples.count < SAMPLE_COUNT) {
+        samples.count++;
+    }
+    samples.requests++;
+    if (timing.reused_connection) {
+        samples.reused++;
+    }
+
+    // Status polls don't allocate an insight document
+    if (timing.document_capacity > 0) {
+        samples.document_bytes[samples.document_next] = timing.document_bytes;
+        samples.document_next = (samples.document_next + 1) % SAMPLE_COUNT;
+        if (samples.document_count < SAMPLE_COUNT) {
+            samples.document_count++;
+        }
+        samples.document_capacity = timing.document_capacity;
+        samples.document_filter = timing.document_filter;
+        if (timing.document_overflow) {
+            samples.document_overflows++;
+        }
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+void FetchMetrics::remove(const String& insight_id) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _samples.erase(insight_id);
+    xSemaphoreGive(_mutex);
+}
+
+void FetchMetrics::writeJson(JsonObject out) const {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    for (const auto& entry : _samples) {
+        const Samples& samples = entry.second;
+        JsonObject insight = out.createNestedObject(entry.first);
+        insight["requests"] = samples.requests;
+        insight["reused_connections"] = samples.reused;
+        insight["samples"] = samples.count;
+
+        for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+            writeSummary(samples.values[phase], samples.count, insight.createNestedObject(PHASE_NAMES[phase]));
+        }
+
+        if (samples.document_count > 0) {
+            JsonObject document = insight.createNestedObject("document_bytes");
+            writeSummary(samples.document_bytes, samples.document_count, document);
+            document["capacity"] = samples.document_capacity;
+            document["overflows"] = samples.document_overflows;
+            if (samples.document_filter) {
+                document["filter"] = samples.document_filter;
+            }
+        }
+    }
+
+    xSemaphoreGive(_mutex);
+}
+
+void FetchMetrics::writeSummary(const uint32_t* values, size_t count, JsonObject out) {
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t sorted[SAMPLE_COUNT];
+    std::copy(values, values + count, sorted);
+    std::sort(sorted, sorted + count);
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += sorted[i];
+    }
+
+    // Nearest-rank percentile
+    size_t p95_rank = (count * 95 + 99) / 100;
+
+    out["min"] = sorted[0];
+    out["avg"] = (uint32_t)(total / count);
+    out["p95"] = sorted[p95_rank - 1];
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <map>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * @struct RequestTiming
+ * @brief Where the time went in one insight request
+ *
+ * Transfer is the time spent waiting on the socket for body bytes;
+ * parse is the rest of the time spent reading the body, i.e. inflating
+ * and deserializing. The two overlap in wall time because the body is
+ * parsed as it streams in.
+ */
+struct RequestTiming {
+    bool reused_connection = false; ///< Kept-alive socket was used
+    unsigned long dns_ms = 0;       ///< Host name lookup (0 when cached or reused)
+    unsigned long connect_ms = 0;   ///< TCP connect (0 when reused)
+    unsigned long tls_ms = 0;       ///< TLS handshake (0 when reused)
+    unsigned long ttfb_ms = 0;      ///< Request sent until response headers read
+    unsigned long transfer_ms = 0;  ///< Waiting for body bytes
+    unsigned long parse_ms = 0;     ///< Inflating and deserializing the body
+    size_t document_capacity = 0;   ///< Document allocated for parsing, 0 if nothing was parsed
+    size_t document_bytes = 0;      ///< Memory the parsed document needed
+    bool document_overflow = false; ///< Response didn't fit document_capacity
+    const char* document_filter = nullptr; ///< Name of the filter the document was parsed with
+};
+
+/**
+ * @class FetchMetrics
+ * @brief Per-insight timing histograms for insight requests
+ *
+ * Keeps the most recent SAMPLE_COUNT timings of each phase per insight
+ * and reports min/avg/p95 over them, along with the memory each parsed
+ * document needed, so document sizes can be tuned against real responses.
+ * Thread-safe; written by the client and read by the web portal.
+ */
+class FetchMetrics {
+public:
+    /**
+     * @enum Phase
+     * @brief Request phases tracked separately
+     */
+    enum Phase {
+        PHASE_DNS,
+        PHASE_CONNECT,
+        PHASE_TLS,
+        PHASE_TTFB,
+        PHASE_TRANSFER,
+        PHASE_PARSE,
+        PHASE_COUNT
+    };
+
+    FetchMetrics();
+    ~FetchMetrics();
+
+    // Delete copy constructor and assignment operator
+    FetchMetrics(const FetchMetrics&) = delete;
+    void operator=(const FetchMetrics&) = delete;
+
+    /**
+     * @brief Add the timing of a completed request
+     *
+     * @param insight_id ID of insight that was fetched
+     * @param timing Phase breakdown
+     */
+    void record(const String& insight_id, const RequestTiming& timing);
+
+    /**
+     * @brief Forget the samples of an insight
+     * @param insight_id ID of insight whose card was removed
+     */
+    void remove(const String& insight_id);
+
+    /**
+     * @brief Write per-insight summaries
+     *
+     * @param out Object that receives one member per insight, each with
+     *            request counts, min/avg/p95 per phase in milliseconds and
+     *            min/avg/p95 document usage in bytes with the filter used
+     */
+    void writeJson(JsonObject out) const;
+
+private:
+    static const size_t SAMPLE_COUNT = 32;  ///< Samples kept per insight and phase
+
+    /**
+     * @struct Samples
+     * @brief Ring buffer of recent timings for one insight
+     */
+    struct Samples {
+        uint32_t values[PHASE_COUNT][SAMPLE_COUNT]; ///< Milliseconds per phase
+        uint8_t count;                              ///< Valid samples
+        uint8_t next;                               ///< Slot for the next sample
+        uint32_t requests;                          ///< All requests recorded
+        uint32_t reused;                            ///< Requests on a kept-alive socket
+        uint32_t document_bytes[SAMPLE_COUNT];      ///< Memory used by each parsed document
+        uint8_t document_count;                     ///< Valid document samples
+        uint8_t document_next;                      ///< Slot for the next document sample
+        uint32_t document_capacity;                 ///< Capacity of the last parse
+        uint32_t document_overflows;                ///< Parses that ran out of capacity
+        const char* document_filter;                ///< Filter of the last parse, a static string
+    };
+
+    SemaphoreHandle_t _mutex;               ///< Guards _samples
+    std::map<String, Samples> _samples;     ///< Samples by insight ID
+
+    static const char* PHASE_NAMES[PHASE_COUNT];
+
+    /**
+     * @brief Write min/avg/p95 of one phase
+     *
+     * @param values Samples (not necessarily ordered)
+     * @param count Number of samples
+     * @param out Object receiving min, avg and p95
+     */
+    static void writeSummary(const uint32_t* values, size_t count, JsonObject out);
+};
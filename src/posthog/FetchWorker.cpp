@@ -0,0 +1,397 @@
+#include "FetchWorker.h"
+#include "HttpBodyStream.h"
+#include "InflateStream.h"
+#include "TimeFormat.h"
+
+FetchWorker::FetchWorker(uint8_t index, QueueHandle_t result_queue, ConnectionManager& connections)
+    : _index(index)
+    , _jobQueue(xQueueCreate(1, sizeof(FetchJob*)))
+    , _resultQueue(result_queue)
+    , _busy(false)
+    , _holdsConnection(false)
+    , _stopRequested(false)
+    , _running(false)
+    , _taskHandle(nullptr)
+    , _connections(connections)
+    , _lastUsed(0) {
+    // Configure secure client for HTTPS
+    _secureClient.setInsecure(); // TODO: get proper cert baked into the firmware to verify these connections
+    _http.setReuse(true);
+}
+
+FetchWorker::~FetchWorker() {
+    if (_jobQueue) {
+        // A job handed over after the task stopped never ran
+        FetchJob* job = nullptr;
+        while (xQueueReceive(_jobQueue, &job, 0) == pdPASS) {
+            delete job;
+        }
+        vQueueDelete(_jobQueue);
+        _jobQueue = nullptr;
+    }
+}
+
+bool FetchWorker::begin() {
+    if (_taskHandle != nullptr) {
+        return true;
+    }
+    if (_jobQueue == nullptr) {
+        Serial.printf("[FetchWorker-%u] Failed to create job queue\n", _index);
+        return false;
+    }
+
+    char task_name[16];
+    snprintf(task_name, sizeof(task_name), "fetchWorker%u", _index);
+
+    _running = true;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        taskEntry,
+        task_name,
+        TASK_STACK_SIZE,
+        this,
+        1,
+        &_taskHandle,
+        0               // Same core as the rest of the network work
+    );
+    if (result != pdPASS) {
+        Serial.printf("[FetchWorker-%u] Failed to create task\n", _index);
+        _running = false;
+        _taskHandle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool FetchWorker::submit(FetchJob* job) {
+    if (_busy || _taskHandle == nullptr || _stopRequested) {
+        return false;
+    }
+
+    _busy = true;
+    if (xQueueSend(_jobQueue, &job, 0) != pdPASS) {
+        _busy = false;
+        return false;
+    }
+    return true;
+}
+
+bool FetchWorker::releaseConnection() {
+    if (!_holdsConnection) {
+        return true;
+    }
+    if (_busy || _taskHandle == nullptr || _stopRequested) {
+        return false;
+    }
+
+    // A null job tells the task to close the socket
+    _busy = true;
+    FetchJob* release = nullptr;
+    if (xQueueSend(_jobQueue, &release, 0) != pdPASS) {
+        _busy = false;
+        return false;
+    }
+    return true;
+}
+
+void FetchWorker::stop() {
+    _stopRequested = true;
+}
+
+void FetchWorker::taskEntry(void* parameter) {
+    FetchWorker* self = static_cast<FetchWorker*>(parameter);
+    FetchJob* job = nullptr;
+
+    // Wakes up now and then while idle to notice stop()
+    while (!self->_stopRequested) {
+        if (xQueueReceive(self->_jobQueue, &job, pdMS_TO_TICKS(STOP_POLL_MS)) != pdPASS) {
+            continue;
+        }
+
+        if (job == nullptr) {
+            self->_secureClient.stop();
+            self->_holdsConnection = false;
+            Serial.printf("[FetchWorker-%u] Released connection\n", self->_index);
+            self->_busy = false;
+            continue;
+        }
+
+        FetchResult* result = self->execute(*job);
+        delete job;
+        job = nullptr;
+        self->_holdsConnection = self->_secureClient.connected();
+
+        // The result queue is sized for every worker, so this only waits if the client stalls
+        xQueueSend(self->_resultQueue, &result, portMAX_DELAY);
+        self->_busy = false;
+    }
+
+    self->_secureClient.stop();
+    self->_holdsConnection = false;
+    Serial.printf("[FetchWorker-%u] Stopped\n", self->_index);
+    // Last touch of the worker; the owner may delete it from here on
+    self->_running = false;
+    vTaskDelete(NULL);
+}
+
+FetchResult* FetchWorker::execute(const FetchJob& job) {
+    FetchResult* result = new FetchResult();
+    result->insight_id = job.insight_id;
+    result->phase = job.phase;
+    result->results_only = (job.metadata != nullptr);
+    result->series_tail = job.series_tail;
+    result->document_capacity = job.document_capacity;
+    result->http_code = 0;
+    result->server_time = 0;
+    result->received_at = 0;
+    result->retry_after_ms = 0;
+
+    unsigned long start_time = millis();
+
+    if (WiFi.status() != WL_CONNECTED) {
+        result->http_code = HTTPC_ERROR_NOT_CONNECTED;
+        result->elapsed_ms = 0;
+        return result;
+    }
+
+    // Servers drop idle keep-alive sockets; don't gamble on one that sat too long
+    if (_secureClient.connected() && millis() - _lastUsed >= KEEPALIVE_IDLE_TIMEOUT) {
+        _secureClient.stop();
+    }
+
+    if (runRequest(job, *result)) {
+        Serial.printf("[FetchWorker-%u] Kept-alive connection was closed, retrying on a new one\n", _index);
+        runRequest(job, *result);
+    }
+
+    _lastUsed = millis();
+    result->elapsed_ms = millis() - start_time;
+    return result;
+}
+
+bool FetchWorker::runRequest(const FetchJob& job, FetchResult& result) {
+    ConnectionTiming timing;
+    if (!_connections.connect(_secureClient, job.host, job.port, timing)) {
+        result.http_code = HTTPC_ERROR_CONNECTION_REFUSED;
+        return false;
+    }
+
+    unsigned long request_start = millis();
+    _http.begin(_secureClient, job.url);
+
+    // Insight JSON compresses roughly tenfold, which saves most of the TLS records
+    _http.addHeader("Accept-Encoding", "gzip, deflate");
+
+    // Needed to frame and decode the body, to read the server clock and to back off when rate limited
+    const char* header_keys[] = {"Transfer-Encoding", "Content-Encoding", "Date", "Retry-After"};
+    _http.collectHeaders(header_keys, 4);
+
+    int httpCode;
+    if (job.body.length() > 0) {
+        _http.addHeader("Content-Type", "application/json");
+        httpCode = _http.POST(job.body);
+    } else {
+        httpCode = _http.GET();
+    }
+    result.http_code = httpCode;
+
+    if (httpCode < 0) {
+        _http.end();
+        _secureClient.stop();
+        return timing.reused;
+    }
+
+    unsigned long network_time = millis() - request_start;
+    _connections.recordRequest(timing, network_time);
+
+    // Freshness timestamps in the body are in server time; the Date header
+    // lets them be compared without trusting the local clock
+    result.received_at = millis();
+    if (!TimeFormat::parseHttpDate(_http.header("Date").c_str(), &result.server_time)) {
+        result.server_time = 0;
+    }
+
+    result.timing = RequestTiming();
+    result.timing.reused_connection = timing.reused;
+    result.timing.dns_ms = timing.dns_ms;
+    result.timing.connect_ms = timing.connect_ms;
+    result.timing.tls_ms = timing.tls_ms;
+    result.timing.ttfb_ms = network_time;
+
+    if (httpCode == HTTP_CODE_OK) {
+        Serial.printf("[FetchWorker-%u] Network fetch time for %s (%s%s, %s): %lu ms\n", _index,
+                      job.insight_id.c_str(), job.hogql ? "HogQL, " : (job.series_tail ? "series tail, " : (job.metadata ? "results only, " : "")),
+                      job.phase == FetchPhase::CACHED ? "force_cache" : (job.phase == FetchPhase::START_QUERY ? "async" : "query status"),
+                      timing.reused ? "reused connection" : "new connection", network_time);
+
+        unsigned long body_start = millis();
+
+        // Parse straight from the socket through the body framing (and the
+        // inflater if compressed); only the filtered document is kept in memory
+        bool chunked = _http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+        String encoding = _http.header("Content-Encoding");
+        HttpBodyStream body(*_http.getStreamPtr(), _http.getSize(), chunked);
+        parseBody(body, encoding, chunked ? -1 : _http.getSize(), job, result);
+
+        // Leave the socket at a clean message boundary so it can be reused
+        if (!body.drain()) {
+            _secureClient.stop();
+        }
+
+        // Parsing happens as the body arrives; split the time into waiting and working
+        unsigned long body_time = millis() - body_start;
+        result.timing.transfer_ms = body.waitTime() < body_time ? body.waitTime() : body_time;
+        result.timing.parse_ms = body_time - result.timing.transfer_ms;
+        Serial.printf("[FetchWorker-%u] Body: %u bytes, transfer %lu ms, parse %lu ms\n", _index,
+                      (unsigned)body.bytesRead(), result.timing.transfer_ms, result.timing.parse_ms);
+
+        // Report how much of the document the parse used, so sizes can be tuned
+        if (result.parser) {
+            result.timing.document_capacity = result.parser->getParseCapacity();
+            result.timing.document_bytes = result.parser->getParseUsage();
+            result.timing.document_overflow = result.parser->ranOutOfMemory();
+            result.timing.document_filter = InsightParser::filterTypeName(result.parser->getParseFilter());
+            Serial.printf("[FetchWorker-%u] Document: %u of %u bytes, %s filter%s\n", _index,
+                          (unsigned)result.timing.document_bytes, (unsigned)result.timing.document_capacity,
+                          result.timing.document_filter, result.timing.document_overflow ? ", out of memory" : "");
+        }
+
+        bool parsed;
+        if (job.phase == FetchPhase::POLL_STATUS) {
+            parsed = result.query_status.valid;
+        } else if (job.hogql) {
+            parsed = result.query_result && result.query_result->isValid();
+        } else {
+            parsed = result.parser && result.parser->isValid();
+        }
+        if (!parsed) {
+            Serial.printf("[FetchWorker-%u] Failed to parse response for insight %s\n", _index, job.insight_id.c_str());
+            result.parser.reset();
+            result.query_result.reset();
+        }
+    } else if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+        result.retry_after_ms = parseRetryAfter(_http.header("Retry-After"), result.server_time);
+        Serial.printf("[FetchWorker-%u] Rate limited, server asks to wait %lu ms\n", _index, result.retry_after_ms);
+        _secureClient.stop();
+    } else {
+        // Handle HTTP errors; the unread error body makes the socket unusable
+        Serial.printf("[FetchWorker-%u] HTTP %s failed, error: %d\n", _index, job.body.length() > 0 ? "POST" : "GET", httpCode);
+        _secureClient.stop();
+    }
+
+    _http.end();
+    return false;
+}
+
+void FetchWorker::parseBody(Stream& body, const String& encoding, int body_length, const FetchJob& job, FetchResult& result) {
+    size_t capacity = job.document_capacity;
+    if (encoding.length() == 0 || encoding.equalsIgnoreCase("identity")) {
+        // Without history the length of a plain body is the best estimate;
+        // never more than was reserved for the job
+        if (job.size_from_body && body_length > 0) {
+            size_t estimate = InsightParser::capacityForBody((size_t)body_length);
+            capacity = estimate < capacity ? estimate : capacity;
+        }
+        parseDecoded(body, capacity, job, result);
+        return;
+    }
+
+    InflateStream::Format format;
+    if (encoding.equalsIgnoreCase("gzip")) {
+        format = InflateStream::Format::GZIP;
+    } else if (encoding.equalsIgnoreCase("deflate")) {
+        format = InflateStream::Format::ZLIB;
+    } else {
+        Serial.printf("[FetchWorker-%u] Unsupported Content-Encoding: %s\n", _index, encoding.c_str());
+        return;
+    }
+
+    InflateStream inflated(body, format);
+    if (!inflated.begin()) {
+        return;
+    }
+
+    parseDecoded(inflated, capacity, job, result);
+    Serial.printf("[FetchWorker-%u] Inflated %u bytes of %s to %u\n", _index,
+                  (unsigned)inflated.bytesIn(), encoding.c_str(), (unsigned)inflated.bytesOut());
+}
+
+void FetchWorker::parseDecoded(Stream& body, size_t capacity, const FetchJob& job, FetchResult& result) {
+    FetchPhase phase = job.phase;
+    if (phase != FetchPhase::POLL_STATUS && job.hogql) {
+        result.query_result = std::make_shared<HogQLParser>(body);
+
+        char query_id[64];
+        bool complete = false;
+        bool error = false;
+        if (phase == FetchPhase::START_QUERY && result.query_result->isValid() &&
+            result.query_result->getQueryStatus(query_id, sizeof(query_id), &complete, &error)) {
+            result.query_status.valid = true;
+            result.query_status.id = query_id;
+            result.query_status.complete = complete;
+            result.query_status.error = error;
+        }
+        return;
+    }
+
+    if (phase != FetchPhase::POLL_STATUS) {
+        if (job.metadata) {
+            result.parser = std::make_shared<InsightParser>(job.metadata, body, capacity, job.filter);
+        } else {
+            result.parser = std::make_shared<InsightParser>(body, capacity, job.filter);
+        }
+
+        // An async refresh that had to start a calculation says so in the insight
+        char query_id[64];
+        bool complete = false;
+        bool error = false;
+        if (phase == FetchPhase::START_QUERY && result.parser->isValid() &&
+            result.parser->getQueryStatus(query_id, sizeof(query_id), &complete, &error)) {
+            result.query_status.valid = true;
+            result.query_status.id = query_id;
+            result.query_status.complete = complete;
+            result.query_status.error = error;
+        }
+        return;
+    }
+
+    // Status polls only need three flags; a finished query also carries its
+    // results, which the filter skips so they never take up memory here
+    StaticJsonDocument<128> filter;
+    filter["query_status"]["id"] = true;
+    filter["query_status"]["complete"] = true;
+    filter["query_status"]["error"] = true;
+
+    StaticJsonDocument<256> doc;
+    DeserializationError error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+    if (error) {
+        return;
+    }
+
+    JsonObjectConst status = doc["query_status"];
+    if (status.isNull()) {
+        return;
+    }
+    result.query_status.valid = true;
+    result.query_status.id = status["id"] | "";
+    result.query_status.complete = status["complete"] | false;
+    result.query_status.error = status["error"] | false;
+}
+
+unsigned long FetchWorker::parseRetryAfter(const String& value, time_t server_time) {
+    if (value.length() == 0) {
+        return 0;
+    }
+
+    // Either delay-seconds or an HTTP date
+    char* end = nullptr;
+    unsigned long seconds = strtoul(value.c_str(), &end, 10);
+    if (end && end != value.c_str() && *end == '\0') {
+        return seconds * 1000UL;
+    }
+
+    time_t retry_at = 0;
+    if (server_time != 0 && TimeFormat::parseHttpDate(value.c_str(), &retry_at) && retry_at > server_time) {
+        return (unsigned long)(retry_at - server_time) * 1000UL;
+    }
+    return 0;
+}
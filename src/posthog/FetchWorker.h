@@ -0,0 +1,214 @@
+#pragma once
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <memory>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "parsers/InsightParser.h"
+#include "parsers/HogQLParser.h"
+#include "ConnectionManager.h"
+#include "FetchMetrics.h"
+#include "PendingRequests.h"
+
+/**
+ * @struct FetchJob
+ * @brief A single insight request handed to a worker
+ */
+struct FetchJob {
+    String insight_id;    ///< ID of insight being fetched
+    String host;          ///< API host, used to pick up a kept-alive connection
+    uint16_t port;        ///< API port
+    String url;           ///< Fully built request URL
+    FetchPhase phase;     ///< What the URL asks for
+    String body;          ///< JSON body; sent as a POST when not empty
+    bool hogql;           ///< Body is a HogQL query; the response is parsed with HogQLParser
+    bool series_tail;     ///< Body asks for only the newest buckets of a time series
+    size_t document_capacity; ///< Largest parse document the job may allocate, reserved from the PSRAM budget
+    bool size_from_body;  ///< No history for this insight yet; size the document from Content-Length when known
+    InsightParser::FilterType filter; ///< Fields to keep, narrowed to the type the insight had last time
+    std::shared_ptr<const InsightParser> metadata; ///< Insight metadata for results-only responses
+};
+
+/**
+ * @struct QueryStatus
+ * @brief Progress of a server-side query started with refresh=async
+ */
+struct QueryStatus {
+    bool valid = false;     ///< Response carried a query status
+    String id;              ///< Query ID to poll
+    bool complete = false;  ///< Result has been computed and cached
+    bool error = false;     ///< Query failed on the server
+};
+
+/**
+ * @struct FetchResult
+ * @brief Outcome of a FetchJob, posted back to PostHogClient
+ */
+struct FetchResult {
+    String insight_id;                       ///< ID of insight that was fetched
+    FetchPhase phase;                        ///< Phase the job ran in
+    bool results_only;                       ///< Job asked the query API for results only
+    bool series_tail;                        ///< Result holds only the newest buckets, to be merged
+    size_t document_capacity;                ///< PSRAM the job reserved for its document
+    int http_code;                           ///< HTTP status or negative HTTPClient error
+    std::shared_ptr<InsightParser> parser;   ///< Parsed insight, null on failure or for POLL_STATUS
+    std::shared_ptr<HogQLParser> query_result; ///< Parsed HogQL result, for HogQL jobs instead of parser
+    QueryStatus query_status;                ///< Query progress, for START_QUERY and POLL_STATUS
+    unsigned long elapsed_ms;                ///< Wall time of the request
+    RequestTiming timing;                    ///< Phase breakdown of the last attempt
+    time_t server_time;                      ///< Server clock from the Date header, 0 if absent
+    unsigned long received_at;               ///< millis() when the response headers arrived
+    unsigned long retry_after_ms;            ///< Wait advised by a 429's Retry-After header, 0 if none
+};
+
+/**
+ * @class FetchWorker
+ * @brief Runs insight requests on its own task and connection
+ *
+ * Each worker owns a TLS client/HTTPClient pair, so several requests
+ * can be in flight at once without sharing a socket. The socket is kept
+ * alive between jobs (HTTP/1.1), and new connections go through the
+ * shared ConnectionManager for cached DNS and TLS session resumption.
+ * Jobs are handed over one at a time; the worker streams the response
+ * (inflating gzip/deflate bodies on the way) into an InsightParser or,
+ * for HogQL cards, a HogQLParser, or just reads the query status when
+ * polling an async query, and posts a
+ * FetchResult pointer to the shared result queue. Ownership of
+ * jobs and results moves with the pointers.
+ */
+class FetchWorker {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param index Worker number, used for the task name and logs
+     * @param result_queue Queue receiving FetchResult pointers
+     * @param connections Shared DNS cache and TLS session store
+     */
+    FetchWorker(uint8_t index, QueueHandle_t result_queue, ConnectionManager& connections);
+
+    /**
+     * @brief Destructor; the task must have stopped (see stop())
+     */
+    ~FetchWorker();
+
+    // Delete copy constructor and assignment operator
+    FetchWorker(const FetchWorker&) = delete;
+    void operator=(const FetchWorker&) = delete;
+
+    /**
+     * @brief Start the worker task
+     * @return true if the task was created
+     */
+    bool begin();
+
+    /**
+     * @brief Check whether the worker can accept a job
+     * @return true if no job is queued or running
+     */
+    bool isIdle() const { return !_busy; }
+
+    /**
+     * @brief Hand a job to the worker
+     *
+     * @param job Heap-allocated job; the worker takes ownership on success
+     * @return false if the worker is busy, in which case the caller keeps ownership
+     */
+    bool submit(FetchJob* job);
+
+    /**
+     * @brief Close the kept-alive socket to free its TLS buffers
+     *
+     * Handed to the worker task like a job, so it never races a request.
+     *
+     * @return true if the socket is closed or already was; false if the
+     *         worker is busy, in which case try again once it is idle
+     */
+    bool releaseConnection();
+
+    /**
+     * @brief Ask the worker task to exit
+     *
+     * A running request is finished and its result posted first, so the
+     * result queue has to keep being drained until isStopped().
+     */
+    void stop();
+
+    /**
+     * @brief Check whether the worker task has exited
+     * @return true once the task is gone, or if it never started
+     */
+    bool isStopped() const { return !_running; }
+
+private:
+    uint8_t _index;                 ///< Worker number
+    QueueHandle_t _jobQueue;        ///< Single-slot queue of FetchJob pointers
+    QueueHandle_t _resultQueue;     ///< Shared queue of FetchResult pointers
+    volatile bool _busy;            ///< Job queued or running
+    volatile bool _holdsConnection; ///< Socket left open after the last job
+    volatile bool _stopRequested;   ///< stop() was called; the task exits once idle
+    volatile bool _running;         ///< Task created and not yet exited
+    TaskHandle_t _taskHandle;       ///< Worker task
+    ConnectionManager& _connections; ///< Shared connection state
+    ResumableSecureClient _secureClient; ///< Secure WiFi client for HTTPS, kept alive between jobs
+    HTTPClient _http;               ///< HTTP client instance
+    unsigned long _lastUsed;        ///< When the socket last finished a request
+
+    // Constants
+    static const uint32_t TASK_STACK_SIZE = 8192;   ///< TLS and JSON parsing need a deep stack
+    static const unsigned long KEEPALIVE_IDLE_TIMEOUT = 30000; ///< Reconnect rather than trust a socket idle this long
+    static const uint32_t STOP_POLL_MS = 100;       ///< How often an idle task checks for stop()
+
+    static void taskEntry(void* parameter);
+
+    /**
+     * @brief Execute a job and build its result
+     * @param job Job to run
+     * @return Heap-allocated result
+     */
+    FetchResult* execute(const FetchJob& job);
+
+    /**
+     * @brief Send one request and parse the response into the result
+     *
+     * @param job Job to run
+     * @param result Receives status and parser
+     * @return true if a kept-alive socket turned out to be dead and the
+     *         request is worth repeating on a fresh connection
+     */
+    bool runRequest(const FetchJob& job, FetchResult& result);
+
+    /**
+     * @brief Parse a response body, inflating it first if compressed
+     *
+     * @param body Response body
+     * @param encoding Content-Encoding header value, empty if none
+     * @param body_length Content-Length, or -1 if unknown
+     * @param job Job that was run, which decides what the body holds
+     * @param result Receives the parser or query status; left empty if the
+     *               encoding is unsupported or memory ran out
+     */
+    void parseBody(Stream& body, const String& encoding, int body_length, const FetchJob& job, FetchResult& result);
+
+    /**
+     * @brief Parse a decoded response body
+     *
+     * @param body Decoded response body
+     * @param capacity Document to allocate for an insight
+     * @param job Job that was run
+     * @param result Receives the parser or HogQL result, and the query status
+     */
+    static void parseDecoded(Stream& body, size_t capacity, const FetchJob& job, FetchResult& result);
+
+    /**
+     * @brief Convert a Retry-After header into a wait
+     *
+     * @param value Header value: delay-seconds or an HTTP date
+     * @param server_time Server clock from the Date header, 0 if absent
+     * @return Wait in milliseconds, 0 if the header is absent or unusable
+     */
+    static unsigned long parseRetryAfter(const String& value, time_t server_time);
+};
@@ -0,0 +1,211 @@
+#include "HttpBodyStream.h"
+
+HttpBodyStream::HttpBodyStream(Stream& source, int content_length, bool chunked)
+    : _source(source)
+    , _chunked(chunked)
+    , _remaining(chunked ? 0 : content_length)
+    , _complete(!chunked && content_length == 0)
+    , _error(false)
+    , _bytes_read(0)
+    , _peeked(-1)
+    , _wait_us(0)
+    , _buffer_len(0)
+    , _buffer_pos(0) {
+    setTimeout(source.getTimeout());
+}
+
+int HttpBodyStream::available() {
+    if (_peeked >= 0) {
+        return 1;
+    }
+    if (_complete || _error) {
+        return 0;
+    }
+    // Framing bytes make an exact count impossible; report whether anything is pending
+    return (_buffer_pos < _buffer_len || _source.available() > 0) ? 1 : 0;
+}
+
+int HttpBodyStream::read() {
+    if (_peeked >= 0) {
+        int c = _peeked;
+        _peeked = -1;
+        return c;
+    }
+    return nextByte();
+}
+
+int HttpBodyStream::peek() {
+    if (_peeked < 0) {
+        _peeked = nextByte();
+    }
+    return _peeked;
+}
+
+bool HttpBodyStream::drain() {
+    _peeked = -1;
+    while (!_complete && !_error) {
+        if (nextByte() < 0) {
+            break;
+        }
+    }
+
+    // A body delimited by connection close can't leave a reusable socket behind
+    return _complete && !_error && (_chunked || _remaining == 0);
+}
+
+int HttpBodyStream::readRaw() {
+    if (_buffer_pos < _buffer_len) {
+        return _buffer[_buffer_pos++];
+    }
+
+    // Wait for one byte, then take whatever else has already arrived
+    unsigned long wait_start = micros();
+    size_t count = _source.readBytes(_buffer, 1);
+    _wait_us += micros() - wait_start;
+    if (count == 0) {
+        return -1;
+    }
+    int pending = _source.available();
+    if (pending > 0) {
+        size_t extra = (size_t)pending < sizeof(_buffer) - 1 ? (size_t)pending : sizeof(_buffer) - 1;
+        count += _source.readBytes(_buffer + 1, extra);
+    }
+
+    _buffer_len = count;
+    _buffer_pos = 1;
+    return _buffer[0];
+}
+
+bool HttpBodyStream::beginChunk() {
+    // Chunk size line: hex digits, optional ";extension", CRLF
+    unsigned long size = 0;
+    bool has_digits = false;
+    bool in_extension = false;
+
+    while (true) {
+        int c = readRaw();
+        if (c < 0) {
+            return false;
+        }
+        if (c == '\r') {
+            continue;
+        }
+        if (c == '\n') {
+            break;
+        }
+        if (in_extension || c == ' ' || c == '\t') {
+            continue;
+        }
+        if (c == ';') {
+            in_extension = true;
+            continue;
+        }
+
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+
+        if (size > 0x07FFFFFF) {
+            return false; // Larger than anything we'd ever accept
+        }
+        size = size * 16 + digit;
+        has_digits = true;
+    }
+
+    if (!has_digits) {
+        return false;
+    }
+
+    if (size == 0) {
+        // Last chunk: skip optional trailer headers up to the blank line
+        size_t line_length = 0;
+        while (true) {
+            int c = readRaw();
+            if (c < 0) {
+                return false;
+            }
+            if (c == '\r') {
+                continue;
+            }
+            if (c == '\n') {
+                if (line_length == 0) {
+                    break;
+                }
+                line_length = 0;
+                continue;
+            }
+            line_length++;
+        }
+        _complete = true;
+        return true;
+    }
+
+    _remaining = (int)size;
+    return true;
+}
+
+bool HttpBodyStream::endChunk() {
+    int c = readRaw();
+    if (c == '\r') {
+        c = readRaw();
+    }
+    return c == '\n';
+}
+
+int HttpBodyStream::nextByte() {
+    if (_complete || _error) {
+        return -1;
+    }
+
+    if (_chunked) {
+        if (_remaining == 0) {
+            if (!beginChunk()) {
+                _error = true;
+                return -1;
+            }
+            if (_complete) {
+                return -1;
+            }
+        }
+
+        int c = readRaw();
+        if (c < 0) {
+            _error = true;
+            return -1;
+        }
+        _remaining--;
+        _bytes_read++;
+
+        if (_remaining == 0 && !endChunk()) {
+            _error = true;
+        }
+        return c;
+    }
+
+    int c = readRaw();
+    if (c < 0) {
+        // Without a Content-Length the body simply ends when the server closes
+        if (_remaining < 0) {
+            _complete = true;
+        } else {
+            _error = true;
+        }
+        return -1;
+    }
+    _bytes_read++;
+
+    if (_remaining > 0) {
+        _remaining--;
+        if (_remaining == 0) {
+            _complete = true;
+        }
+    }
+    return c;
+}
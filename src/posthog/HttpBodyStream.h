@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @class HttpBodyStream
+ * @brief Read-only view of an HTTP/1.1 response body
+ *
+ * Sits between the socket and the JSON deserializer and removes the
+ * message framing, so a kept-alive connection can carry either a
+ * Content-Length body or a chunked one. The stream reports end of data
+ * exactly at the end of the body, and drain() consumes whatever the
+ * consumer left behind so the connection is clean for the next request.
+ *
+ * Reads block for up to the source stream's timeout.
+ */
+class HttpBodyStream : public Stream {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param source Socket positioned at the start of the body
+     * @param content_length Body size from Content-Length, or -1 if unknown
+     * @param chunked true if the body uses chunked transfer encoding
+     */
+    HttpBodyStream(Stream& source, int content_length, bool chunked);
+
+    // Stream interface
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+
+    /**
+     * @brief Consume the rest of the body
+     * @return true if the end of the body was reached cleanly
+     */
+    bool drain();
+
+    /**
+     * @brief Check if the body has been read to the end
+     * @return true once the final byte (or final chunk) was consumed
+     */
+    bool isComplete() const { return _complete; }
+
+    /**
+     * @brief Check if the framing could not be decoded
+     * @return true if the connection must not be reused
+     */
+    bool hasError() const { return _error; }
+
+    /**
+     * @brief Number of body bytes delivered so far
+     */
+    size_t bytesRead() const { return _bytes_read; }
+
+    /**
+     * @brief Time spent waiting on the socket for data, in milliseconds
+     */
+    unsigned long waitTime() const { return _wait_us / 1000; }
+
+private:
+    Stream& _source;          ///< Underlying socket
+    bool _chunked;            ///< Chunked transfer encoding in use
+    int _remaining;           ///< Bytes left in the body or current chunk; -1 means read to close
+    bool _complete;           ///< End of body reached
+    bool _error;              ///< Framing error or timeout
+    size_t _bytes_read;       ///< Body bytes delivered
+    int _peeked;              ///< Byte held back by peek(), or -1
+    uint64_t _wait_us;        ///< Time blocked in socket reads
+
+    // Small read-ahead buffer so TLS reads are not issued byte by byte
+    uint8_t _buffer[256];
+    size_t _buffer_len;
+    size_t _buffer_pos;
+
+    /**
+     * @brief Read one raw byte from the socket, waiting up to the timeout
+     * @return Byte value or -1 on timeout/close
+     */
+    int readRaw();
+
+    /**
+     * @brief Read the size line of the next chunk
+     * @return true if a chunk size was parsed
+     */
+    bool beginChunk();
+
+    /**
+     * @brief Consume the CRLF that terminates a chunk's data
+     */
+    bool endChunk();
+
+    /**
+     * @brief Deliver the next body byte, decoding framing as needed
+     */
+    int nextByte();
+};
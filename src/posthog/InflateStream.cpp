@@ -0,0 +1,240 @@
+#include "InflateStream.h"
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+// tinfl is part of the ROM on every ESP32; fall back to a regular miniz elsewhere
+#if __has_include(<esp32s3/rom/miniz.h>)
+#include <esp32s3/rom/miniz.h>
+#elif __has_include(<rom/miniz.h>)
+#include <rom/miniz.h>
+#else
+#include <miniz.h>
+#endif
+
+static_assert(InflateStream::WINDOW_SIZE == TINFL_LZ_DICT_SIZE, "Inflate window must match the deflate dictionary size");
+
+// gzip header flag bits (RFC 1952)
+static const uint8_t GZIP_FLAG_HCRC = 0x02;
+static const uint8_t GZIP_FLAG_EXTRA = 0x04;
+static const uint8_t GZIP_FLAG_NAME = 0x08;
+static const uint8_t GZIP_FLAG_COMMENT = 0x10;
+
+static void* allocatePreferPsram(size_t size) {
+    void* ptr = nullptr;
+#ifdef ESP32
+    ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    if (!ptr) {
+        ptr = malloc(size);
+    }
+    return ptr;
+}
+
+InflateStream::InflateStream(Stream& source, Format format)
+    : _source(source)
+    , _format(format)
+    , _decompressor(nullptr)
+    , _window(nullptr)
+    , _window_pos(0)
+    , _out_pos(0)
+    , _out_end(0)
+    , _header_done(format != Format::GZIP)
+    , _complete(false)
+    , _error(false)
+    , _needs_input(true)
+    , _bytes_in(0)
+    , _bytes_out(0)
+    , _peeked(-1)
+    , _input_len(0)
+    , _input_pos(0) {
+    setTimeout(source.getTimeout());
+}
+
+InflateStream::~InflateStream() {
+    free(_decompressor);
+    free(_window);
+}
+
+bool InflateStream::begin() {
+    if (_decompressor && _window) {
+        return true;
+    }
+
+    _decompressor = static_cast<tinfl_decompressor*>(allocatePreferPsram(sizeof(tinfl_decompressor)));
+    _window = static_cast<uint8_t*>(allocatePreferPsram(WINDOW_SIZE));
+    if (!_decompressor || !_window) {
+        Serial.println("Not enough memory for inflate window");
+        _error = true;
+        return false;
+    }
+
+    tinfl_init(_decompressor);
+    return true;
+}
+
+int InflateStream::available() {
+    if (_peeked >= 0 || _out_pos < _out_end) {
+        return 1;
+    }
+    if (_complete || _error) {
+        return 0;
+    }
+    // Compressed bytes don't map to output bytes; report whether anything is pending
+    return (_input_pos < _input_len || _source.available() > 0) ? 1 : 0;
+}
+
+int InflateStream::read() {
+    if (_peeked >= 0) {
+        int c = _peeked;
+        _peeked = -1;
+        return c;
+    }
+    return nextByte();
+}
+
+int InflateStream::peek() {
+    if (_peeked < 0) {
+        _peeked = nextByte();
+    }
+    return _peeked;
+}
+
+bool InflateStream::fillInput() {
+    if (_input_pos < _input_len) {
+        return true;
+    }
+
+    // Wait for one byte, then take whatever else has already arrived
+    size_t count = _source.readBytes(_input, 1);
+    if (count == 0) {
+        return false;
+    }
+    int pending = _source.available();
+    if (pending > 0) {
+        size_t extra = (size_t)pending < sizeof(_input) - 1 ? (size_t)pending : sizeof(_input) - 1;
+        count += _source.readBytes(_input + 1, extra);
+    }
+
+    _input_len = count;
+    _input_pos = 0;
+    return true;
+}
+
+int InflateStream::inputByte() {
+    if (!fillInput()) {
+        return -1;
+    }
+    _bytes_in++;
+    return _input[_input_pos++];
+}
+
+bool InflateStream::skipGzipHeader() {
+    // ID1 ID2 CM FLG MTIME(4) XFL OS
+    uint8_t header[10];
+    for (size_t i = 0; i < sizeof(header); i++) {
+        int c = inputByte();
+        if (c < 0) {
+            return false;
+        }
+        header[i] = (uint8_t)c;
+    }
+    if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8) {
+        Serial.println("Response is not gzip data");
+        return false;
+    }
+
+    uint8_t flags = header[3];
+    if (flags & GZIP_FLAG_EXTRA) {
+        int low = inputByte();
+        int high = inputByte();
+        if (low < 0 || high < 0) {
+            return false;
+        }
+        for (int remaining = low | (high << 8); remaining > 0; remaining--) {
+            if (inputByte() < 0) {
+                return false;
+            }
+        }
+    }
+
+    // Zero-terminated file name and comment
+    const uint8_t string_flags[] = {GZIP_FLAG_NAME, GZIP_FLAG_COMMENT};
+    for (uint8_t flag : string_flags) {
+        if (!(flags & flag)) {
+            continue;
+        }
+        int c;
+        do {
+            c = inputByte();
+            if (c < 0) {
+                return false;
+            }
+        } while (c != 0);
+    }
+
+    if (flags & GZIP_FLAG_HCRC) {
+        if (inputByte() < 0 || inputByte() < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int InflateStream::nextByte() {
+    while (_out_pos == _out_end) {
+        if (_complete || _error || !_window) {
+            return -1;
+        }
+
+        if (!_header_done) {
+            if (!skipGzipHeader()) {
+                _error = true;
+                return -1;
+            }
+            _header_done = true;
+        }
+
+        // Deflate data ends itself, so input only runs out early on a truncated body.
+        // When the window filled up, the inflater may still have output without new input.
+        if (_needs_input && !fillInput()) {
+            Serial.println("Compressed response ended early");
+            _error = true;
+            return -1;
+        }
+
+        size_t in_bytes = _input_len - _input_pos;
+        size_t out_bytes = WINDOW_SIZE - _window_pos;
+        mz_uint32 flags = TINFL_FLAG_HAS_MORE_INPUT;
+        if (_format == Format::ZLIB) {
+            flags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+        }
+
+        tinfl_status status = tinfl_decompress(_decompressor,
+                                               _input + _input_pos, &in_bytes,
+                                               _window, _window + _window_pos, &out_bytes,
+                                               flags);
+        _input_pos += in_bytes;
+        _bytes_in += in_bytes;
+
+        // New output sits between the old and new window positions; the
+        // window wraps only after it has been read
+        _out_pos = _window_pos;
+        _out_end = _window_pos + out_bytes;
+        _window_pos = (_window_pos + out_bytes) & (WINDOW_SIZE - 1);
+        _bytes_out += out_bytes;
+
+        _needs_input = (status == TINFL_STATUS_NEEDS_MORE_INPUT);
+
+        if (status == TINFL_STATUS_DONE) {
+            // The gzip trailer (CRC32, size) is left for the body stream to drain
+            _complete = true;
+        } else if (status < TINFL_STATUS_DONE) {
+            Serial.printf("Inflate failed with status %d\n", (int)status);
+            _error = true;
+        }
+    }
+
+    return _window[_out_pos++];
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Defined by miniz; kept opaque so callers don't need the ROM headers
+struct tinfl_decompressor_tag;
+
+/**
+ * @class InflateStream
+ * @brief Read-only stream that decompresses a gzip or zlib encoded body
+ *
+ * Sits between the HTTP body and the JSON deserializer. Uses the tinfl
+ * inflater from miniz (built into the ESP32 ROM), with a fixed 32KB
+ * window that doubles as the output buffer, so memory use does not grow
+ * with the response size. The window and decompressor state are taken
+ * from PSRAM when available.
+ *
+ * Reads block for up to the source stream's timeout.
+ */
+class InflateStream : public Stream {
+public:
+    /**
+     * @enum Format
+     * @brief Container around the deflate data
+     */
+    enum class Format {
+        GZIP,   ///< Content-Encoding: gzip (RFC 1952)
+        ZLIB    ///< Content-Encoding: deflate (RFC 1950)
+    };
+
+    /**
+     * @brief Size of the inflate window, fixed by the deflate format
+     */
+    static const size_t WINDOW_SIZE = 32768;
+
+    /**
+     * @brief Constructor
+     *
+     * @param source Stream positioned at the start of the compressed data
+     * @param format Container format
+     */
+    InflateStream(Stream& source, Format format);
+
+    ~InflateStream();
+
+    // Delete copy constructor and assignment operator
+    InflateStream(const InflateStream&) = delete;
+    void operator=(const InflateStream&) = delete;
+
+    /**
+     * @brief Allocate the window and decompressor state
+     * @return false if there wasn't enough memory
+     */
+    bool begin();
+
+    // Stream interface
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+
+    /**
+     * @brief Check if the end of the compressed data was reached
+     */
+    bool isComplete() const { return _complete; }
+
+    /**
+     * @brief Check if the data could not be decoded
+     */
+    bool hasError() const { return _error; }
+
+    /**
+     * @brief Number of compressed bytes consumed so far
+     */
+    size_t bytesIn() const { return _bytes_in; }
+
+    /**
+     * @brief Number of decompressed bytes produced so far
+     */
+    size_t bytesOut() const { return _bytes_out; }
+
+private:
+    Stream& _source;                        ///< Compressed input
+    Format _format;                         ///< Container format
+    tinfl_decompressor_tag* _decompressor;  ///< Inflater state
+    uint8_t* _window;                       ///< Circular dictionary, also the output buffer
+    size_t _window_pos;                     ///< Where the next output lands in the window
+    size_t _out_pos;                        ///< Next unread output byte in the window
+    size_t _out_end;                        ///< End of unread output in the window
+    bool _header_done;                      ///< gzip header skipped
+    bool _complete;                         ///< Final deflate block decoded
+    bool _error;                            ///< Corrupt or truncated input
+    bool _needs_input;                      ///< Inflater consumed all staged input
+    size_t _bytes_in;                       ///< Compressed bytes consumed
+    size_t _bytes_out;                      ///< Decompressed bytes produced
+    int _peeked;                            ///< Byte held back by peek(), or -1
+
+    // Compressed input staging
+    uint8_t _input[512];
+    size_t _input_len;
+    size_t _input_pos;
+
+    /**
+     * @brief Make sure compressed input is staged, waiting up to the timeout
+     * @return false if the source ended or timed out
+     */
+    bool fillInput();
+
+    /**
+     * @brief Take one compressed byte, for header parsing
+     * @return Byte value or -1 if the source ended
+     */
+    int inputByte();
+
+    /**
+     * @brief Skip the gzip member header
+     * @return true if the header was valid
+     */
+    bool skipGzipHeader();
+
+    /**
+     * @brief Produce the next decompressed byte
+     * @return Byte value or -1 at the end or on error
+     */
+    int nextByte();
+};
@@ -0,0 +1,207 @@
+#include "InsightCache.h"
+#include <algorithm>
+#include <time.h>
+
+const char* InsightCache::NAMESPACE = "insight_cache";
+const char* InsightCache::ID_LIST_KEY = "_id_list";
+
+InsightCache::InsightCache()
+    : _mutex(xSemaphoreCreateMutex())
+    , _ready(false) {
+}
+
+InsightCache::~InsightCache() {
+    if (_ready) {
+        _prefs.end();
+    }
+    if (_mutex) {
+        vSemaphoreDelete(_mutex);
+        _mutex = nullptr;
+    }
+}
+
+void InsightCache::begin() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!_ready) {
+        _ready = _prefs.begin(NAMESPACE, false);
+        if (!_ready) {
+            Serial.println("Failed to open insight cache namespace");
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
+
+std::shared_ptr<InsightParser> InsightCache::load(const String& insight_id, uint32_t* stored_at) {
+    if (insight_id.length() == 0 || insight_id.length() > MAX_KEY_LENGTH) {
+        return nullptr;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!_ready || !_prefs.isKey(insight_id.c_str())) {
+        xSemaphoreGive(_mutex);
+        return nullptr;
+    }
+
+    size_t size = _prefs.getBytesLength(insight_id.c_str());
+    if (size < sizeof(EntryHeader) || size > sizeof(EntryHeader) + MAX_ENTRY_BYTES) {
+        xSemaphoreGive(_mutex);
+        return nullptr;
+    }
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+    size_t read = _prefs.getBytes(insight_id.c_str(), buffer.get(), size);
+    xSemaphoreGive(_mutex);
+
+    EntryHeader header;
+    memcpy(&header, buffer.get(), sizeof(header));
+    if (read != size || header.version != ENTRY_VERSION || sizeof(header) + header.length != size) {
+        Serial.printf("Ignoring unreadable cache entry for insight %s\n", insight_id.c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<InsightParser> parser =
+        std::make_shared<InsightParser>(buffer.get() + sizeof(header), header.length);
+    if (!parser->isValid()) {
+        return nullptr;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_entries.find(insight_id) == _entries.end()) {
+        EntryState state;
+        state.digest = header.digest;
+        state.written_at = 0;
+        _entries[insight_id] = state;
+    }
+    xSemaphoreGive(_mutex);
+
+    if (stored_at) {
+        *stored_at = header.stored_at;
+    }
+    return parser;
+}
+
+bool InsightCache::store(const String& insight_id, const InsightParser& parser, uint32_t digest) {
+    if (insight_id.length() == 0 || insight_id.length() > MAX_KEY_LENGTH) {
+        return false;
+    }
+
+    unsigned long now = millis();
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!_ready) {
+        xSemaphoreGive(_mutex);
+        return false;
+    }
+    auto known = _entries.find(insight_id);
+    if (known != _entries.end()) {
+        // Flash wears out; only write real changes, and not every refresh
+        if (known->second.digest == digest ||
+            (known->second.written_at != 0 && now - known->second.written_at < MIN_WRITE_INTERVAL)) {
+            xSemaphoreGive(_mutex);
+            return false;
+        }
+    }
+    xSemaphoreGive(_mutex);
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[sizeof(EntryHeader) + MAX_ENTRY_BYTES]);
+    size_t length = parser.serializeCompact(buffer.get() + sizeof(EntryHeader), MAX_ENTRY_BYTES);
+    if (length == 0) {
+        Serial.printf("Insight %s too large to cache\n", insight_id.c_str());
+        return false;
+    }
+
+    // Only trust the clock once NTP has set it
+    time_t wall_clock = time(nullptr);
+
+    EntryHeader header;
+    header.version = ENTRY_VERSION;
+    header.length = (uint16_t)length;
+    header.digest = digest;
+    header.stored_at = wall_clock > 1600000000 ? (uint32_t)wall_clock : 0;
+    memcpy(buffer.get(), &header, sizeof(header));
+    size_t size = sizeof(header) + length;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    // NVS writes the new copy before erasing the old one, so the whole entry must fit
+    size_t needed_entries = (size + 31) / 32 + 2;
+    if (_prefs.freeEntries() < needed_entries + RESERVED_NVS_ENTRIES) {
+        xSemaphoreGive(_mutex);
+        Serial.printf("Not enough NVS space to cache insight %s\n", insight_id.c_str());
+        return false;
+    }
+
+    bool written = _prefs.putBytes(insight_id.c_str(), buffer.get(), size) == size;
+    if (written) {
+        EntryState state;
+        state.digest = digest;
+        state.written_at = now;
+        _entries[insight_id] = state;
+
+        std::vector<String> ids = readIdList();
+        if (std::find(ids.begin(), ids.end(), insight_id) == ids.end()) {
+            ids.push_back(insight_id);
+            writeIdList(ids);
+        }
+    }
+    xSemaphoreGive(_mutex);
+
+    if (written) {
+        Serial.printf("Cached insight %s (%u bytes)\n", insight_id.c_str(), (unsigned)size);
+    }
+    return written;
+}
+
+void InsightCache::retain(const std::vector<String>& insight_ids) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!_ready) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
+    std::vector<String> ids = readIdList();
+    std::vector<String> kept;
+    for (const String& id : ids) {
+        if (std::find(insight_ids.begin(), insight_ids.end(), id) != insight_ids.end()) {
+            kept.push_back(id);
+        } else {
+            _prefs.remove(id.c_str());
+            _entries.erase(id);
+            Serial.printf("Dropped cached data for removed insight %s\n", id.c_str());
+        }
+    }
+
+    if (kept.size() != ids.size()) {
+        writeIdList(kept);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+std::vector<String> InsightCache::readIdList() {
+    std::vector<String> ids;
+    String list = _prefs.getString(ID_LIST_KEY, "");
+
+    int start = 0;
+    while (start < (int)list.length()) {
+        int end = list.indexOf(',', start);
+        if (end < 0) {
+            end = list.length();
+        }
+        if (end > start) {
+            ids.push_back(list.substring(start, end));
+        }
+        start = end + 1;
+    }
+    return ids;
+}
+
+void InsightCache::writeIdList(const std::vector<String>& ids) {
+    String list;
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (i > 0) {
+            list += ",";
+        }
+        list += ids[i];
+    }
+    _prefs.putString(ID_LIST_KEY, list);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <map>
+#include <memory>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "parsers/InsightParser.h"
+
+/**
+ * @class InsightCache
+ * @brief Last known good insight data kept in flash across reboots
+ *
+ * Features:
+ * - Compact MessagePack copy of each insight's filtered document
+ * - Timestamp and digest stored with each entry
+ * - Writes only when the data changed, at most once per interval per insight
+ * - Leaves a reserve of NVS space free for configuration
+ *
+ * Cards render the cached copy at boot, marked stale, while the live
+ * fetch runs. Entries live in their own NVS namespace. Thread-safe.
+ */
+class InsightCache {
+public:
+    InsightCache();
+    ~InsightCache();
+
+    // Delete copy constructor and assignment operator
+    InsightCache(const InsightCache&) = delete;
+    void operator=(const InsightCache&) = delete;
+
+    /**
+     * @brief Open the cache namespace
+     */
+    void begin();
+
+    /**
+     * @brief Load the cached copy of an insight
+     *
+     * @param insight_id ID of insight
+     * @param stored_at Receives the Unix time the entry was written (0 if the clock was unset); may be null
+     * @return Restored parser, or null if nothing usable is cached
+     */
+    std::shared_ptr<InsightParser> load(const String& insight_id, uint32_t* stored_at = nullptr);
+
+    /**
+     * @brief Save freshly fetched data for an insight
+     *
+     * @param insight_id ID of insight
+     * @param parser Parsed insight
+     * @param digest Content digest of parser
+     * @return true if the entry was written
+     *
+     * Skipped when the digest matches the stored entry, when the entry was
+     * written less than MIN_WRITE_INTERVAL ago, or when the data is too big.
+     */
+    bool store(const String& insight_id, const InsightParser& parser, uint32_t digest);
+
+    /**
+     * @brief Drop entries for insights that are no longer configured
+     * @param insight_ids IDs to keep
+     */
+    void retain(const std::vector<String>& insight_ids);
+
+private:
+    /**
+     * @struct EntryHeader
+     * @brief Stored in front of the MessagePack data of each entry
+     */
+    struct EntryHeader {
+        uint16_t version;       ///< Layout version, ENTRY_VERSION
+        uint16_t length;        ///< Bytes of MessagePack data that follow
+        uint32_t digest;        ///< Content digest of the data
+        uint32_t stored_at;     ///< Unix time of the write, 0 if unknown
+    };
+
+    /**
+     * @struct EntryState
+     * @brief What is known about an entry without reading it back
+     */
+    struct EntryState {
+        uint32_t digest;            ///< Digest of the stored data
+        unsigned long written_at;   ///< millis() of the last write this boot, 0 if none
+    };
+
+    Preferences _prefs;                         ///< Cache namespace
+    SemaphoreHandle_t _mutex;                   ///< Guards everything below
+    bool _ready;                                ///< Namespace opened
+    std::map<String, EntryState> _entries;      ///< Known entries by insight ID
+
+    // Constants
+    static const char* NAMESPACE;                             ///< NVS namespace for entries
+    static const char* ID_LIST_KEY;                           ///< Comma-separated list of cached IDs
+    static const uint16_t ENTRY_VERSION = 1;                  ///< Bumped when the layout changes
+    static const size_t MAX_ENTRY_BYTES = 3072;               ///< Largest MessagePack payload cached
+    static const size_t MAX_KEY_LENGTH = 15;                  ///< NVS key length limit
+    static const size_t RESERVED_NVS_ENTRIES = 64;            ///< Free 32-byte NVS entries left for configuration
+    static const unsigned long MIN_WRITE_INTERVAL = 900000;   ///< At most one write per insight every 15 minutes
+
+    /**
+     * @brief Read the list of cached IDs
+     */
+    std::vector<String> readIdList();
+
+    /**
+     * @brief Write the list of cached IDs
+     */
+    void writeIdList(const std::vector<String>& ids);
+};
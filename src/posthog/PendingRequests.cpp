@@ -0,0 +1,59 @@
+#include "PendingRequests.h"
+#include <algorithm>
+
+PendingRequests::PendingRequests()
+    : _nextSequence(0) {
+}
+
+bool PendingRequests::add(const PendingRequest& request) {
+    auto existing = _requests.find(request.insight_id);
+    if (existing == _requests.end()) {
+        PendingRequest added = request;
+        added.sequence = _nextSequence++;
+        _requests[request.insight_id] = added;
+        return true;
+    }
+
+    // Merge: one fetch serves both, as urgently as the more urgent one asked
+    PendingRequest& merged = existing->second;
+    if (request.phase > merged.phase) {
+        merged.phase = request.phase;
+        merged.query_id = request.query_id;
+        merged.query_started_at = request.query_started_at;
+    }
+    if (request.priority > merged.priority) {
+        merged.priority = request.priority;
+    }
+    if ((long)(request.next_attempt_at - merged.next_attempt_at) < 0) {
+        merged.next_attempt_at = request.next_attempt_at;
+    }
+    if (request.retry_count < merged.retry_count) {
+        merged.retry_count = request.retry_count;
+    }
+    return false;
+}
+
+bool PendingRequests::contains(const String& insight_id) const {
+    return _requests.count(insight_id) > 0;
+}
+
+bool PendingRequests::remove(const String& insight_id) {
+    return _requests.erase(insight_id) > 0;
+}
+
+bool PendingRequests::getReady(unsigned long now, std::vector<PendingRequest>& ready) const {
+    ready.clear();
+    for (const auto& pair : _requests) {
+        if ((long)(now - pair.second.next_attempt_at) >= 0) {
+            ready.push_back(pair.second);
+        }
+    }
+
+    std::sort(ready.begin(), ready.end(), [](const PendingRequest& a, const PendingRequest& b) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        return (int32_t)(a.sequence - b.sequence) < 0;
+    });
+    return !ready.empty();
+}
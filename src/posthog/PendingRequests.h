@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+/**
+ * @enum RequestPriority
+ * @brief How urgently a pending request should be sent
+ */
+enum class RequestPriority : uint8_t {
+    BACKGROUND = 0,     ///< Scheduled refresh of a card that isn't on screen
+    INTERACTIVE = 1     ///< New card, or the card the user is looking at
+};
+
+/**
+ * @enum FetchPhase
+ * @brief Which request an insight fetch is at
+ *
+ * Ordered by progress: merging two requests for the same insight keeps
+ * the one further along.
+ */
+enum class FetchPhase : uint8_t {
+    CACHED = 0,         ///< refresh=force_cache: whatever result the server has cached
+    START_QUERY = 1,    ///< refresh=async: have the server start computing the result
+    POLL_STATUS = 2     ///< Check whether the started query has finished
+};
+
+/**
+ * @struct PendingRequest
+ * @brief An insight request waiting for a worker
+ */
+struct PendingRequest {
+    String insight_id;              ///< ID of insight to fetch
+    uint8_t retry_count;            ///< Number of retry attempts
+    unsigned long next_attempt_at;  ///< millis() before which the request must wait
+    FetchPhase phase;               ///< Request to send
+    RequestPriority priority;       ///< Dispatch order between ready requests
+    uint32_t sequence;              ///< Arrival order, assigned by PendingRequests
+    String query_id;                ///< Query being computed, for POLL_STATUS
+    unsigned long query_started_at; ///< millis() when the query was started, for POLL_STATUS
+};
+
+/**
+ * @class PendingRequests
+ * @brief Set of pending insight requests, at most one per insight
+ *
+ * Adding a request for an insight that is already pending merges the two
+ * instead of queueing a second fetch: the merged request keeps the
+ * phase further along, the higher priority, the earlier attempt time,
+ * the lower retry count and its original place in line. Ready requests are handed out by priority,
+ * then in arrival order.
+ *
+ * Not thread-safe on its own; PostHogClient serializes access.
+ */
+class PendingRequests {
+public:
+    PendingRequests();
+
+    /**
+     * @brief Add a request, merging with a pending one for the same insight
+     *
+     * @param request Request to add; its sequence is ignored
+     * @return true if the insight was not pending before
+     */
+    bool add(const PendingRequest& request);
+
+    /**
+     * @brief Check if a request for an insight is pending
+     * @param insight_id ID of insight
+     */
+    bool contains(const String& insight_id) const;
+
+    /**
+     * @brief Drop the pending request for an insight
+     * @param insight_id ID of insight
+     * @return true if a request was pending
+     */
+    bool remove(const String& insight_id);
+
+    /**
+     * @brief List the requests that can be sent now, most urgent first
+     *
+     * @param now Current time in milliseconds
+     * @param ready Receives the requests; they stay pending until remove()
+     * @return true if any request is ready
+     */
+    bool getReady(unsigned long now, std::vector<PendingRequest>& ready) const;
+
+    /**
+     * @brief Number of pending requests
+     */
+    size_t size() const { return _requests.size(); }
+
+private:
+    std::map<String, PendingRequest> _requests;  ///< Pending requests by insight ID
+    uint32_t _nextSequence;                      ///< Sequence for the next new request
+};
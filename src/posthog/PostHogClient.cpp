@@ -1,32 +1,190 @@
 #include "PostHogClient.h"
 #include "../ConfigManager.h"
+#include <algorithm>
 
 
 
 PostHogClient::PostHogClient(ConfigManager& config, EventQueue& eventQueue) 
     : _config(config)
     , _eventQueue(eventQueue)
-    , has_active_request(false)
-    , last_refresh_check(0) {
-    // Configure secure client for HTTPS
-    _secureClient.setInsecure(); // TODO: get proper cert baked into the firmware to verify these connections
-    _http.setReuse(true);
+    , _rateLimiter(POSTHOG_RATE_LIMIT_PER_MINUTE, POSTHOG_RATE_LIMIT_BURST)
+    , _stateMutex(xSemaphoreCreateMutex())
+    , _lastStatsLog(0)
+    , _resultQueue(xQueueCreate(POSTHOG_MAX_CONCURRENT_FETCHES, sizeof(FetchResult*)))
+    , _psramReserved(0)
+    , _suspended(false)
+    , _suspendedAt(0) {
+    _cache.begin();
+    
+    // Firmware downloads need the TLS memory and bandwidth more than the cards do
+    _eventQueue.subscribe([this](const Event& event) {
+        if (event.type == EventType::OTA_PROCESS_START) {
+            suspend();
+        } else if (event.type == EventType::OTA_PROCESS_END) {
+            resume();
+        }
+    });
+}
+
+PostHogClient::~PostHogClient() {
+    for (FetchWorker* worker : _workers) {
+        worker->stop();
+    }
+    
+    // A worker finishing a request posts its result before it exits, so keep the queue
+    // drained or it could block on a full one
+    FetchResult* result = nullptr;
+    for (FetchWorker* worker : _workers) {
+        while (!worker->isStopped()) {
+            while (_resultQueue && xQueueReceive(_resultQueue, &result, 0) == pdPASS) {
+                delete result;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        delete worker;
+    }
+    _workers.clear();
+    
+    if (_resultQueue) {
+        while (xQueueReceive(_resultQueue, &result, 0) == pdPASS) {
+            delete result;
+        }
+        vQueueDelete(_resultQueue);
+        _resultQueue = nullptr;
+    }
+    
+    if (_stateMutex) {
+        vSemaphoreDelete(_stateMutex);
+        _stateMutex = nullptr;
+    }
 }
 
 String PostHogClient::buildBaseUrl() const {
-    return "https://" + _config.getRegion() + ".posthog.com/api/projects/";
+    String url = "https://" + buildHost();
+    if (POSTHOG_API_PORT != 443) {
+        url += ":" + String(POSTHOG_API_PORT);
+    }
+    return url + "/api/projects/";
+}
+
+String PostHogClient::buildHost() const {
+#ifdef POSTHOG_API_HOST
+    return POSTHOG_API_HOST;
+#else
+    return _config.getRegion() + ".posthog.com";
+#endif
 }
 
 void PostHogClient::requestInsightData(const String& insight_id) {
-    // Add to queue for immediate fetch
-    QueuedRequest request = {
+    PendingRequest request = {
         .insight_id = insight_id,
-        .retry_count = 0
+        .retry_count = 0,
+        .next_attempt_at = millis(),
+        .phase = FetchPhase::CACHED,
+        .priority = RequestPriority::INTERACTIVE,
+        .sequence = 0
     };
-    request_queue.push(request);
     
-    // Add to our set of known insights for future refreshes
-    requested_insights.insert(insight_id);
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    
+    // A request already running will deliver the data; otherwise merge with
+    // whatever is pending so each insight is fetched once
+    if (_inFlight.count(insight_id) == 0) {
+        if (!_pending.add(request)) {
+            Serial.printf("Request for insight %s merged with pending request\n", insight_id.c_str());
+        }
+    }
+    
+    // Whoever asked needs data, so don't suppress the next result as unchanged
+    published_digests.erase(insight_id);
+    
+    // Metadata and the held series stay: a card recreated by a config edit gets
+    // a results-only refresh, and a new insight has none yet so fetches it in full
+    
+    // Add to the schedule for future refreshes
+    _scheduler.addInsight(insight_id, millis());
+    xSemaphoreGive(_stateMutex);
+}
+
+void PostHogClient::requestQueryData(const String& query_key, const String& hogql) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    _queries[query_key] = hogql;
+    xSemaphoreGive(_stateMutex);
+    
+    // From here on a query refreshes exactly like an insight
+    requestInsightData(query_key);
+}
+
+String PostHogClient::queryKey(const String& hogql) {
+    // FNV-1a of the query text, so edited queries never show stale numbers
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < hogql.length(); i++) {
+        hash ^= (uint8_t)hogql[i];
+        hash *= 16777619u;
+    }
+    
+    char key[16];
+    snprintf(key, sizeof(key), "hogql-%08lx", (unsigned long)hash);
+    return String(key);
+}
+
+void PostHogClient::removeInsight(const String& insight_id) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    _scheduler.removeInsight(insight_id);
+    _pending.remove(insight_id);
+    published_digests.erase(insight_id);
+    _serverStale.erase(insight_id);
+    _metadata.erase(insight_id);
+    _series.erase(insight_id);
+    _queries.erase(insight_id);
+    _documentSizes.erase(insight_id);
+    _filterTypes.erase(insight_id);
+    xSemaphoreGive(_stateMutex);
+    
+    _metrics.remove(insight_id);
+}
+
+void PostHogClient::setRefreshPolicy(const String& insight_id, const RefreshPolicy& policy) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    _scheduler.setPolicy(insight_id, policy);
+    xSemaphoreGive(_stateMutex);
+}
+
+bool PostHogClient::publishCachedInsight(const String& insight_id) {
+    // Live data wins; never replace it with the cached copy
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    bool has_live_data = published_digests.count(insight_id) > 0;
+    xSemaphoreGive(_stateMutex);
+    if (has_live_data) {
+        return false;
+    }
+    
+    uint32_t stored_at = 0;
+    std::shared_ptr<InsightParser> parser = _cache.load(insight_id, &stored_at);
+    if (!parser) {
+        return false;
+    }
+    
+    // Not recorded in published_digests, so identical live data still replaces the stale copy
+    Event event(EventType::INSIGHT_DATA_RECEIVED, insight_id, parser);
+    event.stale = true;
+    if (!_eventQueue.publishEvent(event)) {
+        Serial.printf("Event queue full, dropped cached data for %s\n", insight_id.c_str());
+        return false;
+    }
+    
+    Serial.printf("Published cached data for %s (stored at %lu)\n", insight_id.c_str(), (unsigned long)stored_at);
+    return true;
+}
+
+void PostHogClient::retainCachedInsights(const std::vector<String>& insight_ids) {
+    _cache.retain(insight_ids);
+}
+
+void PostHogClient::setVisibleInsight(const String& insight_id) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    _scheduler.setVisibleInsight(insight_id, millis());
+    xSemaphoreGive(_stateMutex);
 }
 
 bool PostHogClient::isReady() const {
@@ -40,216 +198,691 @@ void PostHogClient::process() {
         return;
     }
 
-    // Process any queued requests
-    if (!has_active_request) {
-        processQueue();
+    if (_workers.empty()) {
+        startWorkers();
+    }
+
+    // Finished requests first, so their workers and budget are free again
+    collectResults();
+    
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    bool suspended = checkSuspended();
+    xSemaphoreGive(_stateMutex);
+    if (suspended) {
+        // Workers finishing a request keep their socket; close it once they are idle
+        releaseIdleConnections();
+        return;
     }
+    
+    // Keep as many requests in flight as workers and memory allow
+    dispatchRequests();
 
     // Check for needed refreshes
-    if (!has_active_request) {
-        unsigned long now = millis();
-        if (now - last_refresh_check >= REFRESH_INTERVAL) {
-            last_refresh_check = now;
-            checkRefreshes();
-        }
+    checkRefreshes();
+
+    if (millis() - _lastStatsLog >= STATS_LOG_INTERVAL) {
+        _lastStatsLog = millis();
+        logConnectionStats();
     }
 }
 
-void PostHogClient::onSystemStateChange(SystemState state) {
-    if (!SystemController::isSystemFullyReady() == false) {
-        // Clear any active request when system becomes not ready
-        has_active_request = false;
+void PostHogClient::suspend() {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    if (!_suspended) {
+        Serial.println("Suspending PostHog requests for OTA update");
     }
+    _suspended = true;
+    _suspendedAt = millis();
+    xSemaphoreGive(_stateMutex);
 }
 
-void PostHogClient::processQueue() {
-    if (request_queue.empty()) {
-        return;
+void PostHogClient::resume() {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    if (_suspended) {
+        Serial.println("Resuming PostHog requests");
+    }
+    _suspended = false;
+    xSemaphoreGive(_stateMutex);
+}
+
+bool PostHogClient::checkSuspended() {
+    if (_suspended && millis() - _suspendedAt >= MAX_SUSPEND) {
+        Serial.println("Suspension outlasted any OTA update, resuming PostHog requests");
+        _suspended = false;
     }
+    return _suspended;
+}
 
-    QueuedRequest request = request_queue.front();
-    String response;
+void PostHogClient::releaseIdleConnections() {
+    for (FetchWorker* worker : _workers) {
+        worker->releaseConnection();
+    }
+}
+
+void PostHogClient::startWorkers() {
+    if (_resultQueue == nullptr) {
+        Serial.println("Failed to create fetch result queue");
+        return;
+    }
     
-    if (fetchInsight(request.insight_id, response)) {
-        // Publish to the event system
-        publishInsightDataEvent(request.insight_id, response);
-        request_queue.pop();
-    } else {
-        // Handle failure - retry if under max attempts
-        if (request.retry_count < MAX_RETRIES) {
-            // Update retry count and push back to end of queue
-            request.retry_count++;
-            Serial.printf("Request for insight %s failed, retrying (%d/%d)...\n", 
-                          request.insight_id.c_str(), request.retry_count, MAX_RETRIES);
-            
-            // Remove from front and add to back with incremented retry count
-            request_queue.pop();
-            request_queue.push(request);
-            
-            // Add delay before next attempt
-            delay(RETRY_DELAY);
+    for (uint8_t i = 0; i < POSTHOG_MAX_CONCURRENT_FETCHES; i++) {
+        FetchWorker* worker = new FetchWorker(i, _resultQueue, _connections);
+        if (worker->begin()) {
+            _workers.push_back(worker);
         } else {
-            // Max retries reached, drop request
-            Serial.printf("Max retries reached for insight %s, dropping request\n", 
-                         request.insight_id.c_str());
-            request_queue.pop();
+            delete worker;
         }
     }
+    Serial.printf("Started %u fetch workers (PSRAM budget %u bytes)\n", 
+                  (unsigned)_workers.size(), (unsigned)POSTHOG_FETCH_PSRAM_BUDGET);
 }
 
-void PostHogClient::checkRefreshes() {
-    if (requested_insights.empty()) {
+void PostHogClient::logConnectionStats() {
+    ConnectionManager::Stats stats = _connections.getStats();
+    if (stats.reused_requests + stats.new_requests == 0) {
         return;
     }
     
-    // Pick one insight to refresh
-    String refresh_id;
+    Serial.printf("Connections: DNS %lu lookups / %lu cached, TLS %lu full (avg %lu ms) / %lu resumed (avg %lu ms) of %lu offered\n",
+                  (unsigned long)stats.dns_lookups, (unsigned long)stats.dns_cache_hits,
+                  (unsigned long)stats.full_handshakes,
+                  (unsigned long)(stats.full_handshakes ? stats.handshake_ms_total / stats.full_handshakes : 0),
+                  (unsigned long)stats.resumed_handshakes,
+                  (unsigned long)(stats.resumed_handshakes ? stats.resumed_ms_total / stats.resumed_handshakes : 0),
+                  (unsigned long)stats.offered_sessions);
+    Serial.printf("Requests: %lu on new connections (avg %lu ms), %lu on reused (avg %lu ms)\n",
+                  (unsigned long)stats.new_requests,
+                  (unsigned long)(stats.new_requests ? stats.new_request_ms_total / stats.new_requests : 0),
+                  (unsigned long)stats.reused_requests,
+                  (unsigned long)(stats.reused_requests ? stats.reused_request_ms_total / stats.reused_requests : 0));
+}
+
+void PostHogClient::writeMetrics(JsonObject out) {
+    out["region"] = _config.getRegion();
+    _metrics.writeJson(out.createNestedObject("insights"));
+    
+    ConnectionManager::Stats stats = _connections.getStats();
+    JsonObject connections = out.createNestedObject("connections");
+    connections["dns_lookups"] = stats.dns_lookups;
+    connections["dns_cache_hits"] = stats.dns_cache_hits;
+    connections["full_handshakes"] = stats.full_handshakes;
+    connections["full_handshake_avg_ms"] = stats.full_handshakes ? stats.handshake_ms_total / stats.full_handshakes : 0;
+    connections["resumed_handshakes"] = stats.resumed_handshakes;
+    connections["resumed_handshake_avg_ms"] = stats.resumed_handshakes ? stats.resumed_ms_total / stats.resumed_handshakes : 0;
+    connections["offered_sessions"] = stats.offered_sessions;
+    connections["reused_requests"] = stats.reused_requests;
+    connections["new_requests"] = stats.new_requests;
+}
+
+void PostHogClient::writeRateLimitStats(JsonObject out) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    RateLimiter::Stats stats = _rateLimiter.getStats(millis());
+    xSemaphoreGive(_stateMutex);
+    
+    out["rate_per_minute"] = stats.rate_per_minute;
+    out["max_rate_per_minute"] = stats.max_rate_per_minute;
+    out["tokens"] = stats.tokens;
+    out["paused_for_ms"] = stats.paused_for_ms;
+    out["requests_sent"] = stats.requests_sent;
+    out["throttled_responses"] = stats.throttled_responses;
+    out["last_retry_after_ms"] = stats.last_retry_after_ms;
+}
+
+void PostHogClient::dispatchRequests() {
+    if (WiFi.status() != WL_CONNECTED) {
+        return;
+    }
     
-    // This cycles through insights in a round-robin fashion since sets are ordered
-    static auto it = requested_insights.begin();
-    if (it == requested_insights.end()) {
-        it = requested_insights.begin();
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    unsigned long now = millis();
+    String host = buildHost();
+    
+    // Ready requests, most urgent first
+    std::vector<PendingRequest> ready;
+    if (!_pending.getReady(now, ready)) {
+        xSemaphoreGive(_stateMutex);
+        return;
     }
     
-    if (it != requested_insights.end()) {
-        refresh_id = *it;
-        ++it;
-    } else {
-        // Reset if we're at the end
-        it = requested_insights.begin();
-        if (it != requested_insights.end()) {
-            refresh_id = *it;
-            ++it;
+    auto worker = _workers.begin();
+    for (const PendingRequest& request : ready) {
+        while (worker != _workers.end() && !(*worker)->isIdle()) {
+            ++worker;
+        }
+        if (worker == _workers.end()) {
+            break;
+        }
+        
+        // Stay within the configured budget and what the heap can actually provide.
+        // A large insight that doesn't fit waits without holding back smaller ones.
+        size_t capacity = documentCapacityFor(request);
+        if (_psramReserved + capacity + FETCH_PSRAM_PER_CONNECTION > (size_t)POSTHOG_FETCH_PSRAM_BUDGET ||
+            ESP.getMaxAllocPsram() < capacity) {
+            continue;
         }
+        
+        // Checked before the breaker, which admits its probe as soon as it's asked
+        if (!_rateLimiter.hasToken(now)) {
+            break;
+        }
+        
+        if (!_breakers[host].allowRequest(now)) {
+            break;
+        }
+        
+        FetchJob* job = new FetchJob();
+        job->insight_id = request.insight_id;
+        job->host = host;
+        job->port = POSTHOG_API_PORT;
+        job->phase = request.phase;
+        job->document_capacity = capacity;
+        job->size_from_body = (_documentSizes.count(request.insight_id) == 0);
+        auto filter = _filterTypes.find(request.insight_id);
+        job->filter = (filter != _filterTypes.end()) ? filter->second : InsightParser::FilterType::FULL;
+        prepareJob(*job, request, now);
+        
+        // A worker that can't take the job is skipped; the request stays pending
+        bool submitted = (*worker)->submit(job);
+        ++worker;
+        if (!submitted) {
+            delete job;
+            // Otherwise a half-open breaker waits forever for a probe that was never sent
+            _breakers[host].abortProbe();
+            continue;
+        }
+        
+        _rateLimiter.consume();
+        _inFlight[request.insight_id] = request;
+        _psramReserved += capacity + FETCH_PSRAM_PER_CONNECTION;
+        _pending.remove(request.insight_id);
     }
     
-    if (!refresh_id.isEmpty()) {
-        String response;
-        if (fetchInsight(refresh_id, response)) {
-            // Publish to the event system
-            publishInsightDataEvent(refresh_id, response);
+    xSemaphoreGive(_stateMutex);
+}
+
+void PostHogClient::prepareJob(FetchJob& job, const PendingRequest& request, unsigned long now) {
+    if (request.phase == FetchPhase::POLL_STATUS) {
+        job.url = buildQueryStatusUrl(request.query_id);
+        return;
+    }
+    
+    const char* refresh_mode = (request.phase == FetchPhase::START_QUERY) ? "async" : "force_cache";
+    
+    // HogQL cards always go through the query API; the server does the aggregation
+    auto query = _queries.find(request.insight_id);
+    if (query != _queries.end()) {
+        HogQLParser::getQueryRequestBody(query->second, refresh_mode, job.body);
+        job.url = buildQueryUrl();
+        job.hogql = true;
+        return;
+    }
+    
+    // With the insight's metadata at hand only the results need to come down,
+    // and for a series we already hold, only its newest buckets
+    auto metadata = _metadata.find(request.insight_id);
+    if (metadata != _metadata.end() && now - metadata->second.fetched_at < METADATA_MAX_AGE) {
+        const InsightParser& source = *metadata->second.parser;
+        if (_series.count(request.insight_id) > 0 && source.getSeriesTailRequestBody(refresh_mode, job.body)) {
+            job.series_tail = true;
+        }
+        if (job.series_tail || source.getQueryRequestBody(refresh_mode, job.body)) {
+            job.url = buildQueryUrl();
+            job.metadata = metadata->second.parser;
+            return;
         }
     }
+    
+    job.url = buildInsightUrl(request.insight_id, refresh_mode);
 }
 
-String PostHogClient::buildInsightUrl(const String& insight_id, const char* refresh_mode) const {
-    String url = buildBaseUrl();
-    url += String(_config.getTeamId());
-    url += "/insights/?refresh=";
-    url += refresh_mode;
-    url += "&short_id=";
-    url += insight_id;
-    url += "&personal_api_key=";
-    url += _config.getApiKey();
-    return url;
+size_t PostHogClient::documentCapacityFor(const PendingRequest& request) const {
+    if (request.phase == FetchPhase::POLL_STATUS || _queries.count(request.insight_id) > 0) {
+        return 0;
+    }
+    
+    auto size = _documentSizes.find(request.insight_id);
+    if (size == _documentSizes.end()) {
+        return InsightParser::DOCUMENT_CAPACITY;
+    }
+    
+    size_t capacity = size->second + size->second / 4 + DOCUMENT_HEADROOM;
+    if (capacity < InsightParser::MIN_DOCUMENT_CAPACITY) {
+        return InsightParser::MIN_DOCUMENT_CAPACITY;
+    }
+    if (capacity > InsightParser::MAX_DOCUMENT_CAPACITY) {
+        return InsightParser::MAX_DOCUMENT_CAPACITY;
+    }
+    return capacity;
 }
 
-bool PostHogClient::fetchInsight(const String& insight_id, String& response) {
-    if (!isReady() || WiFi.status() != WL_CONNECTED) {
-        return false;
+void PostHogClient::recordDocumentSize(const String& insight_id, const RequestTiming& timing) {
+    size_t used = timing.document_overflow ? timing.document_capacity * 2 : timing.document_bytes;
+    
+    auto size = _documentSizes.find(insight_id);
+    if (size == _documentSizes.end() || used >= size->second) {
+        _documentSizes[insight_id] = used;
+    } else {
+        size->second -= (size->second - used) / 4;
     }
+}
 
-    unsigned long start_time = millis();
-    has_active_request = true;
+void PostHogClient::collectResults() {
+    FetchResult* result = nullptr;
+    while (xQueueReceive(_resultQueue, &result, 0) == pdPASS) {
+        handleResult(*result);
+        delete result;
+        result = nullptr;
+    }
+}
+
+void PostHogClient::handleResult(FetchResult& result) {
+    // Keep what the card needs besides the result, so later refreshes can skip it.
+    // Copied before taking the lock since it allocates.
+    std::shared_ptr<InsightParser> metadata;
+    if (result.parser && !result.results_only) {
+        metadata = result.parser->copyMetadata();
+    }
+    
+    // Splice the newest buckets onto the series we hold
+    bool merge_failed = false;
+    if (result.series_tail && result.parser && result.parser->hasResultData()) {
+        xSemaphoreTake(_stateMutex, portMAX_DELAY);
+        auto held = _series.find(result.insight_id);
+        std::shared_ptr<InsightParser> series = (held != _series.end()) ? held->second : nullptr;
+        xSemaphoreGive(_stateMutex);
+        
+        std::shared_ptr<InsightParser> merged = series ? series->mergeSeriesTail(*result.parser) : nullptr;
+        if (merged) {
+            result.parser = merged;
+        } else {
+            merge_failed = true;
+        }
+    }
     
-    // First, try to get cached data
-    String url = buildInsightUrl(insight_id, "force_cache");
+    // Keep a compact copy of a full series so later refreshes can fetch just its tail
+    std::shared_ptr<InsightParser> series_copy;
+    if (!merge_failed && result.parser && result.parser->hasResultData()) {
+        InsightParser::InsightType type = result.parser->getInsightType();
+        if (type == InsightParser::InsightType::LINE_GRAPH || type == InsightParser::InsightType::AREA_CHART) {
+            series_copy = result.series_tail ? result.parser : result.parser->copyCompact();
+        }
+    }
     
-    _http.begin(_secureClient, url);
-    int httpCode = _http.GET();
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    unsigned long now = millis();
     
-    bool success = false;
-    bool needsRefresh = false;
+    PendingRequest request = {
+        .insight_id = result.insight_id,
+        .retry_count = 0,
+        .next_attempt_at = now,
+        .phase = result.phase,
+        .priority = RequestPriority::BACKGROUND,
+        .sequence = 0
+    };
+    auto in_flight = _inFlight.find(result.insight_id);
+    if (in_flight != _inFlight.end()) {
+        request = in_flight->second;
+        _inFlight.erase(in_flight);
+    }
+    size_t reserved = result.document_capacity + FETCH_PSRAM_PER_CONNECTION;
+    _psramReserved = (_psramReserved >= reserved) ? _psramReserved - reserved : 0;
     
-    if (httpCode == HTTP_CODE_OK) {
-        unsigned long network_time = millis() - start_time;
-        Serial.printf("Network fetch time for %s: %lu ms\n", insight_id.c_str(), network_time);
-        
-        start_time = millis();
-        
-        // Get content length for allocation
-        size_t contentLength = _http.getSize();
+    // Only transport errors and 5xx say anything about the host
+    String host = buildHost();
+    if (isHostFailure(result.http_code)) {
+        _breakers[host].recordFailure(now);
+    } else {
+        _breakers[host].recordSuccess();
+    }
+    
+    // Slow down on 429s and creep back up on anything else the server answered
+    bool throttled = (result.http_code == HTTP_CODE_TOO_MANY_REQUESTS);
+    if (throttled) {
+        _rateLimiter.recordThrottled(now, result.retry_after_ms);
+    } else if (result.http_code > 0) {
+        _rateLimiter.recordSuccess();
+    }
+    
+    bool still_tracked = _scheduler.hasInsight(request.insight_id);
+    if (still_tracked && result.http_code == HTTP_CODE_OK) {
+        _metrics.record(request.insight_id, result.timing);
         
-        // Pre-allocate in PSRAM if content is large
-        if (contentLength > 8192) { // 8KB threshold
-            // Force allocation in PSRAM for large responses
-            response = String();
-            response.reserve(contentLength);
-            Serial.printf("Pre-allocated %u bytes in PSRAM for large response\n", contentLength);
+        // Series tails are a fraction of the full range, so they'd undersize the next full fetch
+        if (result.timing.document_capacity > 0 && !result.series_tail) {
+            recordDocumentSize(request.insight_id, result.timing);
         }
         
-        response = _http.getString();
-        unsigned long string_time = millis() - start_time;
-        Serial.printf("Response processing time: %lu ms (size: %u bytes)\n", string_time, response.length());
-        
-        // Quick check if we need to refresh (look for null result)
-        if (response.indexOf("\"result\":null") >= 0 || 
-            response.indexOf("\"result\":[]") >= 0) {
-            needsRefresh = true;
-        } else {
-            success = true;
+        // Parse the next response with only what this type reads; a parse that
+        // failed, perhaps because the narrow filter no longer fits, retries in full
+        if (result.parser && result.parser->hasResultData()) {
+            _filterTypes[request.insight_id] = result.parser->getFilterType();
+        } else if (!result.parser && !result.query_result && result.phase != FetchPhase::POLL_STATUS) {
+            _filterTypes.erase(request.insight_id);
         }
+    }
+    bool publish = false;
+    bool succeeded;
+    if (result.phase == FetchPhase::POLL_STATUS) {
+        succeeded = result.query_status.valid;
     } else {
-        // Handle HTTP errors
-        Serial.print("HTTP GET failed, error: ");
-        Serial.println(httpCode);
+        succeeded = (result.parser != nullptr) || (result.query_result != nullptr);
     }
     
-    _http.end();
+    if (still_tracked && metadata) {
+        _metadata[request.insight_id] = {metadata, now};
+    } else if (result.results_only && !throttled && result.http_code >= 400 && result.http_code < 500) {
+        // The stored query was rejected (e.g. the insight was edited); fetch it whole next time
+        _metadata.erase(request.insight_id);
+    }
     
-    // If we need to refresh, make a second request with blocking
-    if (needsRefresh) {
-        url = buildInsightUrl(insight_id, "blocking");
-        
-        unsigned long refresh_start = millis();
-        _http.begin(_secureClient, url);
-        httpCode = _http.GET();
-        
-        if (httpCode == HTTP_CODE_OK) {
-            unsigned long refresh_network = millis() - refresh_start;
-            Serial.printf("Refresh network time: %lu ms\n", refresh_network);
-            
-            refresh_start = millis();
-            
-            // Get content length for allocation
-            size_t contentLength = _http.getSize();
+    if (!still_tracked) {
+        // Card was removed while the request was running
+    } else if (throttled) {
+        // Not the request's fault, so it keeps its retry budget and goes out after the pause
+        RateLimiter::Stats limits = _rateLimiter.getStats(now);
+        request.next_attempt_at = now + limits.paused_for_ms;
+        _pending.add(request);
+    } else if (merge_failed) {
+        // Gap since the last refresh (or the series changed shape); fetch the whole range
+        Serial.printf("Series tail for insight %s didn't fit, fetching full range\n", request.insight_id.c_str());
+        _series.erase(request.insight_id);
+        request.phase = FetchPhase::CACHED;
+        request.next_attempt_at = now;
+        _pending.add(request);
+    } else if (succeeded && result.phase == FetchPhase::POLL_STATUS) {
+        followQuery(request, result.query_status, now);
+    } else if (succeeded) {
+        bool has_data = result.parser ? result.parser->hasResultData() : result.query_result->hasResultData();
+        if (has_data) {
+            applyServerFreshness(request.insight_id, result);
+            publish = true;
             
-            // Pre-allocate in PSRAM if content is large
-            if (contentLength > 8192) { // 8KB threshold
-                // Force allocation in PSRAM for large responses
-                response = String();
-                response.reserve(contentLength);
-                Serial.printf("Pre-allocated %u bytes in PSRAM for refresh response\n", contentLength);
+            if (series_copy) {
+                _series[request.insight_id] = series_copy;
+            } else {
+                _series.erase(request.insight_id);
             }
-            
-            response = _http.getString();
-            unsigned long refresh_string = millis() - refresh_start;
-            Serial.printf("Refresh string time: %lu ms (size: %u bytes)\n", refresh_string, response.length());
-            
-            success = true;
+        }
+        
+        if (result.phase == FetchPhase::START_QUERY && result.query_status.valid &&
+            !(has_data && result.query_status.complete)) {
+            // The server is computing; poll for it rather than holding a connection open.
+            // A finished query that came back with its result needs no follow-up fetch.
+            followQuery(request, result.query_status, now);
+        } else if (!has_data && result.phase == FetchPhase::CACHED) {
+            if (request.retry_count < MAX_RETRIES) {
+                // Cold cache: have the server compute the result in the background
+                Serial.printf("No cached result for insight %s, starting async query\n", request.insight_id.c_str());
+                request.phase = FetchPhase::START_QUERY;
+                request.next_attempt_at = now;
+                request.priority = RequestPriority::INTERACTIVE;
+                _pending.add(request);
+            } else {
+                Serial.printf("Insight %s still has no cached result, dropping request\n", request.insight_id.c_str());
+            }
+        } else if (!has_data) {
+            Serial.printf("Async refresh of insight %s returned no result and no query to poll\n", request.insight_id.c_str());
+        }
+    } else if (request.retry_count < MAX_RETRIES) {
+        // Handle failure - retry later if under max attempts
+        request.retry_count++;
+        unsigned long retry_delay = computeRetryDelay(request.retry_count);
+        request.next_attempt_at = now + retry_delay;
+        Serial.printf("Request for insight %s failed (%d), retrying in %lu ms (%d/%d)...\n", 
+                      request.insight_id.c_str(), result.http_code, retry_delay, request.retry_count, MAX_RETRIES);
+        _pending.add(request);
+    } else {
+        // Max retries reached, drop request; the scheduler will try again later
+        Serial.printf("Max retries reached for insight %s, dropping request\n", 
+                     request.insight_id.c_str());
+    }
+    xSemaphoreGive(_stateMutex);
+    
+    if (publish) {
+        Serial.printf("Fetched insight %s in %lu ms\n", request.insight_id.c_str(), result.elapsed_ms);
+        if (result.query_result) {
+            publishQueryDataEvent(request.insight_id, result.query_result);
         } else {
-            // Handle HTTP errors
-            Serial.print("HTTP GET (blocking) failed, error: ");
-            Serial.println(httpCode);
+            publishInsightDataEvent(request.insight_id, result.parser);
+        }
+    }
+}
+
+void PostHogClient::followQuery(PendingRequest request, const QueryStatus& status, unsigned long now) {
+    if (status.error) {
+        Serial.printf("Query for insight %s failed on the server\n", request.insight_id.c_str());
+        return;
+    }
+    
+    if (status.complete) {
+        // The result is in the server cache now; fetch it like any cached insight.
+        // Counted as an attempt so a cache that never fills can't loop forever.
+        if (request.retry_count >= MAX_RETRIES) {
+            Serial.printf("Max retries reached for insight %s, dropping request\n", request.insight_id.c_str());
+            return;
+        }
+        request.retry_count++;
+        request.phase = FetchPhase::CACHED;
+        request.query_id = "";
+        request.next_attempt_at = now;
+        _pending.add(request);
+        return;
+    }
+    
+    if (request.phase != FetchPhase::POLL_STATUS) {
+        request.phase = FetchPhase::POLL_STATUS;
+        request.query_id = status.id;
+        request.query_started_at = now;
+    }
+    
+    unsigned long waited = now - request.query_started_at;
+    if (waited >= MAX_QUERY_WAIT) {
+        Serial.printf("Query for insight %s still running after %lu s, giving up\n", 
+                      request.insight_id.c_str(), waited / 1000);
+        return;
+    }
+    
+    // Poll quickly at first, then back off as the query turns out to be slow
+    unsigned long poll_delay = waited / 4;
+    if (poll_delay < QUERY_POLL_MIN_INTERVAL) {
+        poll_delay = QUERY_POLL_MIN_INTERVAL;
+    } else if (poll_delay > QUERY_POLL_MAX_INTERVAL) {
+        poll_delay = QUERY_POLL_MAX_INTERVAL;
+    }
+    request.next_attempt_at = now + poll_delay;
+    _pending.add(request);
+}
+
+void PostHogClient::applyServerFreshness(const String& insight_id, const FetchResult& result) {
+    // Compare against the server's own clock; fall back to ours once NTP has set it
+    time_t server_now = result.server_time;
+    if (server_now == 0) {
+        time_t local_now = time(nullptr);
+        if (local_now < MIN_VALID_CLOCK) {
+            _scheduler.clearNotBefore(insight_id);
+            return;
+        }
+        server_now = local_now;
+    }
+    
+    time_t next_allowed = 0;
+    bool has_next_allowed = result.parser ? result.parser->getNextAllowedClientRefresh(&next_allowed)
+                                          : result.query_result->getNextAllowedClientRefresh(&next_allowed);
+    if (has_next_allowed && next_allowed > server_now) {
+        time_t hold_seconds = next_allowed - server_now;
+        unsigned long hold = (hold_seconds > (time_t)(MAX_SERVER_HOLD / 1000)) ? MAX_SERVER_HOLD : (unsigned long)hold_seconds * 1000UL;
+        _scheduler.setNotBefore(insight_id, result.received_at + hold);
+        Serial.printf("Insight %s can't change for %lu s, holding polls\n", insight_id.c_str(), hold / 1000);
+    } else {
+        _scheduler.clearNotBefore(insight_id);
+    }
+    
+    // A force_cache poll keeps returning an expired result; ask for a recompute instead
+    time_t target_age = 0;
+    bool has_target_age = result.parser ? result.parser->getCacheTargetAge(&target_age)
+                                        : result.query_result->getCacheTargetAge(&target_age);
+    if (has_target_age && server_now >= target_age) {
+        _serverStale.insert(insight_id);
+    } else {
+        _serverStale.erase(insight_id);
+    }
+}
+
+void PostHogClient::checkRefreshes() {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    
+    // Leave due insights due while the server has asked us to back off
+    if (_rateLimiter.isPaused(millis())) {
+        xSemaphoreGive(_stateMutex);
+        return;
+    }
+    
+    // Active hours are in UTC; until NTP has set the clock every hour counts as active
+    time_t wall_clock = time(nullptr);
+    int utc_hour = -1;
+    if (wall_clock >= MIN_VALID_CLOCK) {
+        struct tm utc;
+        gmtime_r(&wall_clock, &utc);
+        utc_hour = utc.tm_hour;
+    }
+    
+    // Queue the most urgent due insight; it goes through the normal request path
+    String refresh_id;
+    unsigned long now = millis();
+    if (_scheduler.getDueInsight(now, utc_hour, refresh_id)) {
+        // A running request already covers this refresh; a pending one absorbs it
+        if (_inFlight.count(refresh_id) == 0) {
+            PendingRequest request = {
+                .insight_id = refresh_id,
+                .retry_count = 0,
+                .next_attempt_at = now,
+                .phase = _serverStale.count(refresh_id) > 0 ? FetchPhase::START_QUERY : FetchPhase::CACHED,
+                .priority = _scheduler.isVisible(refresh_id) ? RequestPriority::INTERACTIVE : RequestPriority::BACKGROUND,
+                .sequence = 0
+            };
+            _pending.add(request);
         }
         
-        _http.end();
+        // Don't hand out the same insight again while this refresh is pending
+        _scheduler.markRefreshed(refresh_id, now);
+    }
+    
+    xSemaphoreGive(_stateMutex);
+}
+
+unsigned long PostHogClient::computeRetryDelay(uint8_t retry_count) {
+    // Exponential: base, 2x base, 4x base, ... capped at the ceiling
+    unsigned long backoff = RETRY_BASE_DELAY;
+    for (uint8_t i = 1; i < retry_count && backoff < RETRY_MAX_DELAY; i++) {
+        backoff *= 2;
+    }
+    if (backoff > RETRY_MAX_DELAY) {
+        backoff = RETRY_MAX_DELAY;
     }
     
-    has_active_request = false;
-    return success;
+    // Jitter over the upper half so devices on the same network don't retry in lockstep
+    return backoff / 2 + random(backoff / 2 + 1);
 }
 
-void PostHogClient::publishInsightDataEvent(const String& insight_id, const String& response) {
-    // Check if response is empty or invalid
-    if (response.length() == 0) {
-        Serial.printf("Empty response for insight %s\n", insight_id.c_str());
+bool PostHogClient::isHostFailure(int http_code) {
+    return http_code < 0 || http_code >= 500;
+}
+
+String PostHogClient::buildInsightUrl(const String& insight_id, const char* refresh_mode) const {
+    String url = buildBaseUrl();
+    url += String(_config.getTeamId());
+    url += "/insights/?refresh=";
+    url += refresh_mode;
+    url += "&short_id=";
+    url += insight_id;
+    url += "&personal_api_key=";
+    url += _config.getApiKey();
+    return url;
+}
+
+String PostHogClient::buildQueryStatusUrl(const String& query_id) const {
+    String url = buildBaseUrl();
+    url += String(_config.getTeamId());
+    url += "/query/";
+    url += query_id;
+    url += "/?personal_api_key=";
+    url += _config.getApiKey();
+    return url;
+}
+
+String PostHogClient::buildQueryUrl() const {
+    String url = buildBaseUrl();
+    url += String(_config.getTeamId());
+    url += "/query/?personal_api_key=";
+    url += _config.getApiKey();
+    return url;
+}
+
+void PostHogClient::publishInsightDataEvent(const String& insight_id, std::shared_ptr<InsightParser> parser) {
+    if (!parser) {
+        Serial.printf("No parsed data for insight %s\n", insight_id.c_str());
+        return;
+    }
+    
+    // Skip publishing if nothing the cards display has changed since last time
+    uint32_t digest = parser->getContentDigest();
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    auto it = published_digests.find(insight_id);
+    bool unchanged = (it != published_digests.end() && it->second == digest);
+    xSemaphoreGive(_stateMutex);
+    if (unchanged) {
+        Serial.printf("Insight %s unchanged (digest %08lx), skipping publish\n", insight_id.c_str(), (unsigned long)digest);
+        return;
+    }
+    
+    // Publish the event with the already-parsed insight
+    if (!_eventQueue.publishEvent(EventType::INSIGHT_DATA_RECEIVED, insight_id, parser)) {
+        Serial.printf("Event queue full, dropped data for %s\n", insight_id.c_str());
         return;
     }
     
-    // Publish the event with the raw JSON response
-    _eventQueue.publishEvent(EventType::INSIGHT_DATA_RECEIVED, insight_id, response);
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    published_digests[insight_id] = digest;
+    xSemaphoreGive(_stateMutex);
+    
+    // Keep a copy for the next boot
+    _cache.store(insight_id, *parser, digest);
     
     // Log for debugging
-    Serial.printf("Published raw JSON data for %s\n", insight_id.c_str());
-} 
\ No newline at end of file
+    Serial.printf("Published parsed data for %s\n", insight_id.c_str());
+}
+
+void PostHogClient::publishQueryDataEvent(const String& query_key, std::shared_ptr<HogQLParser> parser) {
+    if (!parser) {
+        Serial.printf("No parsed data for query %s\n", query_key.c_str());
+        return;
+    }
+    
+    uint32_t digest = parser->getContentDigest();
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    auto it = published_digests.find(query_key);
+    bool unchanged = (it != published_digests.end() && it->second == digest);
+    xSemaphoreGive(_stateMutex);
+    if (unchanged) {
+        Serial.printf("Query %s unchanged (digest %08lx), skipping publish\n", query_key.c_str(), (unsigned long)digest);
+        return;
+    }
+    
+    // Cards only need the number and its label, so the parser isn't passed along
+    Event event(EventType::QUERY_DATA_RECEIVED, query_key);
+    event.value = parser->getValue();
+    char column[64];
+    if (parser->getColumnName(column, sizeof(column))) {
+        event.title = column;
+    }
+    if (!_eventQueue.publishEvent(event)) {
+        Serial.printf("Event queue full, dropped data for %s\n", query_key.c_str());
+        return;
+    }
+    
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    published_digests[query_key] = digest;
+    xSemaphoreGive(_stateMutex);
+    
+    Serial.printf("Published query result for %s\n", query_key.c_str());
+}
@@ -3,26 +3,66 @@
 #include <Arduino.h>
 #include <HTTPClient.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <queue>
 #include <vector>
+#include <map>
 #include <set>
 #include <memory>
 #include "../ConfigManager.h"
 #include "SystemController.h"
 #include "EventQueue.h"
 #include "parsers/InsightParser.h"
+#include "RefreshScheduler.h"
+#include "CircuitBreaker.h"
+#include "RateLimiter.h"
+#include "FetchWorker.h"
+#include "ConnectionManager.h"
+#include "InsightCache.h"
+#include "InflateStream.h"
+#include "PendingRequests.h"
+
+// Fetch engine limits, overridable from build_flags (e.g. -DPOSTHOG_MAX_CONCURRENT_FETCHES=3)
+#ifndef POSTHOG_MAX_CONCURRENT_FETCHES
+#define POSTHOG_MAX_CONCURRENT_FETCHES 2
+#endif
+
+#ifndef POSTHOG_FETCH_PSRAM_BUDGET
+#define POSTHOG_FETCH_PSRAM_BUDGET (320 * 1024)
+#endif
+
+// Request rate across all cards; PostHog limits analytics endpoints per team
+#ifndef POSTHOG_RATE_LIMIT_PER_MINUTE
+#define POSTHOG_RATE_LIMIT_PER_MINUTE 20
+#endif
+
+#ifndef POSTHOG_RATE_LIMIT_BURST
+#define POSTHOG_RATE_LIMIT_BURST 10
+#endif
+
+// Point the client at another server, such as mock_posthog.py on the local network
+// (e.g. -DPOSTHOG_API_HOST="\"192.168.1.20\"" -DPOSTHOG_API_PORT=8443); the region is ignored when set
+#ifndef POSTHOG_API_PORT
+#define POSTHOG_API_PORT 443
+#endif
 
 /**
  * @class PostHogClient
  * @brief Client for fetching PostHog insight data
  * 
  * Features:
- * - Queued insight requests with retry logic
- * - Automatic refresh of insights
+ * - Several requests in flight at once, each on its own worker and connection
+ * - PSRAM budget so concurrent parses can't exhaust memory
+ * - Deduplicated, prioritized insight requests with non-blocking exponential backoff
+ * - Per-host circuit breaker so a dead host doesn't spin the pipeline
+ * - Shared token bucket that slows down and pauses on 429 responses
+ * - Visibility-aware refresh scheduling of insights
  * - Thread-safe operation with event queue
  * - Configurable retry and refresh intervals
  * - Support for multiple insight types
+ * - Change detection so unchanged insights are not re-published
+ * - Last known good data kept in flash for instant display after boot
+ * - Per-insight request timing metrics
+ * - Cold and stale results computed with async queries, polled until ready
+ * - Metadata fetched once per card; refreshes download only the results
  */
 class PostHogClient {
 public:
@@ -34,6 +74,15 @@ public:
      */
     explicit PostHogClient(ConfigManager& config, EventQueue& eventQueue);
     
+    /**
+     * @brief Destructor
+     * 
+     * Stops the fetch workers, waiting for requests in flight to finish,
+     * and drops their results. The OTA subscription stays registered with
+     * the event queue, so stop the queue with end() first.
+     */
+    ~PostHogClient();
+    
     // Delete copy constructor and assignment operator
     PostHogClient(const PostHogClient&) = delete;
     void operator=(const PostHogClient&) = delete;
@@ -43,11 +92,76 @@ public:
      * 
      * @param insight_id ID of insight to fetch
      * 
-     * Adds insight to request queue with retry count of 0.
-     * Will be processed in FIFO order.
+     * Adds an interactive-priority request, merged with any request already
+     * pending for the insight; nothing is queued if one is already running.
+     * The stored digest is cleared so the result is published even if it
+     * matches the previous one. The insight is also added to the refresh schedule.
      */
     void requestInsightData(const String& insight_id);
     
+    /**
+     * @brief Queue a HogQL query for fetching and refreshing
+     * 
+     * @param query_key Key from queryKey(), used in place of an insight ID
+     * @param hogql Query text; should return a single aggregate row
+     * 
+     * The query is sent to the query API and only its first cell comes
+     * back, published as a QUERY_DATA_RECEIVED event. It is scheduled,
+     * retried and removed (via removeInsight) like an insight.
+     */
+    void requestQueryData(const String& query_key, const String& hogql);
+    
+    /**
+     * @brief Derive the key a HogQL query is tracked and published under
+     * 
+     * @param hogql Query text
+     * @return "hogql-" followed by a hash of the query
+     */
+    static String queryKey(const String& hogql);
+    
+    /**
+     * @brief Stop refreshing an insight
+     * 
+     * @param insight_id ID of insight whose card was removed
+     */
+    void removeInsight(const String& insight_id);
+
+    /**
+     * @brief Apply a card's refresh policy to its insight or query
+     * 
+     * @param insight_id ID of insight, or query key; must already be requested
+     * @param policy Refresh policy from the card's configuration
+     */
+    void setRefreshPolicy(const String& insight_id, const RefreshPolicy& policy);
+
+    /**
+     * @brief Publish the cached copy of an insight, marked stale
+     * 
+     * @param insight_id ID of insight
+     * @return true if cached data was found and published
+     * 
+     * Lets a card show its last known data straight after boot while the
+     * live fetch is still pending. Does nothing once live data was published.
+     */
+    bool publishCachedInsight(const String& insight_id);
+
+    /**
+     * @brief Drop cached data for insights that are no longer configured
+     * 
+     * @param insight_ids IDs of all configured insights
+     */
+    void retainCachedInsights(const std::vector<String>& insight_ids);
+    
+    /**
+     * @brief Tell the scheduler which insight is on screen
+     * 
+     * @param insight_id ID of visible insight, or empty if a non-insight card is shown
+     * 
+     * The visible insight is refreshed more often and is fetched
+     * immediately if its data is stale. Safe to call from any task.
+     */
+    void setVisibleInsight(const String& insight_id);
+    
     /**
      * @brief Check if client is ready for operation
      * 
@@ -60,75 +174,219 @@ public:
      * 
      * Should be called regularly in main loop.
      * Handles:
-     * - Processing queued requests
-     * - Retrying failed requests
+     * - Collecting finished requests from the fetch workers
+     * - Dispatching queued requests whose retry time has arrived
      * - Refreshing existing insights
+     * Never blocks on the network or waiting for a retry.
      */
     void process();
-    
-private:
+
     /**
-     * @struct QueuedRequest
-     * @brief Tracks a queued insight request
+     * @brief Stop sending requests and close idle connections
+     * 
+     * Used while an OTA update downloads, so it gets the memory and
+     * bandwidth. Requests already running finish; new and scheduled ones
+     * wait. Lifts itself after MAX_SUSPEND in case resume() never comes.
+     * Called on OTA_PROCESS_START; safe to call from any task.
      */
-    struct QueuedRequest {
-        String insight_id;     ///< ID of insight to fetch
-        uint8_t retry_count;   ///< Number of retry attempts
-    };
+    void suspend();
+
+    /**
+     * @brief Resume requests after suspend()
+     * 
+     * Called on OTA_PROCESS_END; safe to call from any task.
+     */
+    void resume();
+
+    /**
+     * @brief Get connection reuse and handshake counters
+     */
+    ConnectionManager::Stats getConnectionStats() const { return _connections.getStats(); }
+
+    /**
+     * @brief Write request timing metrics for the web portal
+     * 
+     * @param out Object receiving the region, per-insight min/avg/p95 of each
+     *            request phase, and connection counters
+     */
+    void writeMetrics(JsonObject out);
+
+    /**
+     * @brief Write rate limiter counters for the status API
+     * 
+     * @param out Object receiving the current and configured rate, available
+     *            tokens, remaining pause and request/429 counts
+     */
+    void writeRateLimitStats(JsonObject out);
     
+private:
     // Configuration
     ConfigManager& _config;         ///< Configuration storage
     EventQueue& _eventQueue;        ///< Event system
     
     // Request tracking
-    std::set<String> requested_insights;  ///< All known insight IDs
-    std::queue<QueuedRequest> request_queue; ///< Queue of pending requests
-    bool has_active_request;               ///< Request in progress flag
-    WiFiClientSecure _secureClient;        ///< Secure WiFi client for HTTPS
-    HTTPClient _http;                      ///< HTTP client instance
-    unsigned long last_refresh_check;       ///< Last refresh timestamp
+    RefreshScheduler _scheduler;           ///< Refresh deadlines for all known insights
+    PendingRequests _pending;              ///< Requests waiting for a worker, one per insight
+    std::map<String, CircuitBreaker> _breakers; ///< Circuit breaker per API host
+    RateLimiter _rateLimiter;              ///< Request budget shared by all insights
+    std::map<String, uint32_t> published_digests; ///< Digest of last published data per insight
+    std::map<String, PendingRequest> _inFlight;   ///< Requests currently running on a worker
+    std::set<String> _serverStale;         ///< Insights whose server cache is past its target age
+    
+    /**
+     * @struct InsightMetadata
+     * @brief Everything about an insight except its result
+     */
+    struct InsightMetadata {
+        std::shared_ptr<const InsightParser> parser; ///< Right-sized copy of the last full fetch
+        unsigned long fetched_at;                    ///< When the full insight was fetched
+    };
+    std::map<String, InsightMetadata> _metadata;  ///< Metadata for results-only refreshes
+    std::map<String, String> _queries;     ///< HogQL query text by query key
+    std::map<String, std::shared_ptr<InsightParser>> _series; ///< Compact copy of the last time series per insight
+    std::map<String, size_t> _documentSizes; ///< Parse document each insight recently needed, in bytes
+    std::map<String, InsightParser::FilterType> _filterTypes; ///< Narrowest parse filter that fit each insight's last result
+    SemaphoreHandle_t _stateMutex;         ///< Guards queue, schedule and digests across tasks
+    InsightCache _cache;                   ///< Last known good data per insight
+    
+    // Fetch engine
+    std::vector<FetchWorker*> _workers;    ///< One task and connection per concurrent request
+    ConnectionManager _connections;        ///< DNS cache and TLS sessions shared by the workers
+    FetchMetrics _metrics;                 ///< Per-insight request timings
+    unsigned long _lastStatsLog;           ///< When connection stats were last logged
+    QueueHandle_t _resultQueue;            ///< FetchResult pointers posted by workers
+    size_t _psramReserved;                 ///< PSRAM reserved by in-flight requests
+    bool _suspended;                       ///< Requests held back for an OTA update
+    unsigned long _suspendedAt;            ///< When suspend() was called
     
     // Constants
     static const char* BASE_URL;                        ///< PostHog API base URL
-    static const unsigned long REFRESH_INTERVAL = 30000; ///< Refresh every 30s
     static const uint8_t MAX_RETRIES = 3;              ///< Max retry attempts
-    static const unsigned long RETRY_DELAY = 1000;      ///< Delay between retries
-    
+    static const unsigned long RETRY_BASE_DELAY = 1000; ///< Backoff for the first retry
+    static const unsigned long RETRY_MAX_DELAY = 60000; ///< Backoff ceiling
+    static const size_t TLS_CONNECTION_BYTES = 32768;   ///< Rough TLS and HTTP buffer cost per connection
+    static const size_t INFLATE_BYTES = InflateStream::WINDOW_SIZE + 12288; ///< Inflate window plus decompressor state
+    static const size_t FETCH_PSRAM_PER_CONNECTION = TLS_CONNECTION_BYTES + INFLATE_BYTES; ///< Reserved per in-flight request, besides its document
+    static const size_t DOCUMENT_HEADROOM = 1024;       ///< Added to an insight's usual document size, on top of a quarter
+    static const unsigned long STATS_LOG_INTERVAL = 300000; ///< Log connection stats every 5 minutes
+    static const unsigned long MAX_SERVER_HOLD = 21600000;  ///< Never defer polls more than 6 hours on the server's word
+    static const time_t MIN_VALID_CLOCK = 1577836800;       ///< 2020-01-01; anything earlier is an unset clock
+    static const unsigned long QUERY_POLL_MIN_INTERVAL = 1000;  ///< First query status poll
+    static const unsigned long QUERY_POLL_MAX_INTERVAL = 10000; ///< Slowest query status poll
+    static const unsigned long MAX_QUERY_WAIT = 300000;         ///< Stop polling a query after 5 minutes
+    static const unsigned long MAX_SUSPEND = 600000;            ///< Resume on our own if OTA_PROCESS_END is lost
+    static const unsigned long METADATA_MAX_AGE = 3600000;      ///< Re-fetch the full insight hourly to pick up renames
 
+    /**
+     * @brief Check whether requests are suspended, lifting an expired suspension
+     * 
+     * @return true while suspended; call with _stateMutex held
+     */
+    bool checkSuspended();
 
-        /**
+    /**
+     * @brief Close the kept-alive socket of every idle worker
+     */
+    void releaseIdleConnections();
+
+    /**
      * @brief Build Base API URL based on project region
      */
     String buildBaseUrl() const;
 
     /**
-     * @brief Handle system state changes
-     * @param state New system state
+     * @brief Build API host name based on project region, or POSTHOG_API_HOST if defined
+     */
+    String buildHost() const;
+
+    /**
+     * @brief Compute the wait before the next retry
+     * 
+     * @param retry_count Retry attempt about to be scheduled (1-based)
+     * @return Exponential backoff with random jitter, in milliseconds
+     */
+    static unsigned long computeRetryDelay(uint8_t retry_count);
+
+    /**
+     * @brief Check whether a failure reflects the host rather than the request
+     * 
+     * @param http_code HTTP status or negative HTTPClient error
+     * @return true for transport errors and 5xx responses
+     */
+    static bool isHostFailure(int http_code);
+
+    /**
+     * @brief Create and start the fetch workers
+     * 
+     * Called lazily from process() so the tasks only exist once the
+     * client is configured.
+     */
+    void startWorkers();
+
+    /**
+     * @brief Log handshake cost against reused-connection request time
      */
-    void onSystemStateChange(SystemState state);
+    void logConnectionStats();
     
     /**
-     * @brief Process pending requests in queue
+     * @brief Hand ready requests to idle workers
      * 
-     * Handles retry logic and request timeouts.
+     * Respects request backoff, the rate limiter, the host circuit breaker
+     * and the PSRAM budget. Never starts two requests for the same insight.
      */
-    void processQueue();
+    void dispatchRequests();
     
     /**
-     * @brief Check if insights need refreshing
+     * @brief Drain finished requests posted by the workers
+     */
+    void collectResults();
+    
+    /**
+     * @brief Apply the outcome of a finished request
      * 
-     * Queues refresh requests for insights older than REFRESH_INTERVAL.
+     * @param result Result posted by a worker
+     * 
+     * Publishes data, starts an async query for a cold cache, follows a
+     * running query or queues a retry with backoff. A 429 pauses the rate
+     * limiter and requeues the request for when the pause ends. Series
+     * tails are merged into the held series before publishing.
      */
-    void checkRefreshes();
+    void handleResult(FetchResult& result);
+
+    /**
+     * @brief Queue the next step for a query started with refresh=async
+     * 
+     * @param request Request that reported the status
+     * @param status Query progress from the server
+     * @param now Current time in milliseconds
+     * 
+     * Polls the status with a growing interval while the query runs, then
+     * fetches the cached result once it completes. Gives up on server
+     * errors and after MAX_QUERY_WAIT. Must be called with the state mutex held.
+     */
+    void followQuery(PendingRequest request, const QueryStatus& status, unsigned long now);
+
+    /**
+     * @brief Schedule the next poll of an insight from the server's cache metadata
+     * 
+     * @param insight_id ID of insight
+     * @param result Successful result carrying the parser and server clock
+     * 
+     * Holds polls back until next_allowed_client_refresh, since the server
+     * returns the same cached result before then, and marks the insight
+     * for an async refresh once its cache is past cache_target_age.
+     * Must be called with the state mutex held.
+     */
+    void applyServerFreshness(const String& insight_id, const FetchResult& result);
     
     /**
-     * @brief Fetch insight data from PostHog
+     * @brief Check if insights need refreshing
      * 
-     * @param insight_id ID of insight to fetch
-     * @param response String to store response
-     * @return true if fetch was successful
+     * Queues a refresh request for the next insight the scheduler reports as due.
+     * Insights whose server cache is stale are refreshed in async mode.
+     * Does nothing while the rate limiter is paused, so due insights wait.
      */
-    bool fetchInsight(const String& insight_id, String& response);
+    void checkRefreshes();
     
     /**
      * @brief Build insight API URL
@@ -139,6 +397,62 @@ private:
      */
     String buildInsightUrl(const String& insight_id, const char* refresh_mode = "force_cache") const;
     
+    /**
+     * @brief Build query status URL
+     * 
+     * @param query_id ID of a query started with refresh=async
+     * @return Complete API URL
+     */
+    String buildQueryStatusUrl(const String& query_id) const;
+    
+    /**
+     * @brief Build query API URL, used for results-only refreshes
+     * 
+     * @return Complete API URL
+     */
+    String buildQueryUrl() const;
+    
+    /**
+     * @brief Fill in a job's URL and body for its phase
+     * 
+     * @param job Job whose insight_id and phase are set
+     * @param request Pending request the job is for
+     * @param now Current time in milliseconds
+     * 
+     * HogQL queries always use the query API. Insights use it with the
+     * stored query source when fresh metadata is available, narrowed to the
+     * newest buckets when a time series is already held; otherwise the
+     * full insight is fetched. Must be called with the state mutex held.
+     */
+    void prepareJob(FetchJob& job, const PendingRequest& request, unsigned long now);
+
+    /**
+     * @brief Choose the parse document for a request
+     * 
+     * @param request Pending request
+     * @return Capacity in bytes, 0 for status polls and HogQL queries, which
+     *         parse into small fixed documents
+     * 
+     * Sized from what the insight's documents used recently, with headroom;
+     * DOCUMENT_CAPACITY for an insight without history. Must be called with
+     * the state mutex held.
+     */
+    size_t documentCapacityFor(const PendingRequest& request) const;
+
+    /**
+     * @brief Learn an insight's document size from a parse
+     * 
+     * @param insight_id ID of insight
+     * @param timing Timing of the request, carrying the document usage
+     * 
+     * Grows at once, doubling after a parse that ran out of memory, and
+     * shrinks a quarter of the way towards smaller documents, so one small
+     * response doesn't undersize the next. Must be called with the state
+     * mutex held.
+     */
+    void recordDocumentSize(const String& insight_id, const RequestTiming& timing);
+    
     // Event-related methods
-    void publishInsightDataEvent(const String& insight_id, const String& response);
+    void publishInsightDataEvent(const String& insight_id, std::shared_ptr<InsightParser> parser);
+    void publishQueryDataEvent(const String& query_key, std::shared_ptr<HogQLParser> parser);
 }; 
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "RateLimiter.h"
+
+RateLimiter::RateLimiter(uint16_t rate_per_minute, uint16_t burst)
+    : _max_rate(rate_per_minute > MIN_RATE ? rate_per_minute : MIN_RATE)
+    , _rate(_max_rate)
+    , _burst(burst > 0 ? burst : 1)
+    , _milli_tokens((uint32_t)_burst * MILLI_TOKENS_PER_TOKEN)
+    , _last_refill(0)
+    , _paused(false)
+    , _paused_until(0)
+    , _requests_sent(0)
+    , _throttled(0)
+    , _last_retry_after(0) {
+}
+
+void RateLimiter::refill(unsigned long now) {
+    // rate per minute is rate / 60 thousandths of a token per millisecond
+    unsigned long elapsed = now - _last_refill;
+    uint64_t earned = (uint64_t)elapsed * _rate / 60;
+    if (earned == 0) {
+        // Keep the fraction for next time
+        return;
+    }
+
+    uint64_t capacity = (uint64_t)_burst * MILLI_TOKENS_PER_TOKEN;
+    uint64_t tokens = _milli_tokens + earned;
+    _milli_tokens = (uint32_t)(tokens < capacity ? tokens : capacity);
+    _last_refill = now;
+}
+
+bool RateLimiter::hasToken(unsigned long now) {
+    if (_paused) {
+        if ((long)(now - _paused_until) < 0) {
+            return false;
+        }
+        Serial.printf("Rate limit pause over, resuming at %u requests/min\n", _rate);
+        _paused = false;
+        _milli_tokens = MILLI_TOKENS_PER_TOKEN;
+        _last_refill = now;
+    }
+
+    refill(now);
+    return _milli_tokens >= MILLI_TOKENS_PER_TOKEN;
+}
+
+void RateLimiter::consume() {
+    _milli_tokens = (_milli_tokens >= MILLI_TOKENS_PER_TOKEN) ? _milli_tokens - MILLI_TOKENS_PER_TOKEN : 0;
+    _requests_sent++;
+}
+
+void RateLimiter::recordThrottled(unsigned long now, unsigned long retry_after) {
+    _throttled++;
+
+    unsigned long pause = retry_after > 0 ? retry_after : DEFAULT_PAUSE;
+    if (pause > MAX_PAUSE) {
+        pause = MAX_PAUSE;
+    }
+    _last_retry_after = pause;
+
+    // Several in-flight requests can be throttled together; extend, never shorten
+    unsigned long until = now + pause;
+    if (!_paused || (long)(until - _paused_until) > 0) {
+        _paused_until = until;
+    }
+    _paused = true;
+    _milli_tokens = 0;
+
+    uint16_t halved = _rate / 2;
+    _rate = halved > MIN_RATE ? halved : MIN_RATE;
+    Serial.printf("Rate limited by server, pausing requests for %lu ms and slowing to %u requests/min\n",
+                  pause, _rate);
+}
+
+void RateLimiter::recordSuccess() {
+    if (_rate < _max_rate) {
+        _rate++;
+    }
+}
+
+bool RateLimiter::isPaused(unsigned long now) const {
+    return _paused && (long)(now - _paused_until) < 0;
+}
+
+RateLimiter::Stats RateLimiter::getStats(unsigned long now) const {
+    Stats stats;
+    stats.rate_per_minute = _rate;
+    stats.max_rate_per_minute = _max_rate;
+    stats.tokens = (uint16_t)(_milli_tokens / MILLI_TOKENS_PER_TOKEN);
+    stats.paused_for_ms = isPaused(now) ? _paused_until - now : 0;
+    stats.requests_sent = _requests_sent;
+    stats.throttled_responses = _throttled;
+    stats.last_retry_after_ms = _last_retry_after;
+    return stats;
+}
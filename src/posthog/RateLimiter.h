@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @class RateLimiter
+ * @brief Token bucket shared by all PostHog API requests
+ *
+ * Tokens refill continuously at the current rate, up to the burst size,
+ * and each request takes one. The rate adapts to the server:
+ * - A 429 response halves the rate and pauses all requests for the
+ *   time the server advised in Retry-After (or a default pause)
+ * - Every other response raises the rate by one request per minute,
+ *   back up to the configured rate
+ *
+ * After a pause the bucket holds a single token, so requests resume one
+ * at a time rather than in a burst. Not thread-safe on its own;
+ * PostHogClient serializes access.
+ */
+class RateLimiter {
+public:
+    /**
+     * @struct Stats
+     * @brief Counters for the status API
+     */
+    struct Stats {
+        uint16_t rate_per_minute;         ///< Current adapted rate
+        uint16_t max_rate_per_minute;     ///< Configured rate
+        uint16_t tokens;                  ///< Whole tokens available now
+        unsigned long paused_for_ms;      ///< Remaining pause, 0 if not paused
+        uint32_t requests_sent;           ///< Requests that took a token
+        uint32_t throttled_responses;     ///< 429 responses received
+        unsigned long last_retry_after_ms; ///< Pause advised by the last 429
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param rate_per_minute Sustained request rate
+     * @param burst Tokens that can accumulate while idle
+     */
+    RateLimiter(uint16_t rate_per_minute, uint16_t burst);
+
+    /**
+     * @brief Check whether a request may be sent now
+     *
+     * @param now Current time in milliseconds
+     * @return true if not paused and a token is available; call consume()
+     *         once the request is actually sent
+     */
+    bool hasToken(unsigned long now);
+
+    /**
+     * @brief Take a token for a request that was sent
+     */
+    void consume();
+
+    /**
+     * @brief Record a 429 response
+     *
+     * @param now Current time in milliseconds
+     * @param retry_after Pause advised by the server in milliseconds, 0 if none
+     */
+    void recordThrottled(unsigned long now, unsigned long retry_after);
+
+    /**
+     * @brief Record a response that was not rate limited
+     */
+    void recordSuccess();
+
+    /**
+     * @brief Check whether requests are paused after a 429
+     * @param now Current time in milliseconds
+     */
+    bool isPaused(unsigned long now) const;
+
+    /**
+     * @brief Get counters and current state
+     * @param now Current time in milliseconds
+     */
+    Stats getStats(unsigned long now) const;
+
+private:
+    static const uint32_t MILLI_TOKENS_PER_TOKEN = 1000;
+    static const uint16_t MIN_RATE = 1;                     ///< Never adapt below one request per minute
+    static const unsigned long DEFAULT_PAUSE = 60000;       ///< Pause when a 429 has no Retry-After
+    static const unsigned long MAX_PAUSE = 3600000;         ///< Cap on a server-advised pause
+
+    uint16_t _max_rate;             ///< Configured requests per minute
+    uint16_t _rate;                 ///< Current requests per minute
+    uint16_t _burst;                ///< Bucket size in tokens
+    uint32_t _milli_tokens;         ///< Tokens in the bucket, in thousandths
+    unsigned long _last_refill;     ///< When tokens were last added
+    bool _paused;                   ///< Pause after a 429 in effect
+    unsigned long _paused_until;    ///< End of the pause
+    uint32_t _requests_sent;        ///< Tokens taken
+    uint32_t _throttled;            ///< 429 responses
+    unsigned long _last_retry_after; ///< Last pause length
+
+    /**
+     * @brief Add the tokens earned since the last refill
+     * @param now Current time in milliseconds
+     */
+    void refill(unsigned long now);
+};
@@ -0,0 +1,154 @@
+#include "RefreshScheduler.h"
+
+RefreshScheduler::RefreshScheduler() {
+}
+
+void RefreshScheduler::addInsight(const String& insight_id, unsigned long now) {
+    if (_entries.count(insight_id) > 0) {
+        return;
+    }
+
+    Entry entry;
+    entry.last_refresh = now;
+    entry.interval = (insight_id == _visible_id) ? visibleInterval(entry) : hiddenInterval(entry);
+    entry.not_before = 0;
+    entry.has_not_before = false;
+    _entries[insight_id] = entry;
+}
+
+void RefreshScheduler::removeInsight(const String& insight_id) {
+    _entries.erase(insight_id);
+}
+
+void RefreshScheduler::setPolicy(const String& insight_id, const RefreshPolicy& policy) {
+    auto it = _entries.find(insight_id);
+    if (it == _entries.end()) {
+        return;
+    }
+
+    Entry& entry = it->second;
+    entry.policy = policy;
+    entry.interval = (insight_id == _visible_id) ? visibleInterval(entry) : hiddenInterval(entry);
+}
+
+bool RefreshScheduler::hasInsight(const String& insight_id) const {
+    return _entries.count(insight_id) > 0;
+}
+
+void RefreshScheduler::setVisibleInsight(const String& insight_id, unsigned long now) {
+    if (insight_id == _visible_id) {
+        return;
+    }
+
+    // The card we just left goes back to the hidden schedule
+    auto previous = _entries.find(_visible_id);
+    if (previous != _entries.end()) {
+        previous->second.interval = hiddenInterval(previous->second);
+    }
+
+    _visible_id = insight_id;
+
+    auto current = _entries.find(_visible_id);
+    if (current != _entries.end()) {
+        // Stale data on the card we are looking at is refreshed right away
+        unsigned long interval = visibleInterval(current->second);
+        if (now - current->second.last_refresh >= interval) {
+            current->second.interval = 0;
+        } else {
+            current->second.interval = interval;
+        }
+    }
+}
+
+bool RefreshScheduler::getDueInsight(unsigned long now, int utc_hour, String& insight_id) const {
+    // The visible card always goes first
+    auto visible = _entries.find(_visible_id);
+    if (visible != _entries.end() && visible->second.policy.isActiveAt(utc_hour) &&
+        overdueBy(visible->second, now) >= 0) {
+        insight_id = visible->first;
+        return true;
+    }
+
+    long most_overdue = -1;
+    for (const auto& pair : _entries) {
+        const RefreshPolicy& policy = pair.second.policy;
+        if (!policy.isActiveAt(utc_hour) || (policy.on_view_only && pair.first != _visible_id)) {
+            continue;
+        }
+        long overdue = overdueBy(pair.second, now);
+        if (overdue > most_overdue) {
+            most_overdue = overdue;
+            insight_id = pair.first;
+        }
+    }
+
+    return most_overdue >= 0;
+}
+
+void RefreshScheduler::markRefreshed(const String& insight_id, unsigned long now) {
+    auto it = _entries.find(insight_id);
+    if (it == _entries.end()) {
+        return;
+    }
+
+    Entry& entry = it->second;
+    entry.last_refresh = now;
+    if (entry.has_not_before && (long)(now - entry.not_before) >= 0) {
+        entry.has_not_before = false;
+    }
+
+    if (insight_id == _visible_id) {
+        entry.interval = visibleInterval(entry);
+    } else if (entry.policy.interval_s > 0) {
+        entry.interval = hiddenInterval(entry);
+    } else if (entry.interval < HIDDEN_BASE_INTERVAL) {
+        entry.interval = HIDDEN_BASE_INTERVAL;
+    } else {
+        unsigned long doubled = entry.interval * 2;
+        entry.interval = (doubled > HIDDEN_MAX_INTERVAL) ? HIDDEN_MAX_INTERVAL : doubled;
+    }
+}
+
+void RefreshScheduler::setNotBefore(const String& insight_id, unsigned long when) {
+    auto it = _entries.find(insight_id);
+    if (it == _entries.end()) {
+        return;
+    }
+    it->second.not_before = when;
+    it->second.has_not_before = true;
+}
+
+void RefreshScheduler::clearNotBefore(const String& insight_id) {
+    auto it = _entries.find(insight_id);
+    if (it != _entries.end()) {
+        it->second.has_not_before = false;
+    }
+}
+
+unsigned long RefreshScheduler::visibleInterval(const Entry& entry) {
+    return entry.policy.interval_s > 0 ? entry.policy.interval_s * 1000UL : VISIBLE_INTERVAL;
+}
+
+unsigned long RefreshScheduler::hiddenInterval(const Entry& entry) {
+    return entry.policy.interval_s > 0 ? entry.policy.interval_s * 1000UL : HIDDEN_BASE_INTERVAL;
+}
+
+long RefreshScheduler::overdueBy(const Entry& entry, unsigned long now) {
+    unsigned long elapsed = now - entry.last_refresh;
+    if (elapsed < entry.interval) {
+        return -1;
+    }
+    long overdue = (long)(elapsed - entry.interval);
+
+    // Due at whichever is later: the interval or the server's hold
+    if (entry.has_not_before) {
+        long past_hold = (long)(now - entry.not_before);
+        if (past_hold < 0) {
+            return -1;
+        }
+        if (past_hold < overdue) {
+            overdue = past_hold;
+        }
+    }
+    return overdue;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <Arduino.h>
+#include <map>
+#include "../config/RefreshPolicy.h"
+
+/**
+ * @class RefreshScheduler
+ * @brief Tracks a refresh deadline for every known insight
+ *
+ * Features:
+ * - Short refresh interval for the insight currently on screen
+ * - Exponential back-off for hidden insights, up to a ceiling
+ * - Visible insight jumps the queue when the user navigates to it
+ * - Server-imposed earliest refresh time, so polls that can only return
+ *   the same cached result are skipped
+ * - Per-insight RefreshPolicy: a fixed interval in place of the adaptive
+ *   one, active hours, and refreshing only while on screen
+ * - Safe to add and remove insights at any time
+ *
+ * Not thread-safe on its own; PostHogClient serializes access.
+ */
+class RefreshScheduler {
+public:
+    RefreshScheduler();
+
+    /**
+     * @brief Start tracking an insight
+     *
+     * @param insight_id ID of insight
+     * @param now Current time in milliseconds
+     *
+     * The caller is expected to fetch the insight right away, so the
+     * first scheduled refresh is one interval from now. Re-adding a
+     * tracked insight is a no-op.
+     */
+    void addInsight(const String& insight_id, unsigned long now);
+
+    /**
+     * @brief Stop tracking an insight
+     * @param insight_id ID of insight
+     */
+    void removeInsight(const String& insight_id);
+
+    /**
+     * @brief Set how an insight is refreshed
+     *
+     * @param insight_id ID of insight; ignored if not tracked
+     * @param policy Refresh policy from the card's configuration
+     *
+     * The next refresh is rescheduled from the last one using the new interval.
+     */
+    void setPolicy(const String& insight_id, const RefreshPolicy& policy);
+
+    /**
+     * @brief Check if an insight is being tracked
+     * @param insight_id ID of insight
+     * @return true if the insight has a refresh schedule
+     */
+    bool hasInsight(const String& insight_id) const;
+
+    /**
+     * @brief Set the insight currently shown on screen
+     *
+     * @param insight_id ID of visible insight, or empty if no insight card is shown
+     * @param now Current time in milliseconds
+     *
+     * The newly visible insight is made due immediately if its data is
+     * older than the visible interval. The previously visible one falls
+     * back to the hidden schedule.
+     */
+    void setVisibleInsight(const String& insight_id, unsigned long now);
+
+    /**
+     * @brief Check if an insight is the one on screen
+     * @param insight_id ID of insight
+     */
+    bool isVisible(const String& insight_id) const { return insight_id.length() > 0 && insight_id == _visible_id; }
+
+    /**
+     * @brief Pick the insight that should be refreshed next
+     *
+     * @param now Current time in milliseconds
+     * @param utc_hour Current UTC hour for active hours, or -1 if the clock isn't set
+     * @param insight_id Receives the ID of the due insight
+     * @return true if an insight is due
+     *
+     * The visible insight wins if it is due; otherwise the most overdue
+     * hidden insight is returned. Insights outside their active hours, and
+     * hidden insights that only refresh on view, are never due.
+     */
+    bool getDueInsight(unsigned long now, int utc_hour, String& insight_id) const;
+
+    /**
+     * @brief Record that a refresh was issued and schedule the next one
+     *
+     * @param insight_id ID of insight
+     * @param now Current time in milliseconds
+     *
+     * Hidden insights double their interval on every refresh until
+     * HIDDEN_MAX_INTERVAL is reached, unless their policy sets a fixed interval.
+     */
+    void markRefreshed(const String& insight_id, unsigned long now);
+
+    /**
+     * @brief Hold back refreshes of an insight until a given time
+     *
+     * @param insight_id ID of insight
+     * @param when millis() before which the insight is never due
+     *
+     * Applies on top of the regular interval, including for the visible
+     * insight. Cleared by the first refresh issued after it passes, or by
+     * clearNotBefore().
+     */
+    void setNotBefore(const String& insight_id, unsigned long when);
+
+    /**
+     * @brief Remove the hold set by setNotBefore()
+     * @param insight_id ID of insight
+     */
+    void clearNotBefore(const String& insight_id);
+
+private:
+    /**
+     * @struct Entry
+     * @brief Refresh state for a single insight
+     */
+    struct Entry {
+        unsigned long last_refresh;   ///< When the last refresh was issued
+        unsigned long interval;       ///< Delay until the next refresh
+        unsigned long not_before;     ///< Earliest refresh time, if has_not_before
+        bool has_not_before;          ///< Server asked us to wait until not_before
+        RefreshPolicy policy;         ///< Card's refresh settings
+    };
+
+    std::map<String, Entry> _entries;  ///< Schedule per insight ID
+    String _visible_id;                ///< Insight currently on screen
+
+    // Constants
+    static const unsigned long VISIBLE_INTERVAL = 15000;      ///< Refresh on-screen card every 15s
+    static const unsigned long HIDDEN_BASE_INTERVAL = 60000;  ///< First back-off step for hidden cards
+    static const unsigned long HIDDEN_MAX_INTERVAL = 600000;  ///< Hidden cards refresh at least every 10 min
+
+    /**
+     * @brief Interval while on screen: the policy's fixed interval or VISIBLE_INTERVAL
+     */
+    static unsigned long visibleInterval(const Entry& entry);
+
+    /**
+     * @brief First interval once hidden: the policy's fixed interval or HIDDEN_BASE_INTERVAL
+     */
+    static unsigned long hiddenInterval(const Entry& entry);
+
+    /**
+     * @brief Milliseconds an entry is past its deadline
+     * @return Overdue time, or -1 if not yet due
+     */
+    static long overdueBy(const Entry& entry, unsigned long now);
+};
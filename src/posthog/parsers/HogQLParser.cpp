@@ -0,0 +1,172 @@
+#include "HogQLParser.h"
+#include "TimeFormat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Keeps the cells, column names, freshness fields and query status; types,
+// the compiled SQL and timings are dropped while reading
+static StaticJsonDocument<256> createFilter() {
+    StaticJsonDocument<256> filter;
+    filter[JSON_KEY_RESULTS][0][0] = true;
+    filter[JSON_KEY_COLUMNS][0] = true;
+    filter[JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH] = true;
+    filter[JSON_KEY_CACHE_TARGET_AGE] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_ID] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_COMPLETE] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_ERROR] = true;
+    return filter;
+}
+
+static const JsonDocument& queryFilter() {
+    static StaticJsonDocument<256> filter = createFilter();
+    return filter;
+}
+
+HogQLParser::HogQLParser(const char* json) : valid(false) {
+    DeserializationError error = deserializeJson(doc, json, DeserializationOption::Filter(queryFilter()));
+    validateDocument(error);
+}
+
+HogQLParser::HogQLParser(Stream& stream) : valid(false) {
+    DeserializationError error = deserializeJson(doc, stream, DeserializationOption::Filter(queryFilter()));
+    validateDocument(error);
+}
+
+bool HogQLParser::getQueryRequestBody(const String& hogql, const char* refresh_mode, String& body) {
+    if (hogql.length() == 0) {
+        return false;
+    }
+
+    // {"query": {"kind": "HogQLQuery", "query": "<hogql>"}, "refresh": "<mode>"}
+    DynamicJsonDocument request(JSON_OBJECT_SIZE(2) * 2 + hogql.length() + 64);
+    JsonObject query = request.createNestedObject(JSON_KEY_QUERY);
+    query["kind"] = "HogQLQuery";
+    query[JSON_KEY_QUERY] = hogql.c_str();
+    request[JSON_KEY_REFRESH] = refresh_mode;
+
+    body = "";
+    serializeJson(request, body);
+    return !request.overflowed();
+}
+
+void HogQLParser::validateDocument(DeserializationError error) {
+    if (error == DeserializationError::NoMemory) {
+        printf("HogQL response too large; the query should return a single aggregate row.\n");
+        return;
+    }
+    if (error) {
+        printf("JSON Deserialization failed: %s\n", error.c_str());
+        return;
+    }
+
+    if (!doc.is<JsonObject>()) {
+        printf("HogQL response root is not an object.\n");
+        return;
+    }
+    valid = true;
+}
+
+JsonVariantConst HogQLParser::firstCell() const {
+    return doc[JSON_KEY_RESULTS][0][0];
+}
+
+bool HogQLParser::hasResultData() const {
+    if (!valid) {
+        return false;
+    }
+
+    JsonArrayConst row = doc[JSON_KEY_RESULTS][0];
+    return !row.isNull() && row.size() > 0;
+}
+
+double HogQLParser::getValue() const {
+    if (!valid) {
+        return 0.0;
+    }
+
+    // Large integers and decimals can come back as strings
+    JsonVariantConst cell = firstCell();
+    if (cell.is<const char*>()) {
+        return atof(cell.as<const char*>());
+    }
+    return cell | 0.0;
+}
+
+bool HogQLParser::getColumnName(char* buffer, size_t bufferSize) const {
+    if (!valid || bufferSize == 0) {
+        return false;
+    }
+
+    const char* name = doc[JSON_KEY_COLUMNS][0];
+    if (!name || !*name) {
+        return false;
+    }
+
+    strncpy(buffer, name, bufferSize - 1);
+    buffer[bufferSize - 1] = '\0';
+    return true;
+}
+
+uint32_t HogQLParser::getContentDigest() const {
+    if (!valid) {
+        return 0;
+    }
+
+    char text[96];
+    const char* column = doc[JSON_KEY_COLUMNS][0] | "";
+    int length = snprintf(text, sizeof(text), "%.17g|%s", getValue(), column);
+    if (length < 0) {
+        return 0;
+    }
+
+    // FNV-1a
+    uint32_t digest = 2166136261u;
+    for (const char* c = text; *c; c++) {
+        digest ^= (uint8_t)*c;
+        digest *= 16777619u;
+    }
+    return digest;
+}
+
+bool HogQLParser::getTimestamp(const char* key, time_t* timestamp) const {
+    if (!valid || !timestamp) {
+        return false;
+    }
+
+    const char* value = doc[key];
+    return TimeFormat::parseIso8601(value, timestamp);
+}
+
+bool HogQLParser::getNextAllowedClientRefresh(time_t* timestamp) const {
+    return getTimestamp(JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH, timestamp);
+}
+
+bool HogQLParser::getCacheTargetAge(time_t* timestamp) const {
+    return getTimestamp(JSON_KEY_CACHE_TARGET_AGE, timestamp);
+}
+
+bool HogQLParser::getQueryStatus(char* id_buffer, size_t id_buffer_size, bool* complete, bool* error) const {
+    if (!valid || !id_buffer || id_buffer_size == 0) {
+        return false;
+    }
+
+    JsonObjectConst status = doc[JSON_KEY_QUERY_STATUS];
+    const char* id = status[JSON_KEY_ID];
+    if (!id || strlen(id) >= id_buffer_size) {
+        return false;
+    }
+
+    strcpy(id_buffer, id);
+    if (complete) {
+        *complete = status[JSON_KEY_COMPLETE] | false;
+    }
+    if (error) {
+        *error = status[JSON_KEY_ERROR] | false;
+    }
+    return true;
+}
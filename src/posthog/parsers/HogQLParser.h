@@ -0,0 +1,128 @@
+#pragma once
+
+#include "InsightParser.h"
+
+/**
+ * @class HogQLParser
+ * @brief Parser for the response to a single-value HogQL query
+ *
+ * A HogQL card asks the query API for one aggregate (e.g. `SELECT count()
+ * FROM events WHERE ...`), so the response is a few hundred bytes. Only the
+ * first cell, the first column name, the freshness fields and the query
+ * status are kept, in a small fixed-size document instead of an insight-sized one
+ * InsightParser needs for saved insights.
+ */
+class HogQLParser {
+public:
+    /**
+     * @brief Size of the JSON document held by each parser, in bytes
+     */
+    static const size_t DOCUMENT_CAPACITY = 1024;
+
+    /**
+     * @brief Constructor - parses JSON data
+     * @param json Raw JSON string to parse
+     *
+     * Uses isValid() to check if parsing was successful.
+     */
+    HogQLParser(const char* json);
+
+    /**
+     * @brief Constructor - parses JSON directly from a stream
+     * @param stream Stream positioned at the start of a query API response
+     *
+     * Uses isValid() to check if parsing was successful.
+     */
+    HogQLParser(Stream& stream);
+
+    /**
+     * @brief Build the body of a query API request for a HogQL query
+     * @param hogql HogQL query text
+     * @param refresh_mode Cache control mode (e.g. "force_cache" or "async")
+     * @param body Receives the JSON request body
+     * @return true if the query is not empty
+     */
+    static bool getQueryRequestBody(const String& hogql, const char* refresh_mode, String& body);
+
+    /**
+     * @brief Check if the response was parsed successfully
+     * @return true if the response is a query API response
+     */
+    bool isValid() const { return valid; }
+
+    /**
+     * @brief Check whether the response carries a result row
+     * @return true if the query has been computed
+     *
+     * A cold server-side cache returns no results, in which case an async
+     * query has to be started.
+     */
+    bool hasResultData() const;
+
+    /**
+     * @brief Get the first cell of the first row
+     * @return Numeric value; strings are parsed as numbers and null is 0
+     */
+    double getValue() const;
+
+    /**
+     * @brief Get the name of the first column
+     * @param buffer Buffer to store the name
+     * @param bufferSize Size of buffer
+     * @return true if the response named its columns
+     *
+     * Queries can alias the column (`SELECT count() AS "Signups"`) to
+     * choose the card title.
+     */
+    bool getColumnName(char* buffer, size_t bufferSize) const;
+
+    /**
+     * @brief Compute a digest of what the card displays
+     * @return 32-bit FNV-1a hash of the value and column name, or 0 if invalid
+     */
+    uint32_t getContentDigest() const;
+
+    /**
+     * @brief Get the earliest time the server will recompute on request
+     * @param timestamp Receives the Unix time (UTC)
+     * @return true if the response carried a parseable next_allowed_client_refresh
+     */
+    bool getNextAllowedClientRefresh(time_t* timestamp) const;
+
+    /**
+     * @brief Get the time after which the server considers its cache stale
+     * @param timestamp Receives the Unix time (UTC)
+     * @return true if the response carried a parseable cache_target_age
+     */
+    bool getCacheTargetAge(time_t* timestamp) const;
+
+    /**
+     * @brief Get the status of a query started with refresh=async
+     * @param id_buffer Buffer to store the query ID
+     * @param id_buffer_size Size of buffer
+     * @param complete Receives whether the result has been computed (optional)
+     * @param error Receives whether the query failed (optional)
+     * @return true if the response carried a query status
+     */
+    bool getQueryStatus(char* id_buffer, size_t id_buffer_size, bool* complete, bool* error) const;
+
+private:
+    StaticJsonDocument<DOCUMENT_CAPACITY> doc;  ///< Filtered response
+    bool valid;                                 ///< Parsing succeeded
+
+    /**
+     * @brief Check the parse outcome and set valid
+     * @param error Result of deserialization
+     */
+    void validateDocument(DeserializationError error);
+
+    /**
+     * @brief Read an ISO 8601 timestamp from the root object
+     */
+    bool getTimestamp(const char* key, time_t* timestamp) const;
+
+    /**
+     * @brief First cell of the first row, or null
+     */
+    JsonVariantConst firstCell() const;
+};
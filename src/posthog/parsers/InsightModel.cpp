@@ -0,0 +1,161 @@
+#include "InsightModel.h"
+#include <string.h>
+#include <algorithm>
+
+InsightModel::InsightModel()
+    : _type(InsightParser::InsightType::INSIGHT_NOT_SUPPORTED)
+    , _numeric_value(0.0)
+    , _breakdown_count(0)
+    , _strings(1, '\0')
+    , _title(0)
+    , _prefix(0)
+    , _suffix(0) {
+}
+
+std::shared_ptr<const InsightModel> InsightModel::fromParser(const InsightParser& parser) {
+    if (!parser.isValid()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<InsightModel> model(new InsightModel());
+    model->_type = parser.getInsightType();
+
+    char buffer[64];
+    model->_title = model->addString(parser.getName(buffer, sizeof(buffer)) ? buffer : "Insight");
+
+    switch (model->_type) {
+        case InsightParser::InsightType::NUMERIC_CARD: {
+            model->_numeric_value = parser.getNumericCardValue();
+            if (parser.getNumericFormattingPrefix(buffer, sizeof(buffer))) {
+                model->_prefix = model->addString(buffer);
+            }
+            if (parser.getNumericFormattingSuffix(buffer, sizeof(buffer))) {
+                model->_suffix = model->addString(buffer);
+            }
+            break;
+        }
+
+        case InsightParser::InsightType::LINE_GRAPH:
+        case InsightParser::InsightType::AREA_CHART: {
+            size_t point_count = parser.getSeriesPointCount();
+            if (point_count > 0) {
+                std::unique_ptr<double[]> values(new double[point_count]);
+                if (parser.getSeriesYValues(values.get())) {
+                    model->_series.assign(values.get(), values.get() + point_count);
+                }
+            }
+            break;
+        }
+
+        case InsightParser::InsightType::FUNNEL: {
+            size_t step_count = parser.getFunnelStepCount();
+            size_t breakdown_count = parser.getFunnelBreakdownCount();
+            if (breakdown_count > InsightParser::MAX_FUNNEL_BREAKDOWNS) {
+                breakdown_count = InsightParser::MAX_FUNNEL_BREAKDOWNS;
+            }
+            if (step_count == 0) {
+                break;
+            }
+
+            // One pass over the parser's result, then everything the renderer needs in flat tables
+            std::unique_ptr<InsightParser::FunnelStep[]> steps(new InsightParser::FunnelStep[step_count]);
+            step_count = parser.getFunnelTable(steps.get(), step_count);
+
+            model->_breakdown_count = breakdown_count;
+            model->_step_totals.resize(step_count);
+            model->_step_names.resize(step_count);
+            model->_average_times.resize(step_count);
+            model->_median_times.resize(step_count);
+            model->_funnel_counts.resize(step_count * breakdown_count);
+            model->_breakdown_order.resize(step_count * breakdown_count);
+
+            for (size_t step = 0; step < step_count; step++) {
+                const InsightParser::FunnelStep& row = steps[step];
+                model->_step_names[step] = model->addString(row.name);
+                model->_step_totals[step] = row.total;
+                model->_average_times[step] = (float)row.average_conversion_time;
+                model->_median_times[step] = (float)row.median_conversion_time;
+
+                uint32_t* counts = model->_funnel_counts.data() + step * breakdown_count;
+                std::copy(row.counts, row.counts + breakdown_count, counts);
+
+                // Largest breakdown first; insertion sort keeps ties in breakdown order
+                uint8_t* order = model->_breakdown_order.data() + step * breakdown_count;
+                for (size_t i = 0; i < breakdown_count; i++) {
+                    size_t j = i;
+                    while (j > 0 && counts[order[j - 1]] < counts[i]) {
+                        order[j] = order[j - 1];
+                        j--;
+                    }
+                    order[j] = (uint8_t)i;
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    model->_series.shrink_to_fit();
+    model->_strings.shrink_to_fit();
+    return model;
+}
+
+const char* InsightModel::getFunnelStepName(size_t step) const {
+    return step < _step_names.size() ? string(_step_names[step]) : string(0);
+}
+
+uint32_t InsightModel::getFunnelStepTotal(size_t step) const {
+    return step < _step_totals.size() ? _step_totals[step] : 0;
+}
+
+uint32_t InsightModel::getFunnelCount(size_t step, size_t breakdown) const {
+    if (step >= _step_totals.size() || breakdown >= _breakdown_count) {
+        return 0;
+    }
+    return _funnel_counts[step * _breakdown_count + breakdown];
+}
+
+size_t InsightModel::getFunnelBreakdownAtRank(size_t step, size_t rank) const {
+    if (step >= _step_totals.size() || rank >= _breakdown_count) {
+        return rank;
+    }
+    return _breakdown_order[step * _breakdown_count + rank];
+}
+
+float InsightModel::getFunnelConversionRate(size_t step) const {
+    if (step >= _step_totals.size() || _step_totals[0] == 0) {
+        return 0.0f;
+    }
+    return (float)_step_totals[step] / _step_totals[0];
+}
+
+float InsightModel::getFunnelAverageTime(size_t step) const {
+    return step < _average_times.size() ? _average_times[step] : 0.0f;
+}
+
+float InsightModel::getFunnelMedianTime(size_t step) const {
+    return step < _median_times.size() ? _median_times[step] : 0.0f;
+}
+
+size_t InsightModel::memoryUsage() const {
+    return sizeof(*this)
+        + _series.capacity() * sizeof(float)
+        + (_step_totals.capacity() + _funnel_counts.capacity()) * sizeof(uint32_t)
+        + (_average_times.capacity() + _median_times.capacity()) * sizeof(float)
+        + _breakdown_order.capacity()
+        + _step_names.capacity() * sizeof(uint16_t)
+        + _strings.capacity();
+}
+
+uint16_t InsightModel::addString(const char* value) {
+    size_t length = value ? strlen(value) : 0;
+    if (length == 0 || _strings.size() + length + 1 > UINT16_MAX) {
+        return 0; // The empty string at the start of the arena
+    }
+
+    uint16_t offset = (uint16_t)_strings.size();
+    _strings.insert(_strings.end(), value, value + length + 1);
+    return offset;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "InsightParser.h"
+#include <memory>
+#include <vector>
+
+/**
+ * @class InsightModel
+ * @brief Typed copy of what an insight card draws
+ *
+ * Built once from an InsightParser when data reaches a card. Only the
+ * values the renderers use are kept: the number, the series as floats,
+ * the funnel counts as a flat step-by-breakdown table with each step's
+ * breakdowns already ranked, and the title, formatting and step names in
+ * one small string arena. Once the model is
+ * built the parser, and its JSON document, can be released, so UI
+ * callbacks waiting on the LVGL task hold a few hundred bytes rather than
+ * a document.
+ */
+class InsightModel {
+public:
+    /**
+     * @brief Extract a model from a parsed insight
+     * @param parser Valid parser holding the insight
+     * @return Model, or null if the parser is invalid
+     */
+    static std::shared_ptr<const InsightModel> fromParser(const InsightParser& parser);
+
+    /**
+     * @brief Get the detected visualization type
+     */
+    InsightParser::InsightType getType() const { return _type; }
+
+    /**
+     * @brief Get the insight title, "Insight" if it has none
+     */
+    const char* getTitle() const { return string(_title); }
+
+    /**
+     * @brief Get the numeric card prefix (e.g. "$"), empty if none
+     */
+    const char* getPrefix() const { return string(_prefix); }
+
+    /**
+     * @brief Get the numeric card suffix (e.g. "%"), empty if none
+     */
+    const char* getSuffix() const { return string(_suffix); }
+
+    /**
+     * @brief Get the value of a numeric card
+     */
+    double getNumericValue() const { return _numeric_value; }
+
+    /**
+     * @brief Get the number of points in a line graph series
+     */
+    size_t getSeriesPointCount() const { return _series.size(); }
+
+    /**
+     * @brief Get the series values, oldest first
+     * @return getSeriesPointCount() values, or null if there are none
+     */
+    const float* getSeriesValues() const { return _series.empty() ? nullptr : _series.data(); }
+
+    /**
+     * @brief Get the number of funnel steps
+     */
+    size_t getFunnelStepCount() const { return _step_names.size(); }
+
+    /**
+     * @brief Get the number of funnel breakdowns, 1 for a funnel without breakdowns
+     */
+    size_t getFunnelBreakdownCount() const { return _breakdown_count; }
+
+    /**
+     * @brief Get the name of a funnel step
+     * @param step Step index
+     * @return Step name, empty if unnamed or out of range
+     */
+    const char* getFunnelStepName(size_t step) const;
+
+    /**
+     * @brief Get the count for a funnel step, summed across breakdowns
+     * @param step Step index
+     * @return Count, 0 if out of range
+     */
+    uint32_t getFunnelStepTotal(size_t step) const;
+
+    /**
+     * @brief Get the count for one breakdown of a funnel step
+     * @param step Step index
+     * @param breakdown Breakdown index
+     * @return Count, 0 if out of range
+     */
+    uint32_t getFunnelCount(size_t step, size_t breakdown) const;
+
+    /**
+     * @brief Get the breakdowns of a funnel step from largest to smallest
+     * @param step Step index
+     * @param rank 0 for the breakdown with the highest count at this step
+     * @return Breakdown index; ties keep breakdown order
+     */
+    size_t getFunnelBreakdownAtRank(size_t step, size_t rank) const;
+
+    /**
+     * @brief Get the share of the first step's count that reached a step
+     * @param step Step index
+     * @return 0.0 - 1.0, 0 if out of range or the first step is empty
+     */
+    float getFunnelConversionRate(size_t step) const;
+
+    /**
+     * @brief Get the average time from the previous step, in seconds
+     * @param step Step index
+     * @return Time for the first breakdown, 0 for the first step or if out of range
+     */
+    float getFunnelAverageTime(size_t step) const;
+
+    /**
+     * @brief Get the median time from the previous step, in seconds
+     * @param step Step index
+     * @return Time for the first breakdown, 0 for the first step or if out of range
+     */
+    float getFunnelMedianTime(size_t step) const;
+
+    /**
+     * @brief Approximate heap used by the model, in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    InsightModel();
+
+    // Copy a string into the arena and return its offset
+    uint16_t addString(const char* value);
+
+    // Look up a string in the arena by offset
+    const char* string(uint16_t offset) const { return _strings.data() + offset; }
+
+    InsightParser::InsightType _type;
+    double _numeric_value;                ///< Value of a numeric card
+    std::vector<float> _series;           ///< Line graph values
+    std::vector<uint32_t> _step_totals;   ///< Funnel count per step, summed across breakdowns
+    std::vector<uint32_t> _funnel_counts; ///< Funnel counts, one row of breakdowns per step
+    std::vector<uint8_t> _breakdown_order; ///< Breakdown indices by descending count, one row per step
+    std::vector<float> _average_times;    ///< Average conversion time per step
+    std::vector<float> _median_times;     ///< Median conversion time per step
+    std::vector<uint16_t> _step_names;    ///< Arena offset of each funnel step name
+    size_t _breakdown_count;              ///< Columns in _funnel_counts
+    std::vector<char> _strings;           ///< Null-terminated strings, starting with an empty one
+    uint16_t _title;                      ///< Arena offset of the title
+    uint16_t _prefix;                     ///< Arena offset of the numeric prefix
+    uint16_t _suffix;                     ///< Arena offset of the numeric suffix
+};
@@ -1,50 +1,273 @@
 #include "InsightParser.h"
+#include "TimeFormat.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <algorithm> // Add for std::min
 
 #ifdef ARDUINO
 #include <Arduino.h>
 #endif
 
+typedef InsightParser::FilterType FilterType;
+
+// Room for the largest filter, the funnel breakdown one
+static const size_t FILTER_CAPACITY = 640;
+
+// Fields the funnel accessors read from each step
+static void addFunnelStepFilter(JsonObject step) {
+    step[JSON_KEY_NAME] = true;
+    step[JSON_KEY_CUSTOM_NAME] = true;
+    step[JSON_KEY_ID] = true;
+    step[JSON_KEY_ACTION_ID] = true;
+    step[JSON_KEY_ORDER] = true;
+    step[JSON_KEY_COUNT] = true;
+    step[JSON_KEY_AVERAGE_CONVERSION_TIME] = true;
+    step[JSON_KEY_MEDIAN_CONVERSION_TIME] = true;
+    step[JSON_KEY_BREAKDOWN] = true;
+    step[JSON_KEY_BREAKDOWN_VALUE] = true;
+}
+
+// Filter for a result: "result" of an insight, or "results" of a query response
+static void addResultFilter(JsonObject parent, const char* key, FilterType type) {
+    switch (type) {
+        case FilterType::NUMERIC:
+            parent[key][0][JSON_KEY_AGGREGATED_VALUE] = true;
+            break;
+        case FilterType::FUNNEL:
+            addFunnelStepFilter(parent[key][0].to<JsonObject>());
+            break;
+        case FilterType::FUNNEL_BREAKDOWN:
+            addFunnelStepFilter(parent[key][0][0].to<JsonObject>());
+            break;
+        default:
+            // Series points are [date, value] pairs and are read in full
+            parent[key] = true;
+            break;
+    }
+}
+
 // Filter to dramatically reduce memory usage by filtering out unused fields
-static StaticJsonDocument<256> createFilter() {
-    StaticJsonDocument<256> filter;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_NAME] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_RESULT] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_QUERY][JSON_KEY_DISPLAY] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_QUERY][JSON_KEY_CHART_SETTINGS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_QUERY][JSON_KEY_TABLE_SETTINGS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_INSIGHT] = true; // <--- FIX: Used JSON_KEY_INSIGHT
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_EVENTS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_ACTIONS] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL_UNIT] = true;
-    filter[JSON_KEY_RESULTS][0][JSON_KEY_COMPARE] = true; // Filter for "compare" at the results[0] level
+static StaticJsonDocument<FILTER_CAPACITY> createFilter(FilterType type) {
+    StaticJsonDocument<FILTER_CAPACITY> filter;
+    JsonObject insight = filter[JSON_KEY_RESULTS][0].to<JsonObject>();
+    insight[JSON_KEY_NAME] = true;
+    addResultFilter(insight, JSON_KEY_RESULT, type);
+    insight[JSON_KEY_QUERY][JSON_KEY_DISPLAY] = true;
+    insight[JSON_KEY_QUERY][JSON_KEY_SOURCE] = true; // Sent back to the query API on refresh
+    insight[JSON_KEY_FILTERS][JSON_KEY_INSIGHT] = true;
+    insight[JSON_KEY_COMPARE] = true; // Filter for "compare" at the results[0] level
+    insight[JSON_KEY_LAST_REFRESH] = true;
+    insight[JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH] = true;
+    insight[JSON_KEY_CACHE_TARGET_AGE] = true;
+    insight[JSON_KEY_QUERY_STATUS][JSON_KEY_ID] = true;
+    insight[JSON_KEY_QUERY_STATUS][JSON_KEY_COMPLETE] = true;
+    insight[JSON_KEY_QUERY_STATUS][JSON_KEY_ERROR] = true;
+
+    switch (type) {
+        case FilterType::FULL:
+            insight[JSON_KEY_QUERY][JSON_KEY_CHART_SETTINGS] = true;
+            insight[JSON_KEY_QUERY][JSON_KEY_TABLE_SETTINGS] = true;
+            insight[JSON_KEY_FILTERS][JSON_KEY_EVENTS] = true;
+            insight[JSON_KEY_FILTERS][JSON_KEY_ACTIONS] = true;
+            insight[JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL] = true;
+            insight[JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL_UNIT] = true;
+            break;
+        case FilterType::NUMERIC:
+            // Only the prefix and suffix are read from the chart and table settings
+            insight[JSON_KEY_QUERY][JSON_KEY_CHART_SETTINGS][JSON_KEY_YAXIS][0][JSON_KEY_SETTINGS][JSON_KEY_FORMATTING] = true;
+            insight[JSON_KEY_QUERY][JSON_KEY_TABLE_SETTINGS][JSON_KEY_COLUMNS][0][JSON_KEY_SETTINGS][JSON_KEY_FORMATTING] = true;
+            break;
+        case FilterType::FUNNEL:
+        case FilterType::FUNNEL_BREAKDOWN:
+            insight[JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL] = true;
+            insight[JSON_KEY_FILTERS][JSON_KEY_FUNNEL_WINDOW_INTERVAL_UNIT] = true;
+            break;
+        default:
+            break;
+    }
+    return filter;
+}
+
+// Filter for the full insight constructors
+static const JsonDocument& insightFilter(FilterType type) {
+    // Static filters for efficiency, built once
+    static StaticJsonDocument<FILTER_CAPACITY> filters[] = {
+        createFilter(FilterType::FULL),
+        createFilter(FilterType::NUMERIC),
+        createFilter(FilterType::SERIES),
+        createFilter(FilterType::FUNNEL),
+        createFilter(FilterType::FUNNEL_BREAKDOWN)
+    };
+    static_assert(sizeof(filters) / sizeof(filters[0]) == (size_t)FilterType::COUNT, "One filter per type");
+    return filters[(size_t)type];
+}
+
+// Filter for query API responses, which carry only the result and its freshness
+static StaticJsonDocument<384> createResultsFilter(FilterType type) {
+    StaticJsonDocument<384> filter;
+    addResultFilter(filter.to<JsonObject>(), JSON_KEY_RESULTS, type);
+    filter[JSON_KEY_LAST_REFRESH] = true;
+    filter[JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH] = true;
+    filter[JSON_KEY_CACHE_TARGET_AGE] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_ID] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_COMPLETE] = true;
+    filter[JSON_KEY_QUERY_STATUS][JSON_KEY_ERROR] = true;
     return filter;
 }
 
-InsightParser::InsightParser(const char* json) : doc(65536), valid(false) { // DynamicJsonDocument will allocate 64KB
-    static StaticJsonDocument<256> filter = createFilter(); // Static filter for efficiency
+static const JsonDocument& resultsFilter(FilterType type) {
+    static StaticJsonDocument<384> filters[] = {
+        createResultsFilter(FilterType::FULL),
+        createResultsFilter(FilterType::NUMERIC),
+        createResultsFilter(FilterType::SERIES),
+        createResultsFilter(FilterType::FUNNEL),
+        createResultsFilter(FilterType::FUNNEL_BREAKDOWN)
+    };
+    static_assert(sizeof(filters) / sizeof(filters[0]) == (size_t)FilterType::COUNT, "One filter per type");
+    return filters[(size_t)type];
+}
+
+static bool isFreshnessKey(const char* key) {
+    return strcmp(key, JSON_KEY_LAST_REFRESH) == 0 ||
+           strcmp(key, JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH) == 0 ||
+           strcmp(key, JSON_KEY_CACHE_TARGET_AGE) == 0 ||
+           strcmp(key, JSON_KEY_QUERY_STATUS) == 0;
+}
+
+// Copy the timestamps that describe a result; the query status is transient
+static void copyFreshness(JsonObjectConst from, JsonObject out) {
+    const char* keys[] = {JSON_KEY_LAST_REFRESH, JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH, JSON_KEY_CACHE_TARGET_AGE};
+    for (const char* key : keys) {
+        if (!from[key].isNull()) {
+            out[key] = from[key];
+        }
+    }
+}
+
+// Relative date_from that reaches back one bucket for a query interval
+static const char* seriesTailDateFrom(const char* interval) {
+    if (!interval) return nullptr;
+    if (strcmp(interval, "hour") == 0) return "-1h";
+    if (strcmp(interval, "day") == 0) return "-1d";
+    if (strcmp(interval, "week") == 0) return "-1w";
+    if (strcmp(interval, "month") == 0) return "-1m";
+    return nullptr;
+}
+
+// ArduinoJson custom writer that folds serialized output into an FNV-1a hash
+struct DigestWriter {
+    uint32_t digest = 2166136261u;
+
+    size_t write(uint8_t c) {
+        digest ^= c;
+        digest *= 16777619u;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            write(buffer[i]);
+        }
+        return length;
+    }
+};
 
+static void logPsramAvailability(size_t capacity) {
 #ifdef ARDUINO
     if (psramFound()) {
         size_t psramSize = ESP.getPsramSize();
         size_t psramFree = ESP.getFreePsram();
         Serial.printf("PSRAM available: %zu bytes, free: %zu bytes\n", psramSize, psramFree);
 
-        if (psramFree < 65536) {
-            Serial.println("Warning: Less than 64KB PSRAM free, parsing may fail");
+        if (ESP.getMaxAllocPsram() < capacity) {
+            Serial.printf("Warning: No free PSRAM block of %zu bytes, parsing may fail\n", capacity);
         }
     } else {
         Serial.println("Warning: PSRAM not found, using SRAM for JSON parsing");
     }
 #endif
+}
+
+static size_t clampDocumentCapacity(size_t capacity) {
+    if (capacity < InsightParser::MIN_DOCUMENT_CAPACITY) {
+        return InsightParser::MIN_DOCUMENT_CAPACITY;
+    }
+    if (capacity > InsightParser::MAX_DOCUMENT_CAPACITY) {
+        return InsightParser::MAX_DOCUMENT_CAPACITY;
+    }
+    return capacity;
+}
+
+size_t InsightParser::capacityForBody(size_t body_length) {
+    if (body_length == 0) {
+        return DOCUMENT_CAPACITY;
+    }
+    // A series of small numbers takes a 16-byte slot per few bytes of text;
+    // the filter drops enough of the rest that 4x covers real responses
+    return clampDocumentCapacity(body_length * 4);
+}
+
+InsightParser::InsightParser(const char* json)
+    : doc(capacityForBody(json ? strlen(json) : 0)), valid(false), m_parseCapacity(doc.capacity()), m_parseUsage(0)
+    , m_outOfMemory(false), m_filter(FilterType::FULL) {
+    logPsramAvailability(m_parseCapacity);
+
+    DeserializationError error = deserializeJson(doc, json, DeserializationOption::Filter(insightFilter(m_filter)));
+    validateDocument(error);
+}
+
+InsightParser::InsightParser(Stream& stream, size_t capacity, FilterType filter)
+    : doc(capacity), valid(false), m_parseCapacity(doc.capacity()), m_parseUsage(0)
+    , m_outOfMemory(false), m_filter(filter) {
+    logPsramAvailability(m_parseCapacity);
+
+    // The filter is applied while reading, so only the retained fields are ever stored
+    DeserializationError error = deserializeJson(doc, stream, DeserializationOption::Filter(insightFilter(m_filter)));
+    validateDocument(error);
+}
 
-    DeserializationError error = deserializeJson(doc, json, DeserializationOption::Filter(filter));
+InsightParser::InsightParser(std::shared_ptr<const InsightParser> metadata, Stream& stream, size_t capacity, FilterType filter)
+    : doc(capacity), valid(false), m_parseCapacity(doc.capacity()), m_parseUsage(0)
+    , m_outOfMemory(false), m_filter(filter), m_metadata(metadata) {
+    DeserializationError error = deserializeJson(doc, stream, DeserializationOption::Filter(resultsFilter(m_filter)));
+    m_parseUsage = doc.memoryUsage();
     if (error) {
         printf("JSON Deserialization failed: %s\n", error.c_str());
+        m_outOfMemory = (error == DeserializationError::NoMemory);
         return;
     }
+    doc.shrinkToFit();
+
+    m_insightDataRoot = doc.as<JsonObjectConst>();
+    if (!m_metadata || !m_metadata->isValid() || m_insightDataRoot.isNull()) {
+        printf("Query response has no insight metadata to go with it.\n");
+        return;
+    }
+    valid = true;
+    indexStructure();
+    checkFilter();
+}
+
+InsightParser::InsightParser(const uint8_t* data, size_t length)
+    : doc(clampDocumentCapacity(length * 16))
+    , valid(false), m_parseCapacity(doc.capacity()), m_parseUsage(0), m_outOfMemory(false), m_filter(FilterType::FULL) {
+    // Already filtered when it was saved, so no filter here. Every MessagePack
+    // value is at least one byte and takes at most one 16-byte slot, so 16x fits.
+    DeserializationError error = deserializeMsgPack(doc, reinterpret_cast<const char*>(data), length);
+    validateDocument(error);
+}
+
+void InsightParser::validateDocument(DeserializationError error) {
+    m_parseUsage = doc.memoryUsage();
+    if (error) {
+        printf("JSON Deserialization failed: %s\n", error.c_str());
+        m_outOfMemory = (error == DeserializationError::NoMemory);
+        return;
+    }
+
+    // Release the unused part of the capacity before the parser is handed on
+    doc.shrinkToFit();
 
     // --- Centralized m_insightDataRoot initialization and initial validation ---
     m_insightDataRoot = doc.as<JsonObjectConst>(); // Assuming the main insight object is at the root
@@ -77,6 +300,17 @@ InsightParser::InsightParser(const char* json) : doc(65536), valid(false) { // D
     // --- End m_insightDataRoot initialization and validation ---
 
     valid = true; // If we reached here, parsing and initial structure validation passed.
+    indexStructure();
+    checkFilter();
+}
+
+void InsightParser::checkFilter() {
+    // A narrow filter drops what other types read, so a result that no longer
+    // fits it (e.g. a breakdown was added to a funnel) can't be drawn
+    if (valid && m_filter != FilterType::FULL && hasResultData() && getFilterType() != m_filter) {
+        printf("Response doesn't match the %s filter, the insight may have changed type.\n", filterTypeName(m_filter));
+        valid = false;
+    }
 }
 
 bool InsightParser::getName(char* buffer, size_t bufferSize) const {
@@ -84,8 +318,7 @@ bool InsightParser::getName(char* buffer, size_t bufferSize) const {
         return false;
     }
 
-    // Use m_insightDataRoot
-    const char* name = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_NAME];
+    const char* name = insight()[JSON_KEY_NAME];
     if (!name) {
         return false;
     }
@@ -100,14 +333,10 @@ double InsightParser::getNumericCardValue() const {
         return 0.0;
     }
 
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    if (results.isNull() || results.size() == 0) return 0.0;
-
-    JsonObjectConst firstResultItem = results[0];
+    JsonObjectConst firstResultItem = insight();
     if (firstResultItem.isNull()) return 0.0;
 
-    JsonVariantConst resultField = firstResultItem[JSON_KEY_RESULT];
+    JsonVariantConst resultField = resultData();
     if (resultField.isNull() || !resultField.is<JsonArrayConst>()) return 0.0;
 
     JsonArrayConst resultArray = resultField.as<JsonArrayConst>();
@@ -139,18 +368,420 @@ bool InsightParser::isValid() const {
     return valid;
 }
 
-// Renamed and made private. All accessors must now use m_insightDataRoot
-bool InsightParser::private_hasNumericCardStructure() const {
-    if (!valid) return false;
+uint32_t InsightParser::getContentDigest() const {
+    if (!valid) {
+        return 0;
+    }
+
+    // MessagePack is the most compact serialization, so it is the cheapest to hash.
+    // Freshness timestamps and the query status change on every server-side
+    // recompute even when the numbers don't, so they are left out.
+    DigestWriter hasher;
+    for (JsonPairConst member : insight()) {
+        const char* key = member.key().c_str();
+        if (isFreshnessKey(key) || strcmp(key, JSON_KEY_RESULT) == 0) {
+            continue;
+        }
+        hasher.write(reinterpret_cast<const uint8_t*>(key), strlen(key));
+        serializeMsgPack(member.value(), hasher);
+    }
+    hasher.write(reinterpret_cast<const uint8_t*>(JSON_KEY_RESULT), strlen(JSON_KEY_RESULT));
+    serializeMsgPack(resultData(), hasher);
+    return hasher.digest;
+}
+
+bool InsightParser::getTimestamp(const char* key, time_t* timestamp) const {
+    if (!valid || !timestamp) {
+        return false;
+    }
+
+    const char* value = freshness()[key];
+    return TimeFormat::parseIso8601(value, timestamp);
+}
+
+bool InsightParser::getLastRefresh(time_t* timestamp) const {
+    return getTimestamp(JSON_KEY_LAST_REFRESH, timestamp);
+}
+
+bool InsightParser::getNextAllowedClientRefresh(time_t* timestamp) const {
+    return getTimestamp(JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH, timestamp);
+}
+
+bool InsightParser::getCacheTargetAge(time_t* timestamp) const {
+    return getTimestamp(JSON_KEY_CACHE_TARGET_AGE, timestamp);
+}
+
+bool InsightParser::getQueryStatus(char* id_buffer, size_t id_buffer_size, bool* complete, bool* error) const {
+    if (!valid || !id_buffer || id_buffer_size == 0) {
+        return false;
+    }
+
+    JsonObjectConst status = freshness()[JSON_KEY_QUERY_STATUS];
+    const char* id = status[JSON_KEY_ID];
+    if (!id || strlen(id) >= id_buffer_size) {
+        return false;
+    }
+
+    strcpy(id_buffer, id);
+    if (complete) {
+        *complete = status[JSON_KEY_COMPLETE] | false;
+    }
+    if (error) {
+        *error = status[JSON_KEY_ERROR] | false;
+    }
+    return true;
+}
+
+size_t InsightParser::serializeCompact(uint8_t* buffer, size_t bufferSize) const {
+    if (!valid) {
+        return 0;
+    }
+
+    // The query source is only needed to request results, not to render them
+    DynamicJsonDocument compact(documentUsage());
+    if (!buildCompactDocument(compact, true) || measureMsgPack(compact) > bufferSize) {
+        return 0;
+    }
+    return serializeMsgPack(compact, buffer, bufferSize);
+}
+
+std::shared_ptr<InsightParser> InsightParser::copyMetadata() const {
+    if (!valid || insight()[JSON_KEY_QUERY][JSON_KEY_SOURCE].isNull()) {
+        return nullptr;
+    }
+
+    DynamicJsonDocument metadata(documentUsage());
+    if (metadata.capacity() == 0) {
+        return nullptr;
+    }
+    writeInsight(metadata.createNestedArray(JSON_KEY_RESULTS).createNestedObject(), false, true);
+    if (metadata.overflowed()) {
+        return nullptr;
+    }
+    return shrinkCopy(metadata);
+}
+
+std::shared_ptr<InsightParser> InsightParser::copyCompact() const {
+    if (!valid) {
+        return nullptr;
+    }
+
+    DynamicJsonDocument compact(documentUsage());
+    if (!buildCompactDocument(compact, true)) {
+        return nullptr;
+    }
+    return shrinkCopy(compact);
+}
+
+std::shared_ptr<InsightParser> InsightParser::mergeSeriesTail(const InsightParser& tail) const {
+    if (!valid || !tail.isValid()) {
+        return nullptr;
+    }
+
+    // Arrays are linked lists, so they are walked with iterators and
+    // never indexed inside a loop
+    JsonArrayConst series = resultData();
+    JsonArrayConst newest = tail.resultData();
+    if (series.isNull() || newest.isNull() || newest.begin() == newest.end()) {
+        return nullptr;
+    }
+
+    // The tail normally starts at the last or second-to-last bucket;
+    // the last bucket with its first date is where it overlaps
+    const char* first_date = (*newest.begin())[0];
+    if (!first_date) {
+        return nullptr;
+    }
+    size_t length = 0;
+    size_t start = 0;
+    bool overlaps = false;
+    for (JsonVariantConst point : series) {
+        const char* date = point[0];
+        if (date && strcmp(date, first_date) == 0) {
+            start = length;
+            overlaps = true;
+        }
+        length++;
+    }
+    if (!overlaps) {
+        printf("Series tail starting %s doesn't overlap the cached series.\n", first_date);
+        return nullptr;
+    }
+
+    // Slide the window so the series keeps its length
+    size_t total = start + newest.size();
+    size_t drop = total > length ? total - length : 0;
+
+    DynamicJsonDocument merged(documentUsage() + tail.doc.memoryUsage());
+    if (merged.capacity() == 0) {
+        return nullptr;
+    }
+    JsonObject out = merged.createNestedArray(JSON_KEY_RESULTS).createNestedObject();
+    writeInsight(out, false, false);
+
+    JsonArray points = out.createNestedArray(JSON_KEY_RESULT);
+    size_t index = 0;
+    for (JsonVariantConst point : series) {
+        if (index >= start) {
+            break;
+        }
+        if (index++ >= drop) {
+            points.add(point);
+        }
+    }
+    for (JsonVariantConst point : newest) {
+        points.add(point);
+    }
+    copyFreshness(tail.freshness(), out);
+
+    if (merged.overflowed()) {
+        return nullptr;
+    }
+    return shrinkCopy(merged);
+}
+
+std::shared_ptr<InsightParser> InsightParser::fromPushedData(JsonObjectConst push) {
+    if (push.isNull()) {
+        return nullptr;
+    }
+
+    JsonVariantConst value = push["value"];
+    JsonArrayConst series = push["series"];
+    bool numeric = value.is<double>();
+    if (!numeric) {
+        if (series.isNull() || series.size() < 2 || series.size() > MAX_PUSHED_POINTS) {
+            return nullptr;
+        }
+        for (JsonVariantConst point : series) {
+            // Same [date, value] shape the line graph detection expects
+            const char* date = point[0];
+            if (point.size() != 2 || !date || strlen(date) < 10 || !point[1].is<double>()) {
+                return nullptr;
+            }
+        }
+    }
+
+    // Strings are linked rather than copied, so only the structure needs room
+    size_t points = numeric ? 1 : series.size();
+    DynamicJsonDocument wrapped(256 + JSON_ARRAY_SIZE(points) + points * JSON_ARRAY_SIZE(2));
+
+    // {"results": [{"name": <title>, "query": {"display": ...}, "result": [...]}]}
+    JsonObject insight = wrapped.createNestedArray(JSON_KEY_RESULTS).createNestedObject();
+    const char* title = push["title"] | (push["card"] | "");
+    insight[JSON_KEY_NAME] = title;
+    insight.createNestedObject(JSON_KEY_QUERY)[JSON_KEY_DISPLAY] =
+        numeric ? JSON_VAL_DISPLAY_BOLD_NUMBER : JSON_VAL_DISPLAY_ACTIONS_LINE_GRAPH;
+    JsonArray result = insight.createNestedArray(JSON_KEY_RESULT);
+    if (numeric) {
+        result.createNestedObject()[JSON_KEY_AGGREGATED_VALUE] = value.as<double>();
+    } else {
+        for (JsonVariantConst point : series) {
+            JsonArray copy = result.createNestedArray();
+            copy.add(point[0].as<const char*>());
+            copy.add(point[1].as<double>());
+        }
+    }
+    if (wrapped.overflowed()) {
+        return nullptr;
+    }
+
+    return shrinkCopy(wrapped);
+}
+
+size_t InsightParser::documentUsage() const {
+    return doc.memoryUsage() + (m_metadata ? m_metadata->doc.memoryUsage() : 0);
+}
+
+std::shared_ptr<InsightParser> InsightParser::shrinkCopy(const JsonDocument& source) {
+    // Round-trip through MessagePack so the copy is shrunk to its contents
+    size_t length = measureMsgPack(source);
+    uint8_t* buffer = static_cast<uint8_t*>(malloc(length));
+    if (!buffer) {
+        return nullptr;
+    }
+    serializeMsgPack(source, buffer, length);
+    std::shared_ptr<InsightParser> copy = std::make_shared<InsightParser>(buffer, length);
+    free(buffer);
+
+    if (!copy->isValid()) {
+        return nullptr;
+    }
+    return copy;
+}
+
+bool InsightParser::getQueryRequestBody(const char* refresh_mode, String& body) const {
+    if (!valid) {
+        return false;
+    }
+
+    JsonVariantConst source = insight()[JSON_KEY_QUERY][JSON_KEY_SOURCE];
+    if (source.isNull()) {
+        return false;
+    }
+
+    // {"query": <source>, "refresh": "<mode>"}, written piecewise so the source isn't copied
+    body = "{\"";
+    body += JSON_KEY_QUERY;
+    body += "\":";
+    serializeJson(source, body);
+    body += ",\"";
+    body += JSON_KEY_REFRESH;
+    body += "\":\"";
+    body += refresh_mode;
+    body += "\"}";
+    return true;
+}
+
+bool InsightParser::getSeriesTailRequestBody(const char* refresh_mode, String& body) const {
+    if (!valid) {
+        return false;
+    }
+
+    JsonObjectConst source = insight()[JSON_KEY_QUERY][JSON_KEY_SOURCE];
+    if (source.isNull()) {
+        return false;
+    }
 
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    if (results.isNull() || results.size() == 0) return false;
+    // Fixed ranges never change and comparisons shift the previous period too
+    JsonObjectConst range = source[JSON_KEY_DATE_RANGE];
+    const char* date_from = seriesTailDateFrom(source[JSON_KEY_INTERVAL]);
+    if (!date_from || !range[JSON_KEY_DATE_TO].isNull() || (source[JSON_KEY_COMPARE_FILTER][JSON_KEY_COMPARE] | false)) {
+        return false;
+    }
+
+    DynamicJsonDocument request(documentUsage() + 256);
+    if (request.capacity() == 0) {
+        return false;
+    }
+    JsonObject query = request.createNestedObject(JSON_KEY_QUERY);
+    for (JsonPairConst member : source) {
+        if (strcmp(member.key().c_str(), JSON_KEY_DATE_RANGE) != 0) {
+            query[member.key()] = member.value();
+        }
+    }
+    JsonObject narrowed = query.createNestedObject(JSON_KEY_DATE_RANGE);
+    for (JsonPairConst member : range) {
+        narrowed[member.key()] = member.value();
+    }
+    narrowed[JSON_KEY_DATE_FROM] = date_from;
+    request[JSON_KEY_REFRESH] = refresh_mode;
+    if (request.overflowed()) {
+        return false;
+    }
+
+    body = "";
+    serializeJson(request, body);
+    return true;
+}
+
+void InsightParser::indexStructure() {
+    if (m_metadata) {
+        // Query API responses carry the insight's result as their top-level results
+        m_index.insight = m_metadata->insight();
+        m_index.result = m_insightDataRoot[JSON_KEY_RESULTS];
+    } else {
+        m_index.insight = m_insightDataRoot[JSON_KEY_RESULTS][0];
+        m_index.result = m_index.insight[JSON_KEY_RESULT];
+    }
+
+    // In dependency order: the later checks read the earlier flags
+    m_index.funnel = detectFunnelStructure();
+    m_index.funnel_result = detectFunnelResultData();
+    m_index.funnel_nested = detectFunnelNestedStructure();
+    m_index.numeric = detectNumericCardStructure();
+    m_index.line_graph = detectLineGraphStructure();
+    m_index.area_chart = detectAreaChartStructure();
+    m_index.series_points = m_index.line_graph ? m_index.result.size() : 0;
+
+    // Order of checks: from most specific/unique identifier to more general.
+    // Funnel is often uniquely identified by filters.insight="FUNNELS"
+    if (m_index.funnel) {
+        m_index.type = InsightType::FUNNEL;
+    } else if (m_index.numeric) {
+        // Numeric card has a distinct result structure or "BoldNumber" display type
+        m_index.type = InsightType::NUMERIC_CARD;
+    } else if (m_index.area_chart) {
+        // Area charts are a specific type of line graph, checked before the generic one
+        m_index.type = InsightType::AREA_CHART;
+    } else if (m_index.line_graph) {
+        m_index.type = InsightType::LINE_GRAPH;
+    } else {
+        m_index.type = InsightType::INSIGHT_NOT_SUPPORTED;
+    }
+}
+
+JsonObjectConst InsightParser::freshness() const {
+    if (m_metadata) {
+        return m_insightDataRoot;
+    }
+    return insight();
+}
+
+void InsightParser::writeInsight(JsonObject out, bool include_result, bool include_source) const {
+    for (JsonPairConst member : insight()) {
+        const char* key = member.key().c_str();
+        if (isFreshnessKey(key) || strcmp(key, JSON_KEY_RESULT) == 0) {
+            continue;
+        }
+        if (strcmp(key, JSON_KEY_QUERY) == 0 && !include_source) {
+            JsonObject query = out.createNestedObject(JSON_KEY_QUERY);
+            for (JsonPairConst setting : member.value().as<JsonObjectConst>()) {
+                if (strcmp(setting.key().c_str(), JSON_KEY_SOURCE) != 0) {
+                    query[setting.key()] = setting.value();
+                }
+            }
+            continue;
+        }
+        out[member.key()] = member.value();
+    }
+
+    // The key must exist for validation even when the result is left out
+    if (include_result) {
+        out[JSON_KEY_RESULT] = resultData();
+    } else {
+        out[JSON_KEY_RESULT] = nullptr;
+    }
+
+    // Timestamps describe the result, so they go with it
+    if (include_result) {
+        copyFreshness(freshness(), out);
+    }
+}
 
-    JsonObjectConst firstResultItem = results[0];
+bool InsightParser::buildCompactDocument(DynamicJsonDocument& compact, bool include_result) const {
+    if (compact.capacity() == 0) {
+        return false;
+    }
+    writeInsight(compact.createNestedArray(JSON_KEY_RESULTS).createNestedObject(), include_result, false);
+    return !compact.overflowed();
+}
+
+bool InsightParser::hasResultData() const {
+    if (!valid) {
+        return false;
+    }
+
+    JsonVariantConst resultField = resultData();
+    if (resultField.isNull()) {
+        return false;
+    }
+    if (resultField.is<JsonArrayConst>()) {
+        return resultField.as<JsonArrayConst>().size() > 0;
+    }
+    if (resultField.is<JsonObjectConst>()) {
+        return resultField.as<JsonObjectConst>().size() > 0;
+    }
+    return true;
+}
+
+// Run once by indexStructure()
+bool InsightParser::detectNumericCardStructure() const {
+    if (!valid) return false;
+
+    JsonObjectConst firstResultItem = insight();
     if (firstResultItem.isNull()) return false;
 
-    JsonVariantConst resultField = firstResultItem[JSON_KEY_RESULT];
+    JsonVariantConst resultField = resultData();
     if (resultField.isNull() || !resultField.is<JsonArrayConst>()) return false;
 
     JsonArrayConst resultArray = resultField.as<JsonArrayConst>();
@@ -183,21 +814,17 @@ bool InsightParser::private_hasNumericCardStructure() const {
     return false;
 }
 
-// Renamed and made private. All accessors must now use m_insightDataRoot
-bool InsightParser::private_hasLineGraphStructure() const {
+// Run once by indexStructure()
+bool InsightParser::detectLineGraphStructure() const {
     if (!valid) return false;
 
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    if (results.isNull() || results.size() == 0) return false;
-
-    JsonObjectConst firstResult = results[0];
+    JsonObjectConst firstResult = insight();
     if (firstResult.isNull()) return false;
     
     // Check for line graph structure:
     // - results array exists
     // - first result has result array with multiple points
-    JsonArrayConst timeseriesData = firstResult[JSON_KEY_RESULT];
+    JsonArrayConst timeseriesData = resultData();
     if (timeseriesData.isNull() || timeseriesData.size() <= 1) return false; // Needs at least 2 points for a line graph
 
     // Additional check: verify it's explicitly a line graph if display type is present
@@ -218,18 +845,14 @@ bool InsightParser::private_hasLineGraphStructure() const {
     return firstPoint[1].is<double>();
 }
 
-// Renamed and made private. All accessors must now use m_insightDataRoot
-bool InsightParser::private_hasAreaChartStructure() const {
+// Run once by indexStructure()
+bool InsightParser::detectAreaChartStructure() const {
     if (!valid) return false;
     
     // Area charts are similar to line graphs but typically have
     // an additional "compare" property or explicit display type.
 
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    if (results.isNull() || results.size() == 0) return false;
-    
-    JsonObjectConst firstResult = results[0];
+    JsonObjectConst firstResult = insight();
     if (firstResult.isNull()) return false;
 
     // Primary check: explicit display type
@@ -256,33 +879,48 @@ bool InsightParser::private_hasAreaChartStructure() const {
     return false;
 }
 
-// Renamed from detectInsightType, added const
 InsightParser::InsightType InsightParser::getInsightType() const {
     if (!valid) return InsightType::INSIGHT_NOT_SUPPORTED;
-    
-    // Order of checks: from most specific/unique identifier to more general.
-    // Funnel is often uniquely identified by filters.insight="FUNNELS"
-    if (private_hasFunnelStructure()) return InsightType::FUNNEL;
-    
-    // Numeric card has a distinct result structure or "BoldNumber" display type
-    if (private_hasNumericCardStructure()) return InsightType::NUMERIC_CARD;
+    return m_index.type;
+}
 
-    // Area charts are a specific type of line graph, often with "compare" data or explicit display.
-    // Check this before generic line graph.
-    if (private_hasAreaChartStructure()) return InsightType::AREA_CHART;
-    
-    // Line graphs are more generic time series.
-    if (private_hasLineGraphStructure()) return InsightType::LINE_GRAPH;
-    
-    return InsightType::INSIGHT_NOT_SUPPORTED;
+InsightParser::FilterType InsightParser::getFilterType() const {
+    if (!hasResultData()) {
+        return FilterType::FULL;
+    }
+
+    switch (getInsightType()) {
+        case InsightType::NUMERIC_CARD:
+            // The filter can only pick aggregated_value out of the older object form
+            return resultData()[0].is<JsonObjectConst>() ? FilterType::NUMERIC : FilterType::FULL;
+        case InsightType::LINE_GRAPH:
+        case InsightType::AREA_CHART:
+            return FilterType::SERIES;
+        case InsightType::FUNNEL:
+            if (!private_hasFunnelResultData()) {
+                return FilterType::FULL;
+            }
+            return private_hasFunnelNestedStructure() ? FilterType::FUNNEL_BREAKDOWN : FilterType::FUNNEL;
+        default:
+            return FilterType::FULL;
+    }
 }
 
-// Renamed and made private. All accessors must now use m_insightDataRoot
-bool InsightParser::private_hasFunnelStructure() const {
+const char* InsightParser::filterTypeName(FilterType filter) {
+    switch (filter) {
+        case FilterType::NUMERIC: return "numeric";
+        case FilterType::SERIES: return "series";
+        case FilterType::FUNNEL: return "funnel";
+        case FilterType::FUNNEL_BREAKDOWN: return "funnel_breakdown";
+        default: return "full";
+    }
+}
+
+// Run once by indexStructure()
+bool InsightParser::detectFunnelStructure() const {
     if (!valid) return false;
     
-    // Use m_insightDataRoot
-    JsonObjectConst firstResult = m_insightDataRoot[JSON_KEY_RESULTS][0];
+    JsonObjectConst firstResult = insight();
     if (firstResult.isNull()) return false; // Should be handled by constructor validation, but defensiveness
 
     JsonObjectConst filters = firstResult[JSON_KEY_FILTERS];
@@ -297,12 +935,11 @@ bool InsightParser::private_hasFunnelStructure() const {
     return false;
 }
 
-// Renamed and made private. All accessors must now use m_insightDataRoot
-bool InsightParser::private_hasFunnelResultData() const {
+// Run once by indexStructure()
+bool InsightParser::detectFunnelResultData() const {
     if (!valid || !private_hasFunnelStructure()) return false;
     
-    // Use m_insightDataRoot
-    JsonVariantConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+    JsonVariantConst result = resultData();
     if (result.isNull() || result.size() == 0) return false;
     
     // Try to access the first element
@@ -330,12 +967,11 @@ bool InsightParser::private_hasFunnelResultData() const {
     return false;
 }
 
-// Renamed and made private. All accessors must now use m_insightDataRoot
-bool InsightParser::private_hasFunnelNestedStructure() const {
+// Run once by indexStructure()
+bool InsightParser::detectFunnelNestedStructure() const {
     if (!valid || !private_hasFunnelStructure() || !private_hasFunnelResultData()) return false;
     
-    // Use m_insightDataRoot
-    JsonVariantConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+    JsonVariantConst result = resultData();
     JsonVariantConst firstElement = result[0];
     
     // If first element is an array, it's a nested structure (e.g., [[step1], [step2]])
@@ -349,23 +985,19 @@ bool InsightParser::private_hasFunnelNestedStructure() const {
 size_t InsightParser::getSeriesPointCount() const {
     if (!valid || !private_hasLineGraphStructure()) return 0;
     
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
-    return timeseriesData.size();
+    return m_index.series_points;
 }
 
 bool InsightParser::getSeriesYValues(double* yValues) const {
     if (!valid || !private_hasLineGraphStructure() || !yValues) return false;
     
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
-    size_t pointCount = timeseriesData.size();
+    JsonArrayConst timeseriesData = resultData();
     
-    // Extract y-values directly - format is consistent with [date_string, numeric_value]
-    for (size_t i = 0; i < pointCount; i++) {
-        yValues[i] = timeseriesData[i][1].as<double>();
+    // Extract y-values directly - format is consistent with [date_string, numeric_value].
+    // Iterated rather than indexed, since indexing an array walks it from the start.
+    size_t i = 0;
+    for (JsonVariantConst point : timeseriesData) {
+        yValues[i++] = point[1].as<double>();
     }
     
     return true;
@@ -374,13 +1006,17 @@ bool InsightParser::getSeriesYValues(double* yValues) const {
 bool InsightParser::getSeriesXLabel(size_t index, char* buffer, size_t bufferSize) const {
     if (!valid || !private_hasLineGraphStructure() || !buffer || bufferSize == 0) return false;
     
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
-    
-    if (index >= timeseriesData.size()) return false;
+    if (index >= m_index.series_points) return false;
     
-    const char* dateStr = timeseriesData[index][0];
+    // Walked like getSeriesYValues(), stopping at the requested point
+    const char* dateStr = nullptr;
+    size_t i = 0;
+    for (JsonVariantConst point : resultData()) {
+        if (i++ == index) {
+            dateStr = point[0];
+            break;
+        }
+    }
     if (!dateStr) return false;
     
     // Copy just the year and month (YYYY-MM) to keep labels compact
@@ -401,11 +1037,9 @@ void InsightParser::getSeriesRange(double* minValue, double* maxValue) const {
         return;
     }
     
-    // Use m_insightDataRoot
-    JsonArrayConst results = m_insightDataRoot[JSON_KEY_RESULTS];
-    JsonArrayConst timeseriesData = results[0][JSON_KEY_RESULT];
+    JsonArrayConst timeseriesData = resultData();
     
-    if (timeseriesData.size() == 0) {
+    if (m_index.series_points == 0) {
         *minValue = 0.0;
         *maxValue = 0.0;
         return;
@@ -414,8 +1048,8 @@ void InsightParser::getSeriesRange(double* minValue, double* maxValue) const {
     *minValue = timeseriesData[0][1].as<double>();
     *maxValue = *minValue;
     
-    for (size_t i = 1; i < timeseriesData.size(); i++) {
-        double value = timeseriesData[i][1].as<double>();
+    for (JsonVariantConst point : timeseriesData) {
+        double value = point[1].as<double>();
         if (value < *minValue) *minValue = value;
         if (value > *maxValue) *maxValue = value;
     }
@@ -428,16 +1062,14 @@ size_t InsightParser::getFunnelBreakdownCount() const {
     bool isNested = private_hasFunnelNestedStructure();
     
     if (isNested) {
-        // Use m_insightDataRoot
-        JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+        JsonArrayConst result = resultData();
         
         // Ensure the result is an array
         if (result.isNull()) {
             return 0;
         }
         
-        // Use literal 5 instead of MAX_BREAKDOWNS macro
-        return std::min(result.size(), (size_t)5);
+        return std::min(result.size(), (size_t)MAX_FUNNEL_BREAKDOWNS);
     } else {
         // For flat structure, we always have exactly one breakdown ("All users")
         return 1;
@@ -451,8 +1083,7 @@ size_t InsightParser::getFunnelStepCount() const {
     if (!private_hasFunnelResultData()) {
         size_t count = 0;
         
-        // Use m_insightDataRoot
-        JsonObjectConst filters = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS];
+        JsonObjectConst filters = insight()[JSON_KEY_FILTERS];
         if (filters.isNull()) return 0;
 
         JsonArrayConst events = filters[JSON_KEY_EVENTS];
@@ -468,8 +1099,7 @@ size_t InsightParser::getFunnelStepCount() const {
         return count;
     }
     
-    // Use m_insightDataRoot
-    JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
+    JsonArrayConst result = resultData();
     if (result.isNull()) return 0;
     
     // For flat structure, count the items in the result array
@@ -482,489 +1112,10 @@ size_t InsightParser::getFunnelStepCount() const {
     return firstBreakdown.size();
 }
 
-bool InsightParser::getFunnelStepData(
-    size_t breakdown_index,
-    size_t step_index,
-    char* name_buffer,
-    size_t name_buffer_size,
-    uint32_t* count,
-    double* conversion_time_avg,
-    double* conversion_time_median
-) const {
-    if (!valid || !private_hasFunnelStructure()) return false;
-    
-    // Handle unpopulated funnels
-    if (!private_hasFunnelResultData()) {
-        if (breakdown_index > 0) return false;
-        
-        // Use m_insightDataRoot
-        JsonObjectConst filters = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS];
-        if (filters.isNull()) return false;
-
-        // Get combined list of events and actions
-        JsonArrayConst events = filters[JSON_KEY_EVENTS];
-        JsonArrayConst actions = filters[JSON_KEY_ACTIONS];
-        
-        size_t total_steps = 0;
-        if (!events.isNull()) total_steps += events.size();
-        if (!actions.isNull()) total_steps += actions.size();
-        
-        if (step_index >= total_steps) return false;
-        
-        // Determine if we need to get from events or actions
-        JsonObjectConst step;
-        if (!events.isNull() && step_index < events.size()) {
-            step = events[step_index];
-        } else if (!actions.isNull()) {
-            step = actions[step_index - (events.isNull() ? 0 : events.size())];
-        } else {
-            return false;
-        }
-        
-        // Get step name if buffer provided
-        if (name_buffer && name_buffer_size > 0) {
-            const char* custom_name = step[JSON_KEY_CUSTOM_NAME];
-            if (custom_name) {
-                strncpy(name_buffer, custom_name, name_buffer_size - 1);
-                name_buffer[name_buffer_size - 1] = '\0';
-            } else {
-                const char* name = step[JSON_KEY_NAME];
-                if (name) {
-                    strncpy(name_buffer, name, name_buffer_size - 1);
-                    name_buffer[name_buffer_size - 1] = '\0';
-                } else {
-                    name_buffer[0] = '\0';
-                }
-            }
-        }
-        
-        // For null result, we don't have count and conversion times
-        if (count) *count = 0;
-        if (conversion_time_avg) *conversion_time_avg = 0.0;
-        if (conversion_time_median) *conversion_time_median = 0.0;
-        
-        return true;
-    }
-    
-    // Use m_insightDataRoot
-    JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
-    if (result.isNull()) return false;
-    
-    JsonObjectConst step;
-    
-    // Handle flat structure
-    if (!private_hasFunnelNestedStructure()) {
-        // For flat structure, ignore breakdown_index (except 0)
-        if (breakdown_index > 0) return false;
-        
-        // Check step_index is valid
-        if (step_index >= result.size()) return false;
-        
-        // Get step directly from result
-        step = result[step_index];
-    } else {
-        // Handle nested structure
-        // Check breakdown_index is valid
-        if (breakdown_index >= result.size() || breakdown_index >= 5) return false; // Use literal 5
-
-        JsonArrayConst breakdown = result[breakdown_index];
-        if (breakdown.isNull()) return false;
-        
-        // Check step_index is valid
-        if (step_index >= breakdown.size()) return false;
-        
-        // Get step from appropriate breakdown
-        step = breakdown[step_index];
-    }
-
-    if (step.isNull()) return false;
-    
-    // Extract data from step (same for both structures)
-    // Get step name if buffer provided
-    if (name_buffer && name_buffer_size > 0) {
-        const char* custom_name = step[JSON_KEY_CUSTOM_NAME];
-        if (custom_name) {
-            strncpy(name_buffer, custom_name, name_buffer_size - 1);
-            name_buffer[name_buffer_size - 1] = '\0';
-        } else {
-            const char* name = step[JSON_KEY_NAME];
-            if (name) {
-                strncpy(name_buffer, name, name_buffer_size - 1);
-                name_buffer[name_buffer_size - 1] = '\0';
-            } else {
-                name_buffer[0] = '\0';
-            }
-        }
-    }
-    
-    // Get count
-    if (count) {
-        *count = step[JSON_KEY_COUNT].as<uint32_t>();
-    }
-    
-    // Get conversion times
-    if (conversion_time_avg) {
-        *conversion_time_avg = step[JSON_KEY_AVERAGE_CONVERSION_TIME].as<double>();
-    }
-    
-    if (conversion_time_median) {
-        *conversion_time_median = step[JSON_KEY_MEDIAN_CONVERSION_TIME].as<double>();
-    }
-    
-    return true;
-}
-
-bool InsightParser::getFunnelBreakdownName(
-    size_t breakdown_index,
-    char* name_buffer,
-    size_t buffer_size
-) const {
-    if (!valid || !private_hasFunnelStructure() || !name_buffer || buffer_size == 0) return false;
-
-    // Check if we have a nested or flat structure
-    bool isNested = private_hasFunnelNestedStructure();
-
-    if (isNested) {
-        // Use m_insightDataRoot
-        JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
-
-        // Ensure the result is an array
-        if (result.isNull()) {
-            return false;
-        }
-
-        if (breakdown_index >= result.size() || breakdown_index >= 5) { // Use literal 5
-            return false;
-        }
-
-        // Get the breakdown name from the first step's breakdown field
-        JsonArrayConst breakdown_array = result[breakdown_index];
-        if (!breakdown_array.isNull() && breakdown_array.size() > 0) {
-            JsonObjectConst firstStepInBreakdown = breakdown_array[0];
-            if (!firstStepInBreakdown.isNull() && firstStepInBreakdown.containsKey(JSON_KEY_BREAKDOWN)) {
-                JsonArrayConst breakdown_data = firstStepInBreakdown[JSON_KEY_BREAKDOWN];
-                if (!breakdown_data.isNull() && breakdown_data.size() > 0) {
-                    const char* value = breakdown_data[0].as<const char*>();
-                    if (value) {
-                        strncpy(name_buffer, value, buffer_size - 1);
-                        name_buffer[buffer_size - 1] = '\0';
-                        return true;
-                    }
-                }
-            }
-        }
-    } else {
-        // For flat structure, we only have one breakdown
-        if (breakdown_index > 0) {
-            return false;
-        }
-        
-        // In flat structure, default to "All users"
-        strncpy(name_buffer, "All users", buffer_size - 1);
-        name_buffer[buffer_size - 1] = '\0';
-        return true;
-    }
-
-    name_buffer[0] = '\0';
-    return false;
-}
-
-bool InsightParser::getFunnelTotalCounts(
-    size_t breakdown_index,
-    uint32_t* counts,
-    double* conversion_rates
-) const {
-    if (!valid || !private_hasFunnelStructure() || !counts) return false;
-    
-    // Check if this is a flat or nested structure
-    bool isNested = private_hasFunnelNestedStructure();
-    size_t stepCount = getFunnelStepCount();
-    
-    if (stepCount == 0) {
-        return false;
-    }
-    
-    // Clear the buffer first
-    for (size_t i = 0; i < stepCount; i++) {
-        counts[i] = 0;
-    }
-
-    // Use m_insightDataRoot
-    JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
-    if (result.isNull()) {
-        return false;
-    }
-    
-    // For nested structure, we sum counts across all breakdowns for each step
-    if (isNested) {
-        size_t breakdownCount = std::min(result.size(), (size_t)5); // Use literal 5
-        for (size_t bd_idx = 0; bd_idx < breakdownCount; bd_idx++) {
-            JsonArrayConst breakdown_array = result[bd_idx];
-            if (!breakdown_array.isNull()) {
-                // For each step in this breakdown
-                size_t stepsInBreakdown = std::min(breakdown_array.size(), stepCount);
-                for (size_t step_idx = 0; step_idx < stepsInBreakdown; step_idx++) {
-                    counts[step_idx] += breakdown_array[step_idx][JSON_KEY_COUNT].as<uint32_t>();
-                }
-            }
-        }
-    } else {
-        // Simply copy from the flat structure directly (only one breakdown)
-        for (size_t step_idx = 0; step_idx < stepCount; step_idx++) {
-            counts[step_idx] = result[step_idx][JSON_KEY_COUNT].as<uint32_t>();
-        }
-    }
-    
-    // Calculate conversion rates if requested
-    if (conversion_rates && counts[0] > 0) {
-        for (size_t i = 0; i < stepCount; i++) {
-            if (i == 0) {
-                conversion_rates[i] = 1.0;
-            } else if (counts[i-1] > 0) {
-                conversion_rates[i] = (double)counts[i] / counts[i-1];
-            } else {
-                conversion_rates[i] = 0.0;
-            }
-        }
-    } else if (conversion_rates) {
-        for (size_t i = 0; i < stepCount; i++) {
-            conversion_rates[i] = 0.0;
-        }
-    }
-    
-    return true;
-}
-
-bool InsightParser::getFunnelConversionTimes(
-    size_t breakdown_index,
-    size_t step_index,
-    double* avg_time,
-    double* median_time
-) const {
-    if (!valid || !private_hasFunnelStructure()) return false;
-    if (step_index == 0) return false;
-    
-    // For unpopulated funnels, we can't provide conversion times
-    if (!private_hasFunnelResultData()) return false;
-    
-    // Use m_insightDataRoot
-    JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
-    if (result.isNull()) return false;
-
-    // For flat structure
-    if (!private_hasFunnelNestedStructure()) {
-        // Only support breakdown_index 0 for flat structure
-        if (breakdown_index > 0) return false;
-        
-        // Check step_index is valid
-        if (step_index >= result.size()) return false;
-        
-        // Get conversion times directly from step
-        JsonObjectConst step = result[step_index];
-        if (step.isNull()) return false;
-
-        if (avg_time) {
-            *avg_time = step[JSON_KEY_AVERAGE_CONVERSION_TIME].as<double>();
-        }
-        if (median_time) {
-            *median_time = step[JSON_KEY_MEDIAN_CONVERSION_TIME].as<double>();
-        }
-        
-        return true;
-    }
-    
-    // For nested structure, call getFunnelStepData which handles it
-    return getFunnelStepData(
-        breakdown_index,
-        step_index,
-        nullptr,
-        0,
-        nullptr,
-        avg_time,
-        median_time
-    );
-}
-
-bool InsightParser::getFunnelStepMetadata(
-    size_t step_index,
-    char* custom_name_buffer,
-    size_t name_buffer_size,
-    char* action_id_buffer,
-    size_t action_buffer_size
-) const {
-    if (!valid || !private_hasFunnelStructure()) return false;
-    
-    // For unpopulated funnels, get metadata from filters
-    if (!private_hasFunnelResultData()) {
-        // Use m_insightDataRoot
-        JsonObjectConst filters = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS];
-        if (filters.isNull()) return false;
-
-        JsonArrayConst events = filters[JSON_KEY_EVENTS];
-        JsonArrayConst actions = filters[JSON_KEY_ACTIONS];
-        
-        size_t total_steps = 0;
-        if (!events.isNull()) total_steps += events.size();
-        if (!actions.isNull()) total_steps += actions.size();
-        
-        if (step_index >= total_steps) return false;
-        
-        // Determine if we need to get from events or actions
-        JsonObjectConst step;
-        if (!events.isNull() && step_index < events.size()) {
-            step = events[step_index];
-        } else if (!actions.isNull()) {
-            step = actions[step_index - (events.isNull() ? 0 : events.size())];
-        } else {
-            return false;
-        }
-        
-        // Get custom name
-        if (custom_name_buffer && name_buffer_size > 0) {
-            const char* custom_name = step[JSON_KEY_CUSTOM_NAME];
-            if (custom_name) {
-                strncpy(custom_name_buffer, custom_name, name_buffer_size - 1);
-                custom_name_buffer[name_buffer_size - 1] = '\0';
-            } else {
-                custom_name_buffer[0] = '\0';
-            }
-        }
-        
-        // Get action ID (or event ID, typically "id" field in filters)
-        if (action_id_buffer && action_buffer_size > 0) {
-            const char* id = step[JSON_KEY_ID];
-            if (id) {
-                strncpy(action_id_buffer, id, action_buffer_size - 1);
-                action_id_buffer[action_buffer_size - 1] = '\0';
-            } else {
-                action_id_buffer[0] = '\0';
-            }
-        }
-        
-        return true;
-    }
-    
-    // For populated funnels
-    // Use m_insightDataRoot
-    JsonVariantConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
-    if (result.isNull()) return false;
-
-    JsonObjectConst step;
-    
-    // For flat structure
-    if (!private_hasFunnelNestedStructure()) {
-        if (step_index >= result.size()) return false;
-        step = result[step_index];
-    } else {
-        // For nested structure, use the first breakdown to get step metadata (names/IDs are consistent)
-        JsonArrayConst firstBreakdown = result[0];
-        if (firstBreakdown.isNull() || step_index >= firstBreakdown.size()) return false;
-        step = firstBreakdown[step_index];
-    }
-
-    if (step.isNull()) return false;
-    
-    // Get custom name
-    if (custom_name_buffer && name_buffer_size > 0) {
-        const char* custom_name = step[JSON_KEY_CUSTOM_NAME];
-        if (custom_name) {
-            strncpy(custom_name_buffer, custom_name, name_buffer_size - 1);
-            custom_name_buffer[name_buffer_size - 1] = '\0';
-        } else {
-            custom_name_buffer[0] = '\0';
-        }
-    }
-    
-    // Get action ID (for result data, it's typically "action_id")
-    if (action_id_buffer && action_buffer_size > 0) {
-        const char* action_id = step[JSON_KEY_ACTION_ID];
-        if (action_id) {
-            strncpy(action_id_buffer, action_id, action_buffer_size - 1);
-            action_id_buffer[action_buffer_size - 1] = '\0';
-        } else {
-            action_id_buffer[0] = '\0';
-        }
-    }
-    
-    return true;
-}
-
-bool InsightParser::getFunnelBreakdownComparison(
-    size_t step_index,
-    uint32_t* counts,
-    double* conversion_rates
-) const {
-    if (!valid || !private_hasFunnelStructure() || !counts) return false;
-
-    // Check if this is a flat or nested structure
-    bool isNested = private_hasFunnelNestedStructure();
-
-    // Use m_insightDataRoot
-    JsonArrayConst result = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_RESULT];
-    if (result.isNull()) {
-        return false;
-    }
-
-    size_t breakdownCount = getFunnelBreakdownCount();
-    if (breakdownCount == 0) {
-        return false;
-    }
-
-    // Initialize counts and conversion_rates. Use literal 5 for MAX_BREAKDOWNS limit.
-    for (size_t i = 0; i < 5; i++) {
-        counts[i] = 0;
-        if (conversion_rates) conversion_rates[i] = 0.0;
-    }
-
-    if (isNested) {
-        // For each breakdown, get the count for this step
-        for (size_t bd_idx = 0; bd_idx < breakdownCount; bd_idx++) {
-            JsonArrayConst breakdown_array = result[bd_idx];
-            if (!breakdown_array.isNull() && step_index < breakdown_array.size()) {
-                JsonObjectConst stepObj = breakdown_array[step_index];
-                if (!stepObj.isNull()) {
-                    // Extract count
-                    counts[bd_idx] = stepObj[JSON_KEY_COUNT].as<uint32_t>();
-                    
-                    // Calculate conversion rate compared to first step of THIS breakdown
-                    if (conversion_rates && breakdown_array.size() > 0) {
-                        uint32_t firstStepCount = breakdown_array[0][JSON_KEY_COUNT].as<uint32_t>();
-                        if (firstStepCount > 0) {
-                            conversion_rates[bd_idx] = (double)counts[bd_idx] / firstStepCount;
-                        } else {
-                            conversion_rates[bd_idx] = 0.0;
-                        }
-                    }
-                }
-            }
-        }
-    } else {
-        // Flat structure implementation (only one breakdown at index 0)
-        if (step_index >= result.size()) {
-            return false;
-        }
-        
-        counts[0] = result[step_index][JSON_KEY_COUNT].as<uint32_t>();
-        
-        // Calculate conversion rate compared to first step of the flat funnel
-        if (conversion_rates && result.size() > 0) {
-            uint32_t firstStepCount = result[0][JSON_KEY_COUNT].as<uint32_t>();
-            if (firstStepCount > 0) {
-                conversion_rates[0] = (double)counts[0] / firstStepCount;
-            } else {
-                conversion_rates[0] = 0.0;
-            }
-        }
-    }
-    
-    return true;
-}
-
 bool InsightParser::getFunnelTimeWindow(uint32_t* window_days) const {
     if (!valid || !private_hasFunnelStructure() || !window_days) return false;
     
-    // Use m_insightDataRoot
-    JsonObjectConst filters = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_FILTERS];
+    JsonObjectConst filters = insight()[JSON_KEY_FILTERS];
     if (filters.isNull()) return false;
     
     uint32_t interval = filters[JSON_KEY_FUNNEL_WINDOW_INTERVAL] | 0;
@@ -991,6 +1142,69 @@ bool InsightParser::getFunnelTimeWindow(uint32_t* window_days) const {
 }
 
 
+// Name shown for a funnel step
+static const char* funnelStepName(JsonObjectConst step) {
+    const char* custom_name = step[JSON_KEY_CUSTOM_NAME];
+    if (custom_name) {
+        return custom_name;
+    }
+    return step[JSON_KEY_NAME] | "";
+}
+
+size_t InsightParser::getFunnelTable(FunnelStep* steps, size_t max_steps) const {
+    if (!valid || !private_hasFunnelStructure() || !steps) return 0;
+
+    size_t step_count = std::min(getFunnelStepCount(), max_steps);
+    for (size_t i = 0; i < step_count; i++) {
+        steps[i] = FunnelStep();
+    }
+
+    // Unpopulated funnels only have their step definitions
+    if (!private_hasFunnelResultData()) {
+        JsonObjectConst filters = insight()[JSON_KEY_FILTERS];
+        size_t i = 0;
+        for (JsonVariantConst step : filters[JSON_KEY_EVENTS].as<JsonArrayConst>()) {
+            if (i >= step_count) break;
+            steps[i++].name = funnelStepName(step.as<JsonObjectConst>());
+        }
+        for (JsonVariantConst step : filters[JSON_KEY_ACTIONS].as<JsonArrayConst>()) {
+            if (i >= step_count) break;
+            steps[i++].name = funnelStepName(step.as<JsonObjectConst>());
+        }
+        return step_count;
+    }
+
+    // Fill one column of the table from one breakdown's steps
+    auto addBreakdown = [steps, step_count](JsonArrayConst breakdown, size_t column) {
+        size_t i = 0;
+        for (JsonVariantConst item : breakdown) {
+            if (i >= step_count) break;
+            JsonObjectConst step = item.as<JsonObjectConst>();
+            FunnelStep& row = steps[i++];
+            uint32_t count = step[JSON_KEY_COUNT].as<uint32_t>();
+            row.counts[column] = count;
+            row.total += count;
+            if (column == 0) {
+                row.name = funnelStepName(step);
+                row.average_conversion_time = step[JSON_KEY_AVERAGE_CONVERSION_TIME].as<double>();
+                row.median_conversion_time = step[JSON_KEY_MEDIAN_CONVERSION_TIME].as<double>();
+            }
+        }
+    };
+
+    JsonArrayConst result = resultData();
+    if (private_hasFunnelNestedStructure()) {
+        size_t column = 0;
+        for (JsonVariantConst breakdown : result) {
+            if (column >= MAX_FUNNEL_BREAKDOWNS) break;
+            addBreakdown(breakdown.as<JsonArrayConst>(), column++);
+        }
+    } else {
+        addBreakdown(result, 0);
+    }
+    return step_count;
+}
+
 // Helper function to extract formatting string (prefix or suffix)
 bool InsightParser::getFormattingString(const JsonObjectConst& query, const char* settingType, char* buffer, size_t bufferSize) {
     if (query.isNull() || bufferSize == 0) {
@@ -1057,8 +1271,7 @@ bool InsightParser::getNumericFormattingPrefix(char* buffer, size_t bufferSize)
         if (buffer) buffer[0] = '\0';
         return false;
     }
-    // Use m_insightDataRoot
-    JsonObjectConst query = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_QUERY];
+    JsonObjectConst query = insight()[JSON_KEY_QUERY];
     return getFormattingString(query, JSON_KEY_PREFIX, buffer, bufferSize);
 }
 
@@ -1067,7 +1280,6 @@ bool InsightParser::getNumericFormattingSuffix(char* buffer, size_t bufferSize)
         if (buffer) buffer[0] = '\0';
         return false;
     }
-    // Use m_insightDataRoot
-    JsonObjectConst query = m_insightDataRoot[JSON_KEY_RESULTS][0][JSON_KEY_QUERY];
+    JsonObjectConst query = insight()[JSON_KEY_QUERY];
     return getFormattingString(query, JSON_KEY_SUFFIX, buffer, bufferSize);
 }
\ No newline at end of file
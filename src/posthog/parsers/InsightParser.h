@@ -5,6 +5,17 @@
 // e.g., in platformio.ini: build_flags = -DARDUINOJSON_USE_PSRAM
 #define ARDUINOJSON_DEFAULT_NESTING_LIMIT 50
 #include <ArduinoJson.h>
+#include <Arduino.h> // Stream; the native environment gets a minimal one from lib/NativeShims
+#include <memory>
+#include <time.h>
+#include "PsramAllocator.h"
+
+// Largest document a parse may allocate, in bytes. Insights that need more
+// fail with NoMemory; each in-flight request also reserves this much of
+// POSTHOG_FETCH_PSRAM_BUDGET at most.
+#ifndef INSIGHT_PARSER_MAX_DOCUMENT
+#define INSIGHT_PARSER_MAX_DOCUMENT 196608
+#endif
 
 // REMOVED: #define MAX_BREAKDOWNS 5 // This constant is likely defined elsewhere (e.g., InsightCard.h) using static constexpr
 
@@ -39,16 +50,126 @@ public:
         INSIGHT_NOT_SUPPORTED ///< Unsupported or unrecognized insight type
     };
 
+    /**
+     * @enum FilterType
+     * @brief Which fields of a response a parse keeps
+     * 
+     * FULL keeps what any insight type could need, so it is used until an
+     * insight's type is known. The others keep only what that type's
+     * accessors read, e.g. just aggregated_value from a numeric result.
+     * Funnels with breakdowns nest their steps one level deeper, so they
+     * have a filter of their own.
+     */
+    enum class FilterType : uint8_t {
+        FULL,             ///< Every field any type reads
+        NUMERIC,          ///< aggregated_value and number formatting
+        SERIES,           ///< [date, value] points
+        FUNNEL,           ///< Step fields of a funnel without breakdowns
+        FUNNEL_BREAKDOWN, ///< Step fields of each breakdown
+        COUNT             ///< Number of filter types
+    };
+
+    /**
+     * @brief Document allocated for a response of unknown size, in bytes
+     * 
+     * Every document is shrunk to its contents once parsed, so this only
+     * bounds the memory needed while parsing.
+     */
+    static const size_t DOCUMENT_CAPACITY = 65536;
+
+    /**
+     * @brief Smallest document allocated for a parse, in bytes
+     */
+    static const size_t MIN_DOCUMENT_CAPACITY = 4096;
+
+    /**
+     * @brief Largest document allocated for a parse, in bytes
+     */
+    static const size_t MAX_DOCUMENT_CAPACITY = INSIGHT_PARSER_MAX_DOCUMENT;
+
+    /**
+     * @brief Longest series accepted by fromPushedData(), a year of daily points
+     */
+    static const size_t MAX_PUSHED_POINTS = 366;
+
+    /**
+     * @brief Most funnel breakdowns reported by the funnel accessors
+     */
+    static const size_t MAX_FUNNEL_BREAKDOWNS = 5;
+
+    /**
+     * @struct FunnelStep
+     * @brief One funnel step across its breakdowns, as read by getFunnelTable()
+     */
+    struct FunnelStep {
+        const char* name = "";                      ///< custom_name or name, valid while the parser is
+        uint32_t counts[MAX_FUNNEL_BREAKDOWNS] = {}; ///< Count per breakdown
+        uint32_t total = 0;                         ///< Count summed across breakdowns
+        double average_conversion_time = 0.0;       ///< Seconds from the previous step, first breakdown
+        double median_conversion_time = 0.0;        ///< Seconds from the previous step, first breakdown
+    };
+
     /**
      * @brief Constructor - parses JSON data
      * @param json Raw JSON string to parse
      * 
-     * Initializes parser with JSON data and attempts to allocate memory.
-     * On ESP32 platforms, will attempt to use PSRAM if available (requires ARDUINOJSON_USE_PSRAM build flag).
+     * The document is sized from the length of the JSON and allocated in
+     * PSRAM when the board has it.
      * Uses isValid() to check if parsing was successful.
      */
     InsightParser(const char* json);
 
+    /**
+     * @brief Constructor - parses JSON directly from a stream
+     * @param stream Stream positioned at the start of the JSON body (e.g. an HTTP response)
+     * @param capacity Document to allocate while parsing, in bytes (see capacityForBody())
+     * @param filter Fields to keep, from getFilterType() of the insight's last parse
+     * 
+     * Applies the filter while reading, so the raw response never has to be
+     * buffered in memory. A narrow filter that doesn't match the response
+     * (e.g. the insight was changed to another type) makes the parse invalid,
+     * so the caller can retry with FilterType::FULL.
+     * Uses isValid() to check if parsing was successful, and ranOutOfMemory()
+     * to tell whether a larger capacity would have helped.
+     */
+    InsightParser(Stream& stream, size_t capacity = DOCUMENT_CAPACITY, FilterType filter = FilterType::FULL);
+
+    /**
+     * @brief Constructor - parses a results-only query response
+     * @param metadata Parser holding the insight from an earlier full fetch
+     * @param stream Stream positioned at the start of a query API response
+     * @param capacity Document to allocate while parsing, in bytes
+     * @param filter Fields of the results to keep
+     * 
+     * Only the results and freshness fields are read from the stream; name,
+     * display settings, formatting and funnel configuration come from the
+     * metadata parser, which is kept alive by this one.
+     * Uses isValid() to check if parsing was successful.
+     */
+    InsightParser(std::shared_ptr<const InsightParser> metadata, Stream& stream, size_t capacity = DOCUMENT_CAPACITY,
+                  FilterType filter = FilterType::FULL);
+
+    /**
+     * @brief Estimate the document needed for a JSON body
+     * @param body_length Length of the uncompressed body, 0 if unknown
+     * @return Capacity in bytes, between MIN_DOCUMENT_CAPACITY and MAX_DOCUMENT_CAPACITY
+     * 
+     * Numbers are stored in 16-byte slots, so a filtered document can be a few
+     * times larger than the text it came from. With no length, DOCUMENT_CAPACITY.
+     */
+    static size_t capacityForBody(size_t body_length);
+
+    /**
+     * @brief Constructor - restores a document saved with serializeCompact()
+     * @param data MessagePack bytes
+     * @param length Number of bytes in data
+     * 
+     * The document is shrunk to its contents after loading, so restored
+     * parsers only hold what they need rather than the full capacity.
+     * Uses isValid() to check if parsing was successful.
+     */
+    InsightParser(const uint8_t* data, size_t length);
+
     /**
      * @brief Default destructor
      */
@@ -132,6 +253,41 @@ public:
      */
     void getSeriesRange(double* minValue, double* maxValue) const;
     
+    /**
+     * @brief Get the document allocated while parsing
+     * @return Capacity in bytes, before the document was shrunk to its contents
+     */
+    size_t getParseCapacity() const { return m_parseCapacity; }
+
+    /**
+     * @brief Get the memory the parse needed
+     * @return Bytes of getParseCapacity() in use when parsing stopped
+     */
+    size_t getParseUsage() const { return m_parseUsage; }
+
+    /**
+     * @brief Get the filter the response was parsed with
+     */
+    FilterType getParseFilter() const { return m_filter; }
+
+    /**
+     * @brief Get the narrowest filter that keeps everything this insight uses
+     * @return Filter for the next fetch of the insight; FULL if the result is
+     *         missing or its type isn't recognized
+     */
+    FilterType getFilterType() const;
+
+    /**
+     * @brief Get a short name for a filter type, for logs and metrics
+     */
+    static const char* filterTypeName(FilterType filter);
+
+    /**
+     * @brief Check whether parsing failed for lack of document capacity
+     * @return true if the response didn't fit getParseCapacity()
+     */
+    bool ranOutOfMemory() const { return m_outOfMemory; }
+
     /**
      * @brief Check if parsing was successful
      * @return true if JSON was parsed successfully
@@ -142,149 +298,153 @@ public:
     bool isValid() const;
 
     /**
-     * @brief Determine visualization type from JSON structure
-     * @return Detected InsightType
+     * @brief Check whether the insight carries computed result data
+     * @return true if the result field is present and not empty
      * 
-     * Analyzes the JSON structure to determine the appropriate visualization type.
-     * Should be called before using type-specific methods.
+     * A cold server-side cache returns the insight with a null or empty
+     * result, in which case a blocking refresh is required.
      */
-    InsightType getInsightType() const;
-    
-    // Funnel-specific public methods
-    
+    bool hasResultData() const;
+
     /**
-     * @brief Get number of funnel breakdowns
-     * @return Number of breakdowns or 1 if no breakdowns
+     * @brief Compute a digest of the retained insight data
+     * @return 32-bit FNV-1a hash of the filtered document, or 0 if invalid
      * 
-     * Returns the number of breakdown series in the funnel.
-     * Limited by MAX_BREAKDOWNS (5), assuming MAX_BREAKDOWNS is defined globally/in a common header.
+     * Only fields kept by the parse filter contribute, and the freshness
+     * timestamps and query status are skipped, so two responses that render identically
+     * produce the same digest.
      */
-    size_t getFunnelBreakdownCount() const;
+    uint32_t getContentDigest() const;
 
     /**
-     * @brief Get number of steps in funnel
-     * @return Number of funnel steps
-     * 
-     * Returns total number of steps across all events/actions.
-     * Works for both populated and unpopulated funnels.
+     * @brief Get when the server last computed the insight result
+     * @param timestamp Receives the Unix time (UTC)
+     * @return true if the response carried a parseable last_refresh
      */
-    size_t getFunnelStepCount() const;
-    
+    bool getLastRefresh(time_t* timestamp) const;
+
     /**
-     * @brief Get data for a specific funnel step
-     * 
-     * @param breakdown_index Index of breakdown to get data for
-     * @param step_index Index of step within breakdown
-     * @param name_buffer Buffer to store step name
-     * @param name_buffer_size Size of name buffer
-     * @param count Pointer to store step count
-     * @param conversion_time_avg Pointer to store average conversion time
-     * @param conversion_time_median Pointer to store median conversion time
-     * @return true if data was retrieved successfully
+     * @brief Get the earliest time the server will recompute on request
+     * @param timestamp Receives the Unix time (UTC)
+     * @return true if the response carried a parseable next_allowed_client_refresh
      * 
-     * Retrieves comprehensive data about a specific step in a funnel breakdown.
-     * Any parameter except indices can be null if that data isn't needed.
-     */
-    bool getFunnelStepData(
-        size_t breakdown_index,
-        size_t step_index,
-        char* name_buffer,
-        size_t name_buffer_size,
-        uint32_t* count,
-        double* conversion_time_avg,
-        double* conversion_time_median
-    ) const;
-    
+     * Polling before this time returns the same cached result.
+     */
+    bool getNextAllowedClientRefresh(time_t* timestamp) const;
+
     /**
-     * @brief Get name of a funnel breakdown
-     * 
-     * @param breakdown_index Index of breakdown
-     * @param buffer Buffer to store name
-     * @param buffer_size Size of buffer
-     * @return true if name was retrieved successfully
-     * 
-     * Gets the identifying name for a specific breakdown series.
-     * Returns "All users" for flat (non-breakdown) funnels.
-     */
-    bool getFunnelBreakdownName(
-        size_t breakdown_index,
-        char* buffer,
-        size_t buffer_size
-    ) const;
-    
+     * @brief Get the time after which the server considers its cache stale
+     * @param timestamp Receives the Unix time (UTC)
+     * @return true if the response carried a parseable cache_target_age
+     */
+    bool getCacheTargetAge(time_t* timestamp) const;
+
     /**
-     * @brief Get total counts and conversion rates for all steps
-     * 
-     * @param breakdown_index Index of breakdown to analyze
-     * @param counts Array to store step counts (must fit getFunnelStepCount())
-     * @param conversion_rates Array to store conversion rates (optional)
-     * @return true if data was retrieved successfully
+     * @brief Get the status of a query started with refresh=async
+     * @param id_buffer Buffer to store the query ID
+     * @param id_buffer_size Size of buffer
+     * @param complete Receives whether the result has been computed (optional)
+     * @param error Receives whether the query failed (optional)
+     * @return true if the response carried a query status
+     */
+    bool getQueryStatus(char* id_buffer, size_t id_buffer_size, bool* complete, bool* error) const;
+
+    /**
+     * @brief Serialize the retained insight data as MessagePack
+     * @param buffer Destination buffer
+     * @param bufferSize Size of buffer
+     * @return Number of bytes written, or 0 if invalid or the buffer is too small
      * 
-     * Retrieves the total user count for each step and optionally calculates
-     * step-to-step conversion rates. For nested structures, sums across breakdowns.
-     */
-    bool getFunnelTotalCounts(
-        size_t breakdown_index,
-        uint32_t* counts,
-        double* conversion_rates
-    ) const;
-    
+     * The output can be passed back to the MessagePack constructor.
+     */
+    size_t serializeCompact(uint8_t* buffer, size_t bufferSize) const;
+
     /**
-     * @brief Get conversion times for a specific step
+     * @brief Copy everything except the result into a new, right-sized parser
+     * @return Metadata parser for the results-only constructor, or null if
+     *         invalid, the insight has no query source, or memory ran out
+     */
+    std::shared_ptr<InsightParser> copyMetadata() const;
+
+    /**
+     * @brief Copy the retained data, without the query source, into a new, right-sized parser
+     * @return Compact parser, or null if invalid or memory ran out
+     */
+    std::shared_ptr<InsightParser> copyCompact() const;
+
+    /**
+     * @brief Splice the newest buckets of a time series onto this one
+     * @param tail Results-only parser for a narrowed date range (see getSeriesTailRequestBody)
+     * @return Right-sized parser with this insight's settings, the merged series
+     *         and the tail's freshness fields, or null if the tail doesn't
+     *         overlap the end of this series or memory ran out
      * 
-     * @param breakdown_index Index of breakdown
-     * @param step_index Index of step (must be > 0)
-     * @param avg_time Pointer to store average conversion time
-     * @param median_time Pointer to store median conversion time
-     * @return true if times were retrieved successfully
+     * Buckets are matched by date: the tail replaces this series from its
+     * first date onwards, and the oldest buckets are dropped so the
+     * series keeps its length.
+     */
+    std::shared_ptr<InsightParser> mergeSeriesTail(const InsightParser& tail) const;
+
+    /**
+     * @brief Build a parser from data pushed over the local network
+     * @param push Object with an optional "title" (defaulting to its "card" ID)
+     *             and either a numeric "value" or a "series" of [date, value] points
+     * @return Right-sized parser that reads as a numeric card or line graph,
+     *         or null if the data is malformed or memory ran out
      * 
-     * Gets the average and median conversion times from previous step.
-     * Not applicable to first step (step_index 0).
-     */
-    bool getFunnelConversionTimes(
-        size_t breakdown_index,
-        size_t step_index,
-        double* avg_time,
-        double* median_time
-    ) const;
-    
+     * The pushed data is wrapped in the same shape as an insights API
+     * response, so cards render it exactly like fetched data.
+     */
+    static std::shared_ptr<InsightParser> fromPushedData(JsonObjectConst push);
+
+    /**
+     * @brief Build the body of a query API request for this insight
+     * @param refresh_mode Cache control mode (e.g. "force_cache" or "async")
+     * @param body Receives the JSON request body
+     * @return true if the insight carries a query source to send
+     */
+    bool getQueryRequestBody(const char* refresh_mode, String& body) const;
+
     /**
-     * @brief Get metadata about a funnel step
+     * @brief Build a query API request for only the newest buckets of a time series
+     * @param refresh_mode Cache control mode (e.g. "force_cache" or "async")
+     * @param body Receives the JSON request body
+     * @return true if the query is a rolling time series that can be narrowed;
+     *         false for fixed date ranges, comparisons or unsupported intervals
      * 
-     * @param step_index Index of step
-     * @param custom_name_buffer Buffer for custom step name
-     * @param name_buffer_size Size of name buffer
-     * @param action_id_buffer Buffer for action/event ID
-     * @param action_buffer_size Size of action buffer
-     * @return true if metadata was retrieved successfully
+     * The query source is sent with date_from moved back one interval, so
+     * the response holds the current bucket and the one before it.
+     */
+    bool getSeriesTailRequestBody(const char* refresh_mode, String& body) const;
+
+    /**
+     * @brief Determine visualization type from JSON structure
+     * @return Detected InsightType
      * 
-     * Retrieves configuration metadata about a step, including custom names
-     * and action/event IDs. Works for both populated and unpopulated funnels.
-     */
-    bool getFunnelStepMetadata(
-        size_t step_index,
-        char* custom_name_buffer,
-        size_t name_buffer_size,
-        char* action_id_buffer,
-        size_t action_buffer_size
-    ) const;
+     * The structure is analyzed once when the document is parsed, so this is
+     * cheap to call. Should be called before using type-specific methods.
+     */
+    InsightType getInsightType() const;
+    
+    // Funnel-specific public methods
     
     /**
-     * @brief Compare step metrics across breakdowns
+     * @brief Get number of funnel breakdowns
+     * @return Number of breakdowns or 1 if no breakdowns
      * 
-     * @param step_index Step to compare
-     * @param counts Array to store counts per breakdown
-     * @param conversion_rates Array to store conversion rates per breakdown
-     * @return true if comparison data was retrieved
+     * Returns the number of breakdown series in the funnel,
+     * limited to MAX_FUNNEL_BREAKDOWNS.
+     */
+    size_t getFunnelBreakdownCount() const;
+
+    /**
+     * @brief Get number of steps in funnel
+     * @return Number of funnel steps
      * 
-     * Retrieves counts and conversion rates for a specific step
-     * across all breakdowns for comparison.
-     */
-    bool getFunnelBreakdownComparison(
-        size_t step_index,
-        uint32_t* counts,
-        double* conversion_rates
-    ) const;
+     * Returns total number of steps across all events/actions.
+     * Works for both populated and unpopulated funnels.
+     */
+    size_t getFunnelStepCount() const;
     
     /**
      * @brief Get funnel analysis time window
@@ -297,18 +457,99 @@ public:
      */
     bool getFunnelTimeWindow(uint32_t* window_days) const;
 
+    /**
+     * @brief Read every step of a funnel in one pass over the result
+     * 
+     * @param steps Array receiving the steps in order
+     * @param max_steps Size of steps; getFunnelStepCount() reads them all
+     * @return Number of steps filled in, 0 if the insight isn't a funnel
+     * 
+     * Walks each breakdown once, so the whole table of steps and breakdowns
+     * costs one pass over the result. Funnels without results get their step
+     * names from the insight's events and actions, with zero counts.
+     */
+    size_t getFunnelTable(FunnelStep* steps, size_t max_steps) const;
+
 private:
-    DynamicJsonDocument doc;              ///< JSON document for parsing (allocated on heap/PSRAM)
+    PsramJsonDocument doc;              ///< JSON document, shrunk to its contents after parsing
     bool valid;                         ///< Parsing status flag
+    size_t m_parseCapacity;             ///< Capacity allocated for parsing
+    size_t m_parseUsage;                ///< Capacity in use when parsing stopped
+    bool m_outOfMemory;                 ///< Parsing stopped with NoMemory
+    FilterType m_filter;                ///< Filter the response was parsed with
     JsonObjectConst m_insightDataRoot;  ///< Points to the JsonObject containing the main "results" array
+    std::shared_ptr<const InsightParser> m_metadata; ///< Insight metadata, for results-only parsers
+
+    /**
+     * @struct StructureIndex
+     * @brief Where the data is and what shape it has, found once per parse
+     * 
+     * The document never changes after parsing, so the handles stay valid
+     * for the parser's lifetime and accessors reach their data directly
+     * instead of walking down from the root and re-running the type checks.
+     */
+    struct StructureIndex {
+        JsonObjectConst insight;    ///< results[0], from the metadata parser if there is one
+        JsonVariantConst result;    ///< The insight's computed result
+        InsightType type = InsightType::INSIGHT_NOT_SUPPORTED; ///< Detected visualization type
+        size_t series_points = 0;   ///< Points in a line graph series
+        bool numeric = false;       ///< Result holds a single number
+        bool line_graph = false;    ///< Result is a [date, value] series
+        bool area_chart = false;    ///< Series drawn as an area chart
+        bool funnel = false;        ///< Insight is a funnel
+        bool funnel_result = false; ///< Funnel result holds steps
+        bool funnel_nested = false; ///< Funnel steps are grouped by breakdown
+    };
+    StructureIndex m_index;             ///< Filled in once the document is valid
+
+    // Shared post-deserialization validation for all constructors
+    void validateDocument(DeserializationError error);
+
+    // Invalidate a parse whose result doesn't fit the narrow filter it was read with
+    void checkFilter();
+
+    // Locate the insight and its result and classify them, once the document is valid
+    void indexStructure();
+
+    // The insight object (results[0]), from the metadata parser if there is one
+    JsonObjectConst insight() const { return m_index.insight; }
+
+    // The insight's computed result
+    JsonVariantConst resultData() const { return m_index.result; }
+
+    // Object holding the freshness fields and query status
+    JsonObjectConst freshness() const;
+
+    // Copy the insight into out, optionally with its result and query source
+    void writeInsight(JsonObject out, bool include_result, bool include_source) const;
+
+    // Serialize the insight without its query source into a right-sized document
+    bool buildCompactDocument(DynamicJsonDocument& compact, bool include_result) const;
+
+    // Memory used by this parser's documents, including its metadata parser
+    size_t documentUsage() const;
+
+    // Load a built document into a parser shrunk to its contents
+    static std::shared_ptr<InsightParser> shrinkCopy(const JsonDocument& source);
+
+    // Parse an ISO 8601 timestamp member of results[0]
+    bool getTimestamp(const char* key, time_t* timestamp) const;
+
+    // Insight type checks, answered from the structure index
+    bool private_hasNumericCardStructure() const { return m_index.numeric; }
+    bool private_hasLineGraphStructure() const { return m_index.line_graph; }
+    bool private_hasAreaChartStructure() const { return m_index.area_chart; }
+    bool private_hasFunnelStructure() const { return m_index.funnel; }
+    bool private_hasFunnelResultData() const { return m_index.funnel_result; }
+    bool private_hasFunnelNestedStructure() const { return m_index.funnel_nested; }
 
-    // Private helper methods for insight type detection
-    bool private_hasNumericCardStructure() const;
-    bool private_hasLineGraphStructure() const;
-    bool private_hasAreaChartStructure() const;
-    bool private_hasFunnelStructure() const;
-    bool private_hasFunnelResultData() const;
-    bool private_hasFunnelNestedStructure() const;
+    // Insight type detection, run once by indexStructure(); each may rely on the checks run before it
+    bool detectNumericCardStructure() const;
+    bool detectLineGraphStructure() const;
+    bool detectAreaChartStructure() const;
+    bool detectFunnelStructure() const;
+    bool detectFunnelResultData() const;
+    bool detectFunnelNestedStructure() const;
 
     // Helper function to extract formatting string (prefix or suffix)
     static bool getFormattingString(const JsonObjectConst& query, const char* settingType, char* buffer, size_t bufferSize);
@@ -347,6 +588,19 @@ static const char* JSON_KEY_EVENTS = "events";
 static const char* JSON_KEY_ACTIONS = "actions";
 static const char* JSON_KEY_ID = "id";
 static const char* JSON_KEY_ACTION_ID = "action_id"; 
+static const char* JSON_KEY_LAST_REFRESH = "last_refresh";
+static const char* JSON_KEY_NEXT_ALLOWED_CLIENT_REFRESH = "next_allowed_client_refresh";
+static const char* JSON_KEY_CACHE_TARGET_AGE = "cache_target_age";
+static const char* JSON_KEY_QUERY_STATUS = "query_status";
+static const char* JSON_KEY_COMPLETE = "complete";
+static const char* JSON_KEY_ERROR = "error";
+static const char* JSON_KEY_SOURCE = "source";
+static const char* JSON_KEY_REFRESH = "refresh";
+static const char* JSON_KEY_INTERVAL = "interval";
+static const char* JSON_KEY_DATE_RANGE = "dateRange";
+static const char* JSON_KEY_DATE_FROM = "date_from";
+static const char* JSON_KEY_DATE_TO = "date_to";
+static const char* JSON_KEY_COMPARE_FILTER = "compareFilter";
 
 // Define common JSON values as constants
 static const char* JSON_VAL_INSIGHT_FUNNELS = "FUNNELS";
@@ -4,10 +4,13 @@
 #include "EventQueue.h"
 #include "OtaManager.h" // Required for OtaManager interaction
 #include "ui/CardController.h" // Required for CardController interaction
+#include "posthog/PostHogClient.h" // Required for request metrics
 #include "html_portal.h"  // For portal HTML
 #include <ArduinoJson.h>  // For JSON responses
 #include <pgmspace.h> // For PROGMEM
 #include <vector> // For std::vector (action queue)
+#include <algorithm> // For std::find (push cards)
+#include <memory> // For std::unique_ptr (push body)
 
 // Max size for the action queue
 const size_t MAX_ACTION_QUEUE_SIZE = 5; // Define a reasonable limit
@@ -22,6 +25,18 @@ struct QueuedAction { // Defined globally in this .cpp file
 // Forward declaration if QueuedAction is used before full definition within the class
 // struct QueuedAction; // Not strictly needed if defined before first use or within class scope directly
 
+// Store a request body in request->_tempObject for the request handler. Bodies
+// can span several chunks, so the whole body is assembled and null-terminated.
+static void collectRequestBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if(index == 0){
+        request->_tempObject = malloc(total + 1);
+    }
+    if(request->_tempObject != NULL && index + len <= total){
+        memcpy((char*)request->_tempObject + index, data, len);
+        ((char*)request->_tempObject)[index + len] = 0;
+    }
+}
+
 // Definition for portalActionToString
 const char* portalActionToString(PortalAction action) {
     switch (action) {
@@ -38,13 +53,14 @@ const char* portalActionToString(PortalAction action) {
 }
 
 // Constructor
-CaptivePortal::CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController)
+CaptivePortal::CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController, PostHogClient& posthogClient)
     : _server(80),
       _configManager(configManager),
       _wifiInterface(wifiInterface),
       _eventQueue(eventQueue),
       _otaManager(otaManager), // Initialize the OtaManager reference
       _cardController(cardController), // Initialize the CardController reference
+      _posthogClient(posthogClient),
       _lastScanTime(0),
       _action_in_progress(PortalAction::NONE),
       _last_action_completed(PortalAction::NONE),
@@ -75,6 +91,7 @@ void CaptivePortal::begin() {
     // New API status endpoint
     // Serial.println("Registering /api/status..."); // DEBUG REMOVED
     _server.on("/api/status", HTTP_GET, std::bind(&CaptivePortal::handleApiStatus, this, std::placeholders::_1));
+    _server.on("/api/metrics", HTTP_GET, std::bind(&CaptivePortal::handleApiMetrics, this, std::placeholders::_1));
 
     // New async action triggering endpoints
     // Serial.println("Registering /api/actions/start-wifi-scan..."); // DEBUG REMOVED
@@ -86,6 +103,7 @@ void CaptivePortal::begin() {
     // Serial.println("Registering /api/actions/check-ota-update..."); // DEBUG REMOVED
     _server.on("/api/actions/check-ota-update", HTTP_POST, std::bind(&CaptivePortal::handleRequestCheckOtaUpdate, this, std::placeholders::_1));
     _server.on("/api/actions/start-ota-update", HTTP_POST, std::bind(&CaptivePortal::handleRequestStartOtaUpdate, this, std::placeholders::_1));
+    _server.on("/api/actions/reveal-push-token", HTTP_POST, std::bind(&CaptivePortal::handleRevealPushToken, this, std::placeholders::_1));
 
     // WiFi actions
     _server.on("/scan-networks", HTTP_GET, std::bind(&CaptivePortal::handleScanNetworks, this, std::placeholders::_1));
@@ -102,12 +120,17 @@ void CaptivePortal::begin() {
     _server.on("/api/cards/configured", HTTP_POST, 
               std::bind(&CaptivePortal::handleSaveConfiguredCards, this, std::placeholders::_1),
               NULL,
+              collectRequestBody);
+
+    // Data pushed from the local network
+    _server.on("/api/push", HTTP_OPTIONS, std::bind(&CaptivePortal::handleCorsPreflight, this, std::placeholders::_1));
+    _server.on("/api/push", HTTP_POST,
+              std::bind(&CaptivePortal::handlePushData, this, std::placeholders::_1),
+              NULL,
               [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
-                  // Store body data as a parameter for later processing
-                  request->_tempObject = malloc(len + 1);
-                  if(request->_tempObject != NULL){
-                      memcpy(request->_tempObject, data, len);
-                      ((char*)request->_tempObject)[len] = 0;
+                  // Oversized bodies are never buffered; the handler rejects them by length
+                  if (total <= MAX_PUSH_BODY_SIZE) {
+                      collectRequestBody(request, data, len, index, total);
                   }
               });
 
@@ -137,7 +160,7 @@ void CaptivePortal::handleCorsPreflight(AsyncWebServerRequest *request) {
     AsyncWebServerResponse *response = request->beginResponse(204);
     response->addHeader("Access-Control-Allow-Origin", "*");
     response->addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-    response->addHeader("Access-Control-Allow-Headers", "Content-Type");
+    response->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
     request->send(response);
 }
 
@@ -672,6 +695,10 @@ void CaptivePortal::handleApiStatus(AsyncWebServerRequest *request) {
     String apiKey = _configManager.getApiKey();
     deviceConfigObj["api_key_display"] = apiKey.length() > 0 ? "********" + apiKey.substring(apiKey.length() - 4) : "";
     deviceConfigObj["api_key_present"] = apiKey.length() > 0;
+    // The push token is a secret like the API key; the portal reveals it through
+    // /api/actions/reveal-push-token only when asked
+    String pushToken = _configManager.getPushToken();
+    deviceConfigObj["push_token_display"] = "********" + pushToken.substring(pushToken.length() - 4);
 
     JsonArray insightsArray = doc.createNestedArray("insights");
     std::vector<String> insightIds = _configManager.getAllInsightIds();
@@ -698,6 +725,8 @@ void CaptivePortal::handleApiStatus(AsyncWebServerRequest *request) {
     otaObj["release_notes"] = lastCheck.releaseNotes;        
     otaObj["error_message"] = lastCheck.error;               
 
+    _posthogClient.writeRateLimitStats(doc.createNestedObject("rate_limit"));
+
     String responseJson;
     serializeJson(doc, responseJson);
     AsyncWebServerResponse *response = request->beginResponse(200, "application/json", responseJson);
@@ -708,6 +737,18 @@ void CaptivePortal::handleApiStatus(AsyncWebServerRequest *request) {
     request->send(response);
 }
 
+void CaptivePortal::handleApiMetrics(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(16384);
+    _posthogClient.writeMetrics(doc.to<JsonObject>());
+
+    String responseJson;
+    serializeJson(doc, responseJson);
+    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", responseJson);
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    response->addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+    request->send(response);
+}
+
 void CaptivePortal::handleRequestWifiScan(AsyncWebServerRequest *request) {
     requestAction(PortalAction::SCAN_WIFI, request);
 }
@@ -830,7 +871,7 @@ void CaptivePortal::handleGetCardDefinitions(AsyncWebServerRequest *request) {
 }
 
 void CaptivePortal::handleGetConfiguredCards(AsyncWebServerRequest *request) {
-    DynamicJsonDocument doc(2048);
+    DynamicJsonDocument doc(ConfigManager::CARD_CONFIGS_DOC_SIZE);
     JsonArray cardsArray = doc.to<JsonArray>();
 
     // Get configured cards from ConfigManager
@@ -841,6 +882,7 @@ void CaptivePortal::handleGetConfiguredCards(AsyncWebServerRequest *request) {
         cardObj["config"] = config.config;
         cardObj["order"] = config.order;
         cardObj["name"] = config.name;
+        config.refresh.toJson(cardObj);
     }
 
     String responseJson;
@@ -862,7 +904,7 @@ void CaptivePortal::handleSaveConfiguredCards(AsyncWebServerRequest *request) {
         
         Serial.printf("Received card config body: %s\n", body.c_str());
         
-        DynamicJsonDocument doc(2048);
+        DynamicJsonDocument doc(ConfigManager::CARD_CONFIGS_DOC_SIZE);
         DeserializationError error = deserializeJson(doc, body);
         
         if (!error && doc.is<JsonArray>()) {
@@ -878,6 +920,7 @@ void CaptivePortal::handleSaveConfiguredCards(AsyncWebServerRequest *request) {
                     config.config = obj.containsKey("config") ? obj["config"].as<String>() : "";
                     config.order = obj["order"].as<int>();
                     config.name = obj.containsKey("name") ? obj["name"].as<String>() : "";
+                    config.refresh = RefreshPolicy::fromJson(obj["refresh"]);
                     cardConfigs.push_back(config);
                 }
             }
@@ -909,3 +952,125 @@ void CaptivePortal::handleSaveConfiguredCards(AsyncWebServerRequest *request) {
     response->addHeader("Access-Control-Allow-Origin", "*");
     request->send(response);
 }
+
+void CaptivePortal::handleRevealPushToken(AsyncWebServerRequest *request) {
+    // Only the portal's own page may read the token. Browsers send Origin on every
+    // fetch() POST, same-origin included, so a request without one didn't come from
+    // the portal (curl, a plain form post or another device) and is refused too.
+    if (!request->hasHeader("Origin") ||
+        request->header("Origin") != "http://" + request->host()) {
+        Serial.printf("Refused to reveal push token to origin '%s'\n",
+                      request->hasHeader("Origin") ? request->header("Origin").c_str() : "");
+        request->send(403, "application/json", "{\"success\":false,\"message\":\"Forbidden\"}");
+        return;
+    }
+
+    DynamicJsonDocument doc(128);
+    doc["success"] = true;
+    doc["push_token"] = _configManager.getPushToken();
+
+    String responseJson;
+    serializeJson(doc, responseJson);
+    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", responseJson);
+    response->addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+    request->send(response);
+}
+
+void CaptivePortal::handlePushData(AsyncWebServerRequest *request) {
+    int status = 200;
+    String message;
+    size_t accepted = 0;
+
+    // Take ownership of the body so it's freed on every path
+    std::unique_ptr<char, decltype(&free)> body((char*)request->_tempObject, &free);
+    request->_tempObject = NULL;
+
+    String expected = "Bearer " + _configManager.getPushToken();
+    if (!request->hasHeader("Authorization") || request->header("Authorization") != expected) {
+        status = 401;
+        message = "Missing or wrong push token";
+    } else if (request->contentLength() > MAX_PUSH_BODY_SIZE) {
+        status = 413;
+        message = "Body is larger than " + String(MAX_PUSH_BODY_SIZE) + " bytes";
+    } else if (!body) {
+        status = 400;
+        message = "No data provided";
+    } else {
+        // Parsed in place, so the document only holds the structure; for
+        // [date, value] points that is about twice the size of the text
+        DynamicJsonDocument doc(2 * MAX_PUSH_BODY_SIZE);
+        DeserializationError error = deserializeJson(doc, body.get());
+        if (error) {
+            status = 400;
+            message = String("Invalid JSON: ") + error.c_str();
+        } else {
+            std::vector<String> pushCards;
+            for (const CardConfig& config : _configManager.getCardConfigs()) {
+                if (config.type == CardType::PUSH) {
+                    pushCards.push_back(config.config);
+                }
+            }
+
+            // Check every update before publishing any, so a batch lands whole or not at all
+            std::vector<Event> events;
+            auto addUpdate = [&](JsonObjectConst item) -> bool {
+                String card = item["card"] | "";
+                if (std::find(pushCards.begin(), pushCards.end(), card) == pushCards.end()) {
+                    status = 404;
+                    message = "No pushed data card with ID '" + card + "'";
+                    return false;
+                }
+                std::shared_ptr<InsightParser> parser = InsightParser::fromPushedData(item);
+                if (!parser) {
+                    status = 400;
+                    message = "Card '" + card + "' needs a numeric value or a series of at least two [date, value] points";
+                    return false;
+                }
+                events.push_back(Event(EventType::INSIGHT_DATA_RECEIVED, card, parser));
+                return true;
+            };
+
+            // A single update or an array of them
+            if (doc.is<JsonArray>()) {
+                for (JsonObjectConst item : doc.as<JsonArrayConst>()) {
+                    if (!addUpdate(item)) {
+                        break;
+                    }
+                }
+            } else {
+                addUpdate(doc.as<JsonObjectConst>());
+            }
+            if (status == 200 && events.empty()) {
+                status = 400;
+                message = "No updates provided";
+            }
+
+            if (status == 200) {
+                for (const Event& event : events) {
+                    if (_eventQueue.publishEvent(event)) {
+                        accepted++;
+                    }
+                }
+                message = "Published " + String(accepted) + " of " + String(events.size()) + " updates";
+                if (accepted < events.size()) {
+                    status = 503;
+                }
+            }
+        }
+    }
+
+    if (status != 200) {
+        Serial.printf("Rejected push to /api/push (%d): %s\n", status, message.c_str());
+    }
+
+    DynamicJsonDocument responseDoc(256);
+    responseDoc["success"] = status == 200;
+    responseDoc["message"] = message;
+    responseDoc["accepted"] = accepted;
+
+    String responseJson;
+    serializeJson(responseDoc, responseJson);
+    AsyncWebServerResponse *response = request->beginResponse(status, "application/json", responseJson);
+    response->addHeader("Access-Control-Allow-Origin", "*");
+    request->send(response);
+}
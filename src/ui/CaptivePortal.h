@@ -22,6 +22,7 @@
 
 class OtaManager; // Forward declaration
 class CardController; // Forward declaration
+class PostHogClient; // Forward declaration
 
 // Enum to represent different asynchronous actions the portal can perform
 enum class PortalAction {
@@ -46,6 +47,8 @@ const char* portalActionToString(PortalAction action);
  * - WiFi network selection and configuration
  * - Device configuration (team ID and API key)
  * - PostHog insight management
+ * - Insight request timing metrics
+ * - Data pushed to PUSH cards from the local network
  * 
  * Implements standard captive portal detection for Android and Microsoft devices.
  * Caches WiFi scan results to improve responsiveness.
@@ -59,8 +62,9 @@ public:
      * @param eventQueue Reference to event system for state changes
      * @param otaManager Reference to OTA update manager
      * @param cardController Reference to card controller for card definitions
+     * @param posthogClient Reference to PostHog client for request metrics
      */
-    CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController);
+    CaptivePortal(ConfigManager& configManager, WiFiInterface& wifiInterface, EventQueue& eventQueue, OtaManager& otaManager, CardController& cardController, PostHogClient& posthogClient);
 
     /**
      * @brief Initialize the portal
@@ -85,6 +89,7 @@ private:
     unsigned long _lastScanTime;     ///< Timestamp of last WiFi scan
     OtaManager& _otaManager;         ///< OTA Update Manager reference
     CardController& _cardController; ///< Card controller reference
+    PostHogClient& _posthogClient;   ///< PostHog client reference
 
     // Action queue structure (internal)
     struct QueuedAction {
@@ -97,6 +102,9 @@ private:
     // Max size for the action queue
     static const size_t MAX_ACTION_QUEUE_SIZE = 5;
 
+    // Largest body accepted by /api/push, about a year of daily points
+    static const size_t MAX_PUSH_BODY_SIZE = 16384;
+
     // Member variables for asynchronous action handling
     std::vector<QueuedAction> _action_queue; // Action queue
     PortalAction _action_in_progress;
@@ -170,6 +178,20 @@ private:
      */
     void handleSaveConfiguredCards(AsyncWebServerRequest *request);
 
+    /**
+     * @brief Handle data pushed to PUSH cards
+     * Accepts a bearer-authenticated JSON object, or array of objects, each
+     * with a card ID and a value or series; publishes them as parsed insight data
+     */
+    void handlePushData(AsyncWebServerRequest *request);
+
+    /**
+     * @brief Return the full push token to the portal page
+     * Sent without CORS headers and refused for foreign origins, since
+     * /api/status only carries a masked copy
+     */
+    void handleRevealPushToken(AsyncWebServerRequest *request);
+
     /**
      * @brief Handle captive portal detection
      * Redirects to setup page for Android/Microsoft detection
@@ -211,6 +233,12 @@ private:
 
     void handleCorsPreflight(AsyncWebServerRequest *request); // Added declaration for CORS preflight handler
 
+    /**
+     * @brief Return insight request timing metrics
+     * Returns min/avg/p95 per request phase for each insight, plus connection counters
+     */
+    void handleApiMetrics(AsyncWebServerRequest *request);
+
     // New handlers for async action requests and status
     void handleApiStatus(AsyncWebServerRequest *request);
     void handleRequestWifiScan(AsyncWebServerRequest *request);
@@ -1,5 +1,6 @@
 #include "ui/CardController.h"
 #include <algorithm>
+#include <set>
 
 QueueHandle_t CardController::uiQueue = nullptr;
 
@@ -50,6 +51,11 @@ CardController::~CardController() {
     }
     insightCards.clear();
     
+    for (auto* card : hogqlCards) {
+        delete card;
+    }
+    hogqlCards.clear();
+    
     // Release mutex if we took it
     if (displayInterface && displayInterface->getMutexPtr()) {
         xSemaphoreGive(*(displayInterface->getMutexPtr()));
@@ -69,6 +75,11 @@ void CardController::initialize(DisplayInterface* display) {
     // Create card navigation stack
     cardStack = new CardNavigationStack(screen, screenWidth, screenHeight);
     
+    // Let the refresh scheduler favour whichever insight is on screen
+    cardStack->setCardChangedCallback([this](lv_obj_t* card) {
+        handleVisibleCardChanged(card);
+    });
+    
     // Create provision UI (always present, not configurable)
     provisioningCard = new ProvisioningCard(
         screen, 
@@ -203,7 +214,8 @@ void CardController::createInsightCard(const String& insightId) {
 
         displayInterface->giveMutex();
 
-        // Request immediate data for this insight now that it's set up
+        // Show the last known data straight away, then fetch the live result
+        posthogClient.publishCachedInsight(insightId);
         posthogClient.requestInsightData(insightId);
     });
 }
@@ -222,6 +234,9 @@ void CardController::handleInsightEvent(const Event& event) {
         for (auto it = insightCards.begin(); it != insightCards.end(); ++it) {
             InsightCard* card = *it;
             if (card->getInsightId() == event.insightId) {
+                // Stop refreshing data nobody will see
+                posthogClient.removeInsight(event.insightId);
+                
                 // Remove from card stack
                 cardStack->removeCard(card->getCard());
                 
@@ -299,7 +314,8 @@ void CardController::initializeCardTypes() {
             // Add to our list of cards
             insightCards.push_back(newCard);
             
-            // Request data for this insight immediately
+            // Show the last known data straight away, then fetch the live result
+            posthogClient.publishCachedInsight(configValue);
             posthogClient.requestInsightData(configValue);
             Serial.printf("Requested insight data for: %s\n", configValue.c_str());
             
@@ -311,6 +327,70 @@ void CardController::initializeCardTypes() {
     };
     registerCardType(insightDef);
     
+    // Register HOGQL card type
+    CardDefinition hogqlDef;
+    hogqlDef.type = CardType::HOGQL;
+    hogqlDef.name = "HogQL number";
+    hogqlDef.allowMultiple = true;
+    hogqlDef.needsConfigInput = true;
+    hogqlDef.configInputLabel = "HogQL query";
+    hogqlDef.uiDescription = "Show one number computed by PostHog, e.g. SELECT count() AS \"Signups\" FROM events WHERE event = 'signed_up'";
+    hogqlDef.factory = [this](const String& configValue) -> lv_obj_t* {
+        // Results are published under a key derived from the query text
+        String queryKey = PostHogClient::queryKey(configValue);
+        HogQLCard* newCard = new HogQLCard(
+            screen,
+            eventQueue,
+            queryKey,
+            screenWidth,
+            screenHeight
+        );
+        
+        if (newCard && newCard->getCard()) {
+            hogqlCards.push_back(newCard);
+            
+            posthogClient.requestQueryData(queryKey, configValue);
+            Serial.printf("Requested HogQL query data for: %s\n", queryKey.c_str());
+            
+            return newCard->getCard();
+        }
+        
+        delete newCard;
+        return nullptr;
+    };
+    registerCardType(hogqlDef);
+    
+    // Register PUSH card type
+    CardDefinition pushDef;
+    pushDef.type = CardType::PUSH;
+    pushDef.name = "Pushed data";
+    pushDef.allowMultiple = true;
+    pushDef.needsConfigInput = true;
+    pushDef.configInputLabel = "Card ID";
+    pushDef.uiDescription = "Show a number or graph your own systems send to POST /api/push on this device";
+    pushDef.factory = [this](const String& configValue) -> lv_obj_t* {
+        // Pushed data arrives as INSIGHT_DATA_RECEIVED under the card ID,
+        // so an insight card renders it without any polling
+        InsightCard* newCard = new InsightCard(
+            screen,
+            configManager,
+            eventQueue,
+            configValue,
+            screenWidth,
+            screenHeight
+        );
+        
+        if (newCard && newCard->getCard()) {
+            insightCards.push_back(newCard);
+            Serial.printf("Waiting for pushed data for: %s\n", configValue.c_str());
+            return newCard->getCard();
+        }
+        
+        delete newCard;
+        return nullptr;
+    };
+    registerCardType(pushDef);
+    
     // Register FRIEND card type  
     CardDefinition friendDef;
     friendDef.type = CardType::FRIEND;
@@ -343,6 +423,15 @@ void CardController::handleCardConfigChanged() {
     // Perform reconciliation
     reconcileCards(newConfigs);
     
+    // Forget cached data for insights that were removed
+    std::vector<String> insightIds;
+    for (const CardConfig& config : newConfigs) {
+        if (config.type == CardType::INSIGHT) {
+            insightIds.push_back(config.config);
+        }
+    }
+    posthogClient.retainCachedInsights(insightIds);
+    
     // Update current configuration
     currentCardConfigs = newConfigs;
 }
@@ -367,15 +456,44 @@ void CardController::reconcileCards(const std::vector<CardConfig>& newConfigs) {
         // Simple approach: Clear everything and rebuild from scratch
         // This avoids complex diffing logic that can cause sync issues
         
+        // Data that outlives this edit keeps its client state (metadata, held
+        // series, schedule, metrics), so a reorder costs a results-only refresh
+        std::set<String> keptKeys;
+        for (const CardConfig& config : newConfigs) {
+            if (config.type == CardType::INSIGHT) {
+                keptKeys.insert(config.config);
+            } else if (config.type == CardType::HOGQL) {
+                keptKeys.insert(PostHogClient::queryKey(config.config));
+            }
+        }
+        
         // First, remove all existing dynamic cards
-        // Remove insight cards
-        for (auto* card : insightCards) {
+        // Remove insight cards. Detach the list first so the visible-card
+        // callback never walks cards that are being deleted.
+        std::vector<InsightCard*> oldInsightCards;
+        oldInsightCards.swap(insightCards);
+        for (auto* card : oldInsightCards) {
+            if (card && keptKeys.count(card->getInsightId()) == 0) {
+                posthogClient.removeInsight(card->getInsightId());
+            }
+            if (card && card->getCard()) {
+                cardStack->removeCard(card->getCard());
+            }
+            delete card;
+        }
+        
+        // Remove HogQL cards
+        std::vector<HogQLCard*> oldHogQLCards;
+        oldHogQLCards.swap(hogqlCards);
+        for (auto* card : oldHogQLCards) {
+            if (card && keptKeys.count(card->getQueryKey()) == 0) {
+                posthogClient.removeInsight(card->getQueryKey());
+            }
             if (card && card->getCard()) {
                 cardStack->removeCard(card->getCard());
             }
             delete card;
         }
-        insightCards.clear();
         
         // Remove animation/friend card
         if (animationCard && animationCard->getCard()) {
@@ -409,6 +527,7 @@ void CardController::reconcileCards(const std::vector<CardConfig>& newConfigs) {
                 lv_obj_t* cardObj = it->factory(config.config);
                 if (cardObj) {
                     cardStack->addCard(cardObj);
+                    applyRefreshPolicy(config);
                     cardsCreated++;
                     Serial.printf("Created card %zu of type %s with config: %s\n", 
                                  cardsCreated, cardTypeToString(config.type).c_str(), 
@@ -507,6 +626,26 @@ void CardController::dispatchToLVGLTask(std::function<void()> update_func, bool
     }
 }
 
+void CardController::handleVisibleCardChanged(lv_obj_t* card) {
+    String visibleInsightId;
+    
+    for (auto* insightCard : insightCards) {
+        if (insightCard && insightCard->getCard() == card) {
+            visibleInsightId = insightCard->getInsightId();
+            break;
+        }
+    }
+    
+    for (auto* hogqlCard : hogqlCards) {
+        if (hogqlCard && hogqlCard->getCard() == card) {
+            visibleInsightId = hogqlCard->getQueryKey();
+            break;
+        }
+    }
+    
+    posthogClient.setVisibleInsight(visibleInsightId);
+}
+
 void CardController::handleCardTitleUpdated(const Event& event) {
     // Find and update the card configuration with the new title
     for (auto& cardConfig : currentCardConfigs) {
@@ -524,4 +663,12 @@ void CardController::handleCardTitleUpdated(const Event& event) {
             break;
         }
     }
-} 
\ No newline at end of file
+} 
+
+void CardController::applyRefreshPolicy(const CardConfig& config) {
+    if (config.type == CardType::INSIGHT) {
+        posthogClient.setRefreshPolicy(config.config, config.refresh);
+    } else if (config.type == CardType::HOGQL) {
+        posthogClient.setRefreshPolicy(PostHogClient::queryKey(config.config), config.refresh);
+    }
+}
@@ -10,6 +10,7 @@
 #include "ui/CardNavigationStack.h"
 #include "ui/ProvisioningCard.h"
 #include "ui/InsightCard.h"
+#include "ui/HogQLCard.h"
 #include "ui/FriendCard.h"
 #include "hardware/DisplayInterface.h"
 #include "EventQueue.h"
@@ -162,6 +163,7 @@ private:
     ProvisioningCard* provisioningCard; ///< Card for device provisioning
     FriendCard* animationCard;       ///< Card for animations
     std::vector<InsightCard*> insightCards; ///< Collection of insight cards
+    std::vector<HogQLCard*> hogqlCards;     ///< Collection of HogQL query cards
     
     // Display interface for thread safety
     DisplayInterface* displayInterface;  ///< Thread-safe display interface
@@ -190,6 +192,12 @@ private:
      */
     void handleWiFiEvent(const Event& event);
 
+    /**
+     * @brief Tell the PostHog client which insight or query is on screen
+     * @param card LVGL object of the newly visible card
+     */
+    void handleVisibleCardChanged(lv_obj_t* card);
+
     /**
      * @brief Handle card title update events
      * @param event Event containing insight ID and new title
@@ -198,7 +206,7 @@ private:
 
     /**
      * @brief Initialize default card type registrations
-     * Registers built-in card types (INSIGHT, FRIEND) with their factory functions
+     * Registers built-in card types (INSIGHT, HOGQL, FRIEND) with their factory functions
      */
     void initializeCardTypes();
 
@@ -208,4 +216,10 @@ private:
      * @param newConfigs New card configuration from storage
      */
     void reconcileCards(const std::vector<CardConfig>& newConfigs);
+
+    /**
+     * @brief Pass a data card's refresh policy on to the PostHog client
+     * @param config Configuration of a card that has just been created
+     */
+    void applyRefreshPolicy(const CardConfig& config);
 }; 
\ No newline at end of file
@@ -112,6 +112,7 @@ void CardNavigationStack::addCard(lv_obj_t* card) {
     if (lv_obj_get_child_cnt(_main_container) == 1) {
         _current_card = 0;
         _update_scroll_indicator(_current_card);
+        _notify_card_changed();
     }
 }
 
@@ -159,6 +160,7 @@ void CardNavigationStack::goToCard(uint8_t index) {
     vTaskDelay(pdMS_TO_TICKS(1));
     
     _update_scroll_indicator(_current_card);
+    _notify_card_changed();
 }
 
 uint8_t CardNavigationStack::getCurrentIndex() const {
@@ -247,6 +249,23 @@ void CardNavigationStack::forceUpdateIndicators() {
     lv_obj_invalidate(_scroll_indicator);
 }
 
+void CardNavigationStack::setCardChangedCallback(CardChangedCallback callback) {
+    _card_changed_callback = callback;
+}
+
+void CardNavigationStack::_notify_card_changed() {
+    if (!_card_changed_callback) {
+        return;
+    }
+    
+    // nullptr when the stack is empty
+    lv_obj_t* card = nullptr;
+    if (_current_card < lv_obj_get_child_cnt(_main_container)) {
+        card = lv_obj_get_child(_main_container, _current_card);
+    }
+    _card_changed_callback(card);
+}
+
 void CardNavigationStack::_scroll_event_cb(lv_event_t* e) {
     lv_obj_t* cont = static_cast<lv_obj_t*>(lv_event_get_target(e));
     lv_area_t cont_a;
@@ -396,5 +415,7 @@ bool CardNavigationStack::removeCard(lv_obj_t* card) {
         _current_card = 0;
     }
     
+    _notify_card_changed();
+    
     return true;
 }
\ No newline at end of file
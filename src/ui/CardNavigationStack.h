@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Bounce2.h>
 #include <vector>
+#include <functional>
 #include "ui/InputHandler.h"
 
 // Forward declaration
@@ -22,6 +23,12 @@ class DisplayInterface;
  */
 class CardNavigationStack {
 public:
+    /**
+     * @brief Callback invoked when the visible card changes
+     * @param card LVGL object of the newly visible card
+     */
+    using CardChangedCallback = std::function<void(lv_obj_t* card)>;
+
     /**
      * @brief Constructor
      * @param parent LVGL parent object
@@ -113,6 +120,15 @@ public:
      */
     void forceUpdateIndicators();
     
+    /**
+     * @brief Register a callback for visible card changes
+     * @param callback Function called with the newly visible card
+     * 
+     * Called on the LVGL task whenever navigation or card removal
+     * changes which card is shown.
+     */
+    void setCardChangedCallback(CardChangedCallback callback);
+    
 private:
     /**
      * @brief LVGL scroll event callback
@@ -136,6 +152,11 @@ private:
      */
     void _update_scroll_indicator(int active_index);
     
+    /**
+     * @brief Report the current card to the registered callback
+     */
+    void _notify_card_changed();
+    
     // UI elements
     lv_obj_t* _parent;              ///< Parent LVGL object
     lv_obj_t* _main_container;      ///< Container for cards
@@ -153,4 +174,7 @@ private:
     
     // Input handling
     std::vector<std::pair<lv_obj_t*, InputHandler*>> _input_handlers;  ///< Card-specific input handlers
+    
+    // Change notification
+    CardChangedCallback _card_changed_callback;  ///< Optional visible-card listener
 }; 
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "HogQLCard.h"
+#include "Style.h"
+#include "renderers/NumericCardRenderer.h"
+
+HogQLCard::HogQLCard(lv_obj_t* parent, EventQueue& eventQueue,
+                     const String& queryKey, uint16_t width, uint16_t height)
+    : _event_queue(eventQueue)
+    , _query_key(queryKey)
+    , _card(nullptr)
+    , _title_label(nullptr)
+    , _content_container(nullptr)
+    , _renderer(std::make_shared<NumericCardRenderer>()) {
+
+    _card = lv_obj_create(parent);
+    if (!_card) {
+        Serial.printf("[HogQLCard-%s] CRITICAL: Failed to create card base object!\n", _query_key.c_str());
+        return;
+    }
+    lv_obj_set_size(_card, width, height);
+    lv_obj_set_style_bg_color(_card, Style::backgroundColor(), 0);
+    lv_obj_set_style_pad_all(_card, 0, 0);
+    lv_obj_set_style_border_width(_card, 0, 0);
+    lv_obj_set_style_radius(_card, 0, 0);
+
+    lv_obj_t* flex_col = lv_obj_create(_card);
+    if (!flex_col) {
+        Serial.printf("[HogQLCard-%s] CRITICAL: Failed to create flex_col!\n", _query_key.c_str());
+        return;
+    }
+    lv_obj_set_size(flex_col, lv_pct(100), lv_pct(100));
+    lv_obj_set_style_pad_all(flex_col, 5, 0);
+    lv_obj_set_style_pad_row(flex_col, 5, 0);
+    lv_obj_set_flex_flow(flex_col, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_flex_align(flex_col, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_clear_flag(flex_col, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_opa(flex_col, LV_OPA_0, 0);
+    lv_obj_set_style_border_width(flex_col, 0, 0);
+
+    _title_label = lv_label_create(flex_col);
+    if (!_title_label) {
+        Serial.printf("[HogQLCard-%s] CRITICAL: Failed to create _title_label!\n", _query_key.c_str());
+        return;
+    }
+    lv_obj_set_width(_title_label, lv_pct(100));
+    lv_obj_set_style_text_color(_title_label, Style::labelColor(), 0);
+    lv_obj_set_style_text_font(_title_label, Style::labelFont(), 0);
+    lv_label_set_long_mode(_title_label, LV_LABEL_LONG_DOT);
+    lv_label_set_text(_title_label, "Loading...");
+
+    _content_container = lv_obj_create(flex_col);
+    if (!_content_container) {
+        Serial.printf("[HogQLCard-%s] CRITICAL: Failed to create _content_container!\n", _query_key.c_str());
+        return;
+    }
+    lv_obj_set_width(_content_container, lv_pct(100));
+    lv_obj_set_flex_grow(_content_container, 1);
+    lv_obj_set_style_bg_opa(_content_container, LV_OPA_0, 0);
+    lv_obj_set_style_border_width(_content_container, 0, 0);
+    lv_obj_set_style_pad_all(_content_container, 0, 0);
+
+    // Cards are created on the LVGL task, so the value label can be built right away
+    _renderer->createElements(_content_container);
+
+    _event_queue.subscribe([this](const Event& event) {
+        if (event.type == EventType::QUERY_DATA_RECEIVED && event.insightId == _query_key) {
+            this->onEvent(event);
+        }
+    });
+}
+
+HogQLCard::~HogQLCard() {
+    std::shared_ptr<NumericCardRenderer> renderer_for_lambda = std::move(_renderer);
+    if (globalUIDispatch) {
+        globalUIDispatch([card_obj = _card, renderer = renderer_for_lambda]() mutable {
+            if (renderer) {
+                renderer->clearElements();
+            }
+            if (card_obj && lv_obj_is_valid(card_obj)) {
+                lv_obj_del_async(card_obj);
+            }
+        }, true);
+    }
+}
+
+void HogQLCard::onEvent(const Event& event) {
+    String title = event.title.length() > 0 ? event.title : String("HogQL query");
+
+    if (globalUIDispatch) {
+        globalUIDispatch([this, title]() {
+            if (isValidObject(_title_label)) {
+                lv_label_set_text(_title_label, title.c_str());
+            }
+        }, true);
+    }
+
+    if (_renderer) {
+        _renderer->updateValue(event.value);
+    }
+}
+
+bool HogQLCard::isValidObject(lv_obj_t* obj) const {
+    return obj && lv_obj_is_valid(obj);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <lvgl.h>
+#include <memory>
+#include "EventQueue.h"
+#include "UICallback.h"
+
+class NumericCardRenderer;
+
+/**
+ * @class HogQLCard
+ * @brief UI component showing the single value returned by a HogQL query
+ *
+ * Same layout as a numeric InsightCard: a title label above a large value,
+ * drawn by NumericCardRenderer. The title is the query's column name, so
+ * `SELECT count() AS "Signups" FROM events` shows as "Signups".
+ */
+class HogQLCard {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param parent LVGL parent object to attach this card to
+     * @param eventQueue Event queue for receiving query results
+     * @param queryKey Key the query's results are published under (see PostHogClient::queryKey)
+     * @param width Card width in pixels
+     * @param height Card height in pixels
+     *
+     * Subscribes to QUERY_DATA_RECEIVED events for the specified queryKey.
+     */
+    HogQLCard(lv_obj_t* parent, EventQueue& eventQueue,
+              const String& queryKey, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Destructor - safely cleans up UI resources
+     *
+     * Deletes the LVGL objects asynchronously on the UI thread.
+     */
+    ~HogQLCard();
+
+    /**
+     * @brief Get the underlying LVGL card object
+     *
+     * @return LVGL object pointer for the main card container
+     */
+    lv_obj_t* getCard() const { return _card; }
+
+    /**
+     * @brief Get the key the query is tracked under
+     *
+     * @return Query key passed to the PostHog client
+     */
+    String getQueryKey() const { return _query_key; }
+
+private:
+    /**
+     * @brief Show a query result
+     *
+     * @param event QUERY_DATA_RECEIVED event carrying the value and column name
+     */
+    void onEvent(const Event& event);
+
+    /**
+     * @brief Check if an LVGL object is valid
+     *
+     * @param obj LVGL object to check
+     * @return true if object exists and is valid
+     */
+    bool isValidObject(lv_obj_t* obj) const;
+
+    EventQueue& _event_queue;           ///< Event queue reference
+    String _query_key;                  ///< Key of the query shown
+
+    // UI Elements
+    lv_obj_t* _card;                    ///< Main card container
+    lv_obj_t* _title_label;             ///< Title text label
+    lv_obj_t* _content_container;       ///< Container for the value
+
+    std::shared_ptr<NumericCardRenderer> _renderer; ///< Draws the value
+};
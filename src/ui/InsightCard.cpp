@@ -90,21 +90,20 @@ InsightCard::~InsightCard() {
 }
 
 void InsightCard::onEvent(const Event& event) {
-    std::shared_ptr<InsightParser> parser = nullptr;
+    std::shared_ptr<const InsightModel> model = nullptr;
     if (event.jsonData.length() > 0) {
-        parser = std::make_shared<InsightParser>(event.jsonData.c_str());
+        InsightParser parser(event.jsonData.c_str());
+        model = InsightModel::fromParser(parser);
     } else if (event.parser) {
-        parser = event.parser;
+        model = InsightModel::fromParser(*event.parser);
     } else {
         Serial.printf("[InsightCard-%s] Event received with no JSON data or pre-parsed object.\n", _insight_id.c_str());
-        handleParsedData(nullptr);
-        return;
     }
-    handleParsedData(parser);
+    handleParsedData(model, event.stale);
 }
 
-void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
-    if (!parser || !parser->isValid()) {
+void InsightCard::handleParsedData(std::shared_ptr<const InsightModel> model, bool stale) {
+    if (!model) {
         Serial.printf("[InsightCard-%s] Invalid data or parse error.\n", _insight_id.c_str());
         if (globalUIDispatch) {
             globalUIDispatch([this]() {
@@ -119,12 +118,8 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
         return;
     }
 
-    InsightParser::InsightType new_insight_type = parser->getInsightType();
-    char title_buffer[64];
-    if (!parser->getName(title_buffer, sizeof(title_buffer))) {
-        strcpy(title_buffer, "Insight");
-    }
-    String new_title(title_buffer);
+    InsightParser::InsightType new_insight_type = model->getType();
+    String new_title(model->getTitle());
 
     // Only dispatch title update event if the title has actually changed
     if (_current_title != new_title) {
@@ -134,9 +129,10 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
     }
 
     if (globalUIDispatch) {
-        globalUIDispatch([this, new_insight_type, new_title, parser, id = _insight_id]() mutable {
+        globalUIDispatch([this, new_insight_type, new_title, model, stale, id = _insight_id]() mutable {
         if (isValidObject(_title_label)) {
             lv_label_set_text(_title_label, new_title.c_str());
+            lv_obj_set_style_text_opa(_title_label, stale ? STALE_TITLE_OPA : LV_OPA_COVER, 0);
         }
 
         bool needs_rebuild = false;
@@ -190,14 +186,7 @@ void InsightCard::handleParsedData(std::shared_ptr<InsightParser> parser) {
         }
 
         if (_active_renderer) {
-            char prefix_buffer[16] = "";
-            char suffix_buffer[16] = "";
-
-            if (new_insight_type == InsightParser::InsightType::NUMERIC_CARD && parser) {
-                parser->getNumericFormattingPrefix(prefix_buffer, sizeof(prefix_buffer));
-                parser->getNumericFormattingSuffix(suffix_buffer, sizeof(suffix_buffer));
-            }
-            _active_renderer->updateDisplay(*parser, new_title, prefix_buffer, suffix_buffer);
+            _active_renderer->updateDisplay(*model);
         } else if (!needs_rebuild) {
             Serial.printf("[InsightCard-%s] No active renderer to update and no rebuild was triggered. Type: %d\n",
                 id.c_str(), (int)_current_type);
@@ -7,6 +7,7 @@
 #include "ConfigManager.h"
 #include "EventQueue.h"
 #include "posthog/parsers/InsightParser.h"
+#include "posthog/parsers/InsightModel.h"
 #include "UICallback.h"
 
 // Forward declaration for the renderer base class
@@ -80,6 +81,7 @@ private:
     static constexpr int FUNNEL_BAR_GAP = 20;      ///< Vertical gap between funnel bars
     static constexpr int FUNNEL_LEFT_MARGIN = 0;   ///< Left margin for funnel bars
     static constexpr int FUNNEL_LABEL_HEIGHT = 20; ///< Height of funnel step labels
+    static constexpr lv_opa_t STALE_TITLE_OPA = LV_OPA_50; ///< Title opacity while showing cached data
 
     
     /**
@@ -88,19 +90,23 @@ private:
      * @param event Event containing insight data or JSON
      * 
      * Processes INSIGHT_DATA_RECEIVED events, parsing JSON if needed
-     * and updating the visualization accordingly.
+     * and updating the visualization accordingly. The parsed data is
+     * reduced to an InsightModel straight away, so the parser and its
+     * JSON document are released before any UI work is queued.
      */
     void onEvent(const Event& event);
     
     /**
-     * @brief Process parsed insight data
+     * @brief Process extracted insight data
      * 
-     * @param parser Shared pointer to parsed insight data
+     * @param model Values extracted from the parsed insight, or null on a parse error
+     * @param stale true if the data is a cached copy awaiting refresh
      * 
      * Updates the card's visualization based on the insight type.
      * Handles type changes by recreating UI elements as needed.
+     * Stale data is shown with a dimmed title.
      */
-    void handleParsedData(std::shared_ptr<InsightParser> parser);
+    void handleParsedData(std::shared_ptr<const InsightModel> model, bool stale = false);
     
     /**
      * @brief Clear the content container
@@ -16,13 +16,7 @@ FunnelRenderer::~FunnelRenderer() {
 
 void FunnelRenderer::resetElementPointers() {
     _funnel_main_container = nullptr;
-    for (int i = 0; i < MAX_FUNNEL_STEPS; ++i) {
-        _funnel_step_bars[i] = nullptr;
-        _funnel_step_labels[i] = nullptr;
-        for (int j = 0; j < MAX_BREAKDOWNS; ++j) {
-            _funnel_bar_segments[i][j] = nullptr;
-        }
-    }
+    _rows.clear();
 }
 
 void FunnelRenderer::initBreakdownColors() {
@@ -57,57 +51,65 @@ void FunnelRenderer::createElements(lv_obj_t* parent_container) {
     lv_obj_set_style_border_width(_funnel_main_container, 0, 0);
     lv_obj_set_style_bg_opa(_funnel_main_container, LV_OPA_0, 0); // Transparent background
 
+    _rows.reserve(MAX_FUNNEL_STEPS);
+    for (int i = 0; i < MAX_FUNNEL_STEPS; ++i) {
+        createStepRow();
+    }
+    // Serial.println("[FunnelRenderer] Funnel elements created successfully.");
+}
+
+void FunnelRenderer::createStepRow() {
+    StepRow row = {};
     lv_coord_t available_width = lv_obj_get_content_width(_funnel_main_container);
 
-    for (int i = 0; i < MAX_FUNNEL_STEPS; ++i) {
-        // Create bar container (a simple object to hold segments)
-        _funnel_step_bars[i] = lv_obj_create(_funnel_main_container);
-        if (!_funnel_step_bars[i]) continue; // Error handling: skip if creation fails
-        
-        lv_obj_set_size(_funnel_step_bars[i], available_width, FUNNEL_BAR_HEIGHT);
-        lv_obj_set_style_bg_opa(_funnel_step_bars[i], LV_OPA_0, 0); // Transparent bar container
-        lv_obj_set_style_border_width(_funnel_step_bars[i], 0, 0);
-        lv_obj_set_style_pad_all(_funnel_step_bars[i], 0, 0);
-        lv_obj_clear_flag(_funnel_step_bars[i], LV_OBJ_FLAG_SCROLLABLE);
-        lv_obj_add_flag(_funnel_step_bars[i], LV_OBJ_FLAG_HIDDEN); // Initially hidden
-
-        // Create label for the step
-        _funnel_step_labels[i] = lv_label_create(_funnel_main_container);
-        if (!_funnel_step_labels[i]) continue;
-
-        lv_obj_set_style_text_color(_funnel_step_labels[i], Style::valueColor(), 0);
-        lv_obj_set_style_text_font(_funnel_step_labels[i], Style::valueFont(), 0);
-        lv_label_set_long_mode(_funnel_step_labels[i], LV_LABEL_LONG_DOT);
-        lv_obj_set_width(_funnel_step_labels[i], available_width);
-        lv_obj_set_height(_funnel_step_labels[i], FUNNEL_LABEL_HEIGHT);
-        lv_obj_add_flag(_funnel_step_labels[i], LV_OBJ_FLAG_HIDDEN); // Initially hidden
+    // Create bar container (a simple object to hold segments)
+    row.bar = lv_obj_create(_funnel_main_container);
+    if (row.bar) {
+        lv_obj_set_size(row.bar, available_width, FUNNEL_BAR_HEIGHT);
+        lv_obj_set_style_bg_opa(row.bar, LV_OPA_0, 0); // Transparent bar container
+        lv_obj_set_style_border_width(row.bar, 0, 0);
+        lv_obj_set_style_pad_all(row.bar, 0, 0);
+        lv_obj_clear_flag(row.bar, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_flag(row.bar, LV_OBJ_FLAG_HIDDEN); // Initially hidden
 
         // Create segments within the bar container
         for (int j = 0; j < MAX_BREAKDOWNS; ++j) {
-            _funnel_bar_segments[i][j] = lv_obj_create(_funnel_step_bars[i]);
-            if (!_funnel_bar_segments[i][j]) continue;
-
-            lv_obj_set_height(_funnel_bar_segments[i][j], FUNNEL_BAR_HEIGHT);
-            lv_obj_set_style_bg_color(_funnel_bar_segments[i][j], _breakdown_colors[j], 0);
-            lv_obj_set_style_border_width(_funnel_bar_segments[i][j], 0, 0);
-            lv_obj_set_style_radius(_funnel_bar_segments[i][j], 0, 0);
-            lv_obj_set_style_pad_all(_funnel_bar_segments[i][j], 0, 0);
-            lv_obj_add_flag(_funnel_bar_segments[i][j], LV_OBJ_FLAG_HIDDEN); // Initially hidden
+            row.segments[j] = lv_obj_create(row.bar);
+            if (!row.segments[j]) continue;
+
+            lv_obj_set_height(row.segments[j], FUNNEL_BAR_HEIGHT);
+            lv_obj_set_style_bg_color(row.segments[j], _breakdown_colors[j], 0);
+            lv_obj_set_style_border_width(row.segments[j], 0, 0);
+            lv_obj_set_style_radius(row.segments[j], 0, 0);
+            lv_obj_set_style_pad_all(row.segments[j], 0, 0);
+            lv_obj_add_flag(row.segments[j], LV_OBJ_FLAG_HIDDEN); // Initially hidden
         }
     }
-    // Serial.println("[FunnelRenderer] Funnel elements created successfully.");
+
+    // Create label for the step
+    row.label = lv_label_create(_funnel_main_container);
+    if (row.label) {
+        lv_obj_set_style_text_color(row.label, Style::valueColor(), 0);
+        lv_obj_set_style_text_font(row.label, Style::valueFont(), 0);
+        lv_label_set_long_mode(row.label, LV_LABEL_LONG_DOT);
+        lv_obj_set_width(row.label, available_width);
+        lv_obj_set_height(row.label, FUNNEL_LABEL_HEIGHT);
+        lv_obj_add_flag(row.label, LV_OBJ_FLAG_HIDDEN); // Initially hidden
+    }
+
+    _rows.push_back(row);
 }
 
-void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_str, const char* prefix, const char* suffix) {
-    // prefix and suffix are ignored for FunnelRenderer.
-    Serial.printf("[FunnelRenderer] updateDisplay for title: %s\n", title_str.c_str()); // Verify this is called
+void FunnelRenderer::updateDisplay(const InsightModel& model) {
+    // Prefix and suffix are ignored for FunnelRenderer.
+    Serial.printf("[FunnelRenderer] updateDisplay for title: %s\n", model.getTitle()); // Verify this is called
 
-    size_t raw_step_count = parser.getFunnelStepCount();
-    size_t raw_breakdown_count = parser.getFunnelBreakdownCount();
-    Serial.printf("[FunnelRenderer] Parser reports: step_count = %u, breakdown_count = %u\n",
+    size_t raw_step_count = model.getFunnelStepCount();
+    size_t raw_breakdown_count = model.getFunnelBreakdownCount();
+    Serial.printf("[FunnelRenderer] Model reports: step_count = %u, breakdown_count = %u\n",
                   (unsigned int)raw_step_count, (unsigned int)raw_breakdown_count);
 
-    size_t step_count = std::min(raw_step_count, static_cast<size_t>(MAX_FUNNEL_STEPS));
+    size_t step_count = raw_step_count;
     size_t breakdown_count = std::min(raw_breakdown_count, static_cast<size_t>(MAX_BREAKDOWNS));
     Serial.printf("[FunnelRenderer] Effective: step_count = %u, breakdown_count = %u\n",
                   (unsigned int)step_count, (unsigned int)breakdown_count);
@@ -117,22 +119,15 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
         // No steps, clear display or show message
         dispatchToUI([this]() {
             if (!areElementsValid()) return;
-            for (int i = 0; i < MAX_FUNNEL_STEPS; ++i) {
-                if (isValidLVGLObject(_funnel_step_bars[i])) lv_obj_add_flag(_funnel_step_bars[i], LV_OBJ_FLAG_HIDDEN);
-                if (isValidLVGLObject(_funnel_step_labels[i])) lv_obj_add_flag(_funnel_step_labels[i], LV_OBJ_FLAG_HIDDEN);
+            for (const StepRow& row : _rows) {
+                if (isValidLVGLObject(row.bar)) lv_obj_add_flag(row.bar, LV_OBJ_FLAG_HIDDEN);
+                if (isValidLVGLObject(row.label)) lv_obj_add_flag(row.label, LV_OBJ_FLAG_HIDDEN);
             }
         });
         return;
     }
 
-    uint32_t step_counts_total[MAX_FUNNEL_STEPS] = {0};
-    // Conversion rates not directly used for display here, but parser might need it.
-    if (!parser.getFunnelTotalCounts(0, step_counts_total, nullptr)) {
-        Serial.println("[FunnelRenderer-ERROR] Failed to get funnel total counts from parser.");
-        return;
-    }
-
-    uint32_t total_first_step = step_counts_total[0];
+    uint32_t total_first_step = model.getFunnelStepTotal(0);
     Serial.printf("[FunnelRenderer] total_first_step = %u\n", (unsigned int)total_first_step);
     if (total_first_step == 0 && step_count > 0) { // Allow processing if step_count is 0 (handled above)
         Serial.println("[FunnelRenderer-WARN] First funnel step count is zero. Funnel will appear empty or scaled strangely.");
@@ -156,19 +151,18 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
 
     for (size_t i = 0; i < step_count; ++i) {
         FunnelStepUIData& current_ui_step = ui_steps_data[i];
-        current_ui_step.relative_width_to_first_step = (total_first_step > 0) ? 
-            static_cast<float>(step_counts_total[i]) / total_first_step : 0.0f;
+        uint32_t step_total = model.getFunnelStepTotal(i);
+        current_ui_step.relative_width_to_first_step = model.getFunnelConversionRate(i);
 
-        char step_name_buffer[64] = {0};
-        parser.getFunnelStepData(0, i, step_name_buffer, sizeof(step_name_buffer), nullptr, nullptr, nullptr);
+        const char* step_name = model.getFunnelStepName(i);
         
         char number_buffer[20];
-        NumberFormat::addThousandsSeparators(number_buffer, sizeof(number_buffer), step_counts_total[i]);
+        NumberFormat::addThousandsSeparators(number_buffer, sizeof(number_buffer), step_total);
 
         // New label formatting logic
         uint32_t percentage_val = 0;
         if (total_first_step > 0) {
-            percentage_val = (step_counts_total[i] * 100) / total_first_step;
+            percentage_val = (step_total * 100) / total_first_step;
         }
 
         String new_label_format = "";
@@ -178,34 +172,23 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
             new_label_format = String(percentage_val) + "% - " + String(number_buffer);
         }
 
-        if (step_name_buffer[0] != '\0') {
+        if (step_name[0] != '\0') {
             new_label_format += " - ";
-            new_label_format += step_name_buffer;
+            new_label_format += step_name;
         }
         current_ui_step.label_text = new_label_format;
 
         // Calculate breakdown segments for this step
-        uint32_t breakdown_val_counts[MAX_BREAKDOWNS] = {0};
-        if (parser.getFunnelBreakdownComparison(i, breakdown_val_counts, nullptr) && step_counts_total[i] > 0) {
+        if (step_total > 0) {
             float total_width_for_this_step_bar = available_width_for_bars * current_ui_step.relative_width_to_first_step;
             float current_offset = 0.0f;
 
-            // Create a vector of {count, original_index} to sort breakdowns
-            std::vector<std::pair<uint32_t, int>> sorted_breakdowns_info;
-            for (size_t k = 0; k < breakdown_count; ++k) {
-                sorted_breakdowns_info.push_back({breakdown_val_counts[k], (int)k});
-            }
-
-            // Sort descending by count (largest first)
-            std::sort(sorted_breakdowns_info.begin(), sorted_breakdowns_info.end(), [](const auto& a, const auto& b) {
-                return a.first > b.first; 
-            });
-
+            // Largest breakdown first; the model ranked them when it was built
             for (size_t k = 0; k < breakdown_count; ++k) {
-                uint32_t current_segment_count = sorted_breakdowns_info[k].first;
-                int original_segment_index = sorted_breakdowns_info[k].second;
+                size_t original_segment_index = model.getFunnelBreakdownAtRank(i, k);
+                uint32_t current_segment_count = model.getFunnelCount(i, original_segment_index);
 
-                float segment_percentage_of_step = static_cast<float>(current_segment_count) / step_counts_total[i];
+                float segment_percentage_of_step = static_cast<float>(current_segment_count) / step_total;
                 float segment_width_pixels = total_width_for_this_step_bar * segment_percentage_of_step;
                 
                 current_ui_step.segments[k].width_pixels = segment_width_pixels;
@@ -223,53 +206,72 @@ void FunnelRenderer::updateDisplay(InsightParser& parser, const String& title_st
             return;
         }
 
+        while (_rows.size() < step_count) {
+            createStepRow();
+        }
+
+        // Longer funnels than the default rows get squeezed into the card, dropping labels if they no longer fit
+        int row_pitch = FUNNEL_BAR_HEIGHT + FUNNEL_BAR_GAP;
+        if (step_count > static_cast<size_t>(MAX_FUNNEL_STEPS)) {
+            int fitted_pitch = lv_obj_get_content_height(_funnel_main_container) / static_cast<int>(step_count);
+            if (fitted_pitch < row_pitch) {
+                row_pitch = fitted_pitch > FUNNEL_BAR_HEIGHT ? fitted_pitch : FUNNEL_BAR_HEIGHT + 1;
+            }
+        }
+        bool show_labels = row_pitch >= FUNNEL_BAR_HEIGHT + FUNNEL_LABEL_HEIGHT + 2;
+
         int y_offset = 0;
         for (size_t i = 0; i < step_count; ++i) {
             const auto& step_data = captured_steps_data[i];
+            StepRow& row = _rows[i];
 
-            if (isValidLVGLObject(_funnel_step_bars[i])) {
-                lv_obj_clear_flag(_funnel_step_bars[i], LV_OBJ_FLAG_HIDDEN);
-                lv_obj_align(_funnel_step_bars[i], LV_ALIGN_TOP_LEFT, 0, y_offset);
+            if (isValidLVGLObject(row.bar)) {
+                lv_obj_clear_flag(row.bar, LV_OBJ_FLAG_HIDDEN);
+                lv_obj_align(row.bar, LV_ALIGN_TOP_LEFT, 0, y_offset);
                 // Ensure the bar container is set to the full available width before placing segments
-                lv_obj_set_width(_funnel_step_bars[i], available_width_for_bars); 
+                lv_obj_set_width(row.bar, available_width_for_bars); 
 
                 for (size_t j = 0; j < breakdown_count; ++j) {
-                    if (isValidLVGLObject(_funnel_bar_segments[i][j])) {
+                    if (isValidLVGLObject(row.segments[j])) {
                         int seg_width = static_cast<int>(step_data.segments[j].width_pixels);
                         // Ensure visible segments have at least 1px width if they have any data
                         if (seg_width == 0 && step_data.segments[j].width_pixels > 0) seg_width = 1;
 
                         if (seg_width > 0) {
-                            lv_obj_set_size(_funnel_bar_segments[i][j], seg_width, FUNNEL_BAR_HEIGHT);
-                            lv_obj_align(_funnel_bar_segments[i][j], LV_ALIGN_LEFT_MID, static_cast<int>(step_data.segments[j].offset_pixels), 0);
-                            lv_obj_set_style_bg_color(_funnel_bar_segments[i][j], step_data.segments[j].color, 0); // Use stored color
-                            lv_obj_clear_flag(_funnel_bar_segments[i][j], LV_OBJ_FLAG_HIDDEN);
+                            lv_obj_set_size(row.segments[j], seg_width, FUNNEL_BAR_HEIGHT);
+                            lv_obj_align(row.segments[j], LV_ALIGN_LEFT_MID, static_cast<int>(step_data.segments[j].offset_pixels), 0);
+                            lv_obj_set_style_bg_color(row.segments[j], step_data.segments[j].color, 0); // Use stored color
+                            lv_obj_clear_flag(row.segments[j], LV_OBJ_FLAG_HIDDEN);
                         } else {
-                            lv_obj_add_flag(_funnel_bar_segments[i][j], LV_OBJ_FLAG_HIDDEN);
+                            lv_obj_add_flag(row.segments[j], LV_OBJ_FLAG_HIDDEN);
                         }
                     }
                 }
                 // Hide unused segments for this step
                 for (size_t j = breakdown_count; j < MAX_BREAKDOWNS; ++j) {
-                     if (isValidLVGLObject(_funnel_bar_segments[i][j])) {
-                        lv_obj_add_flag(_funnel_bar_segments[i][j], LV_OBJ_FLAG_HIDDEN);
+                     if (isValidLVGLObject(row.segments[j])) {
+                        lv_obj_add_flag(row.segments[j], LV_OBJ_FLAG_HIDDEN);
                     }
                 }
             }
 
-            if (isValidLVGLObject(_funnel_step_labels[i])) {
-                lv_obj_set_width(_funnel_step_labels[i], available_width_for_bars); // Ensure label width is updated
-                lv_label_set_text(_funnel_step_labels[i], step_data.label_text.c_str());
-                lv_obj_clear_flag(_funnel_step_labels[i], LV_OBJ_FLAG_HIDDEN);
-                lv_obj_align(_funnel_step_labels[i], LV_ALIGN_TOP_LEFT, 1, y_offset + FUNNEL_BAR_HEIGHT + 2); // +2 for small gap
+            if (isValidLVGLObject(row.label)) {
+                if (show_labels) {
+                    lv_obj_set_width(row.label, available_width_for_bars); // Ensure label width is updated
+                    lv_label_set_text(row.label, step_data.label_text.c_str());
+                    lv_obj_clear_flag(row.label, LV_OBJ_FLAG_HIDDEN);
+                    lv_obj_align(row.label, LV_ALIGN_TOP_LEFT, 1, y_offset + FUNNEL_BAR_HEIGHT + 2); // +2 for small gap
+                } else {
+                    lv_obj_add_flag(row.label, LV_OBJ_FLAG_HIDDEN);
+                }
             }
-            y_offset += FUNNEL_BAR_HEIGHT + FUNNEL_BAR_GAP;
+            y_offset += row_pitch;
         }
 
         // Hide unused steps (bars and labels)
-        for (size_t i = step_count; i < MAX_FUNNEL_STEPS; ++i) {
-            if (isValidLVGLObject(_funnel_step_bars[i])) lv_obj_add_flag(_funnel_step_bars[i], LV_OBJ_FLAG_HIDDEN);
-            if (isValidLVGLObject(_funnel_step_labels[i])) lv_obj_add_flag(_funnel_step_labels[i], LV_OBJ_FLAG_HIDDEN);
+        for (size_t i = step_count; i < _rows.size(); ++i) {
+            if (isValidLVGLObject(_rows[i].bar)) lv_obj_add_flag(_rows[i].bar, LV_OBJ_FLAG_HIDDEN);
+            if (isValidLVGLObject(_rows[i].label)) lv_obj_add_flag(_rows[i].label, LV_OBJ_FLAG_HIDDEN);
         }
         
         // Optional: force refresh
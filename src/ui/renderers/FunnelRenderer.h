@@ -12,13 +12,13 @@ public:
     ~FunnelRenderer() override;
 
     void createElements(lv_obj_t* parent_container) override;
-    void updateDisplay(InsightParser& parser, const String& title, const char* prefix = nullptr, const char* suffix = nullptr) override;
+    void updateDisplay(const InsightModel& model) override;
     void clearElements() override;
     bool areElementsValid() const override;
 
 private:
     // Constants for funnel layout (previously in InsightCard)
-    static constexpr int MAX_FUNNEL_STEPS = 5;     
+    static constexpr int MAX_FUNNEL_STEPS = 5;     // Rows created up front; longer funnels add rows and compress them
     static constexpr int MAX_BREAKDOWNS = 5;       
     static constexpr int FUNNEL_BAR_HEIGHT = 5;    
     static constexpr int FUNNEL_BAR_GAP = 24;      
@@ -27,14 +27,21 @@ private:
 
     lv_obj_t* _funnel_main_container; // A container created by this renderer within parent_container
     
-    // Arrays for LVGL objects
-    lv_obj_t* _funnel_step_bars[MAX_FUNNEL_STEPS];
-    lv_obj_t* _funnel_step_labels[MAX_FUNNEL_STEPS];
-    lv_obj_t* _funnel_bar_segments[MAX_FUNNEL_STEPS][MAX_BREAKDOWNS];
+    // LVGL objects for one funnel step
+    struct StepRow {
+        lv_obj_t* bar;                      // Holds the segments
+        lv_obj_t* label;
+        lv_obj_t* segments[MAX_BREAKDOWNS];
+    };
+
+    std::vector<StepRow> _rows;
     lv_color_t _breakdown_colors[MAX_BREAKDOWNS];
 
     void initBreakdownColors();
 
+    // Append a hidden row to _rows; must run on the LVGL thread
+    void createStepRow();
+
     // Helper to reset all element pointers to nullptr
     void resetElementPointers();
 };
@@ -2,7 +2,7 @@
 #define INSIGHT_RENDERER_BASE_H
 
 #include "lvgl.h"
-#include "../../posthog/parsers/InsightParser.h" // Adjusted path
+#include "../../posthog/parsers/InsightModel.h"
 #include <Arduino.h> // For String, if used in titles or other data
 #include <functional> // For std::function
 
@@ -45,16 +45,14 @@ public:
     virtual void createElements(lv_obj_t* parent_container) = 0;
 
     /**
-     * @brief Updates the display with new data from the parser.
+     * @brief Updates the display with new data for the insight.
      * This method will be called when new data for the insight is received.
      * The renderer is responsible for dispatching its internal LVGL calls to the UI thread.
      * 
-     * @param parser The InsightParser instance containing the new data.
-     * @param title The title of the insight.
-     * @param prefix The prefix to prepend to the title.
-     * @param suffix The suffix to append to the title.
+     * @param model Values extracted from the parsed insight, including the title
+     *              and any numeric prefix and suffix.
      */
-    virtual void updateDisplay(InsightParser& parser, const String& title, const char* prefix = nullptr, const char* suffix = nullptr) = 0;
+    virtual void updateDisplay(const InsightModel& model) = 0;
 
     /**
      * @brief Clears/deletes all UI elements created by this renderer.
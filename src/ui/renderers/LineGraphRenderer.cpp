@@ -57,10 +57,9 @@ void LineGraphRenderer::createElements(lv_obj_t* parent_container) {
     // InsightCard will do a global refresh after calling createElements if needed.
 }
 
-void LineGraphRenderer::updateDisplay(InsightParser& parser, const String& title, const char* prefix, const char* suffix) {
+void LineGraphRenderer::updateDisplay(const InsightModel& model) {
     // Title is handled by InsightCard. This renderer updates the chart data.
-    // prefix and suffix are ignored for LineGraphRenderer.
-    size_t point_count = parser.getSeriesPointCount();
+    size_t point_count = model.getSeriesPointCount();
     if (point_count == 0) {
         // No data points, maybe clear the chart or show a message?
         // For now, clear existing points if any.
@@ -73,38 +72,20 @@ void LineGraphRenderer::updateDisplay(InsightParser& parser, const String& title
         return;
     }
 
-    // Allocate memory for Y values from the parser
-    // Using unique_ptr for automatic memory management.
-    std::unique_ptr<double[]> y_values_from_parser(new double[point_count]);
-    if (!parser.getSeriesYValues(y_values_from_parser.get())) {
-        Serial.println("[LineGraphRenderer-ERROR] Failed to get Y series values from parser.");
-        return;
-    }
+    const float* y_values = model.getSeriesValues();
 
     // Find max value for scaling (logic from original InsightCard)
-    double max_val = 0.0;
-    if (point_count > 0) {
-        max_val = y_values_from_parser[0];
-        for (size_t i = 1; i < point_count; ++i) {
-            if (y_values_from_parser[i] > max_val) max_val = y_values_from_parser[i];
-        }
+    double max_val = y_values[0];
+    for (size_t i = 1; i < point_count; ++i) {
+        if (y_values[i] > max_val) max_val = y_values[i];
     }
     // Ensure max_val is not zero to avoid division by zero; if all values are <=0, chart range needs care.
     if (max_val <= 0) max_val = 1.0; // Default to 1 if all data is zero or negative to prevent scaling issues.
 
     double scale_factor = (max_val > 1000.0) ? (1000.0 / max_val) : 1.0;
 
-    // Copy data for the UI thread: Capture y_values_from_parser by moving its contents to a shared_ptr.
-    // This is because the lambda might outlive the current scope.
-    // The parser itself is passed by reference but assumed to be valid during the lambda's queuing/execution
-    // due to the shared_ptr in InsightCard::handleParsedData.
-    
-    // To pass the array safely to the lambda, we copy it into a structure that can be captured.
-    // A std::vector is easier to capture by value for lambdas.
-    std::vector<double> values_for_lambda(point_count);
-    for(size_t i = 0; i < point_count; ++i) {
-        values_for_lambda[i] = y_values_from_parser[i];
-    }
+    // The lambda may run after the model is released, so it gets its own copy of the values
+    std::vector<float> values_for_lambda(y_values, y_values + point_count);
 
     dispatchToUI([this, captured_values = std::move(values_for_lambda), point_count, max_val, scale_factor]() {
         if (!areElementsValid()) {
@@ -40,11 +40,12 @@ void NumericCardRenderer::createElements(lv_obj_t* parent_container) {
     lv_label_set_text(_value_label, "..."); // Initial placeholder text
 }
 
-void NumericCardRenderer::updateDisplay(InsightParser& parser, const String& title, const char* prefix, const char* suffix) {
+void NumericCardRenderer::updateDisplay(const InsightModel& model) {
     // Title is handled by InsightCard, we only update the value label here.
-    double value = parser.getNumericCardValue();
+    updateValue(model.getNumericValue(), model.getPrefix(), model.getSuffix());
+}
 
-    // Data processing (getting value) is done here.
+void NumericCardRenderer::updateValue(double value, const char* prefix, const char* suffix) {
     // LVGL operations are dispatched to the UI thread.
     dispatchToUI([this, value, p = String(prefix ? prefix : ""), s = String(suffix ? suffix : "")]() {
         // Serial.printf("[NumericRenderer] Updating display on UI thread. Label: %p, Core: %d\n", _value_label, xPortGetCoreID());
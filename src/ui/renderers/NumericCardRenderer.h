@@ -11,10 +11,13 @@ public:
     ~NumericCardRenderer() override;
 
     void createElements(lv_obj_t* parent_container) override;
-    void updateDisplay(InsightParser& parser, const String& title, const char* prefix = nullptr, const char* suffix = nullptr) override;
+    void updateDisplay(const InsightModel& model) override;
     void clearElements() override;
     bool areElementsValid() const override;
 
+    // Show a value that didn't come from an insight (e.g. a HogQL query result)
+    void updateValue(double value, const char* prefix = nullptr, const char* suffix = nullptr);
+
 private:
     lv_obj_t* _value_label; // LVGL label object for displaying the numeric value
     // Title is handled by InsightCard itself, this renderer only cares about the value display.
@@ -0,0 +1,16 @@
+#pragma once
+
+// The device's LVGL configuration, found ahead of it by the native_pipeline
+// build. Objects hold 64-bit pointers on the host, so six cards need more
+// than the device's 32KB pool, and a failed assert must end the run rather
+// than spin forever.
+
+#include "../../include/lv_conf.h"
+
+#undef LV_MEM_SIZE
+#define LV_MEM_SIZE (128 * 1024U)
+
+#undef LV_ASSERT_HANDLER_INCLUDE
+#define LV_ASSERT_HANDLER_INCLUDE <stdlib.h>
+#undef LV_ASSERT_HANDLER
+#define LV_ASSERT_HANDLER abort();
@@ -0,0 +1,361 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include <lvgl.h>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include "ConfigManager.h"
+#include "SystemController.h"
+#include "EventQueue.h"
+#include "Style.h"
+#include "posthog/PostHogClient.h"
+#include "ui/InsightCard.h"
+
+// Drives PostHogClient, its fetch workers, EventQueue and InsightCard against
+// mock_posthog.py, the way main.cpp wires them on the device. Each test starts
+// its own mock with the options it needs.
+
+extern char** environ;
+
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 135
+
+// The insights in test/recordings, with the titles their cards should show
+static const char* INSIGHT_IDS[] = {"aB3dE9xZ", "hR7kP2mQ", "wK4nT8vL", "mN5bV1cX", "qZ9xC3vB", "tY6uI0oP"};
+static const char* INSIGHT_TITLES[] = {"Daily signups", "Hourly pageviews", "Weekly active users",
+                                       "Monthly purchases", "Active users this week", "Checkouts today"};
+static const size_t INSIGHT_COUNT = sizeof(INSIGHT_IDS) / sizeof(INSIGHT_IDS[0]);
+
+// WifiInterface.cpp drives the radio and isn't built here; the test reports the connection itself
+static WiFiStateCallback wifiStateCallback;
+
+void WiFiInterface::onStateChange(WiFiStateCallback callback) {
+    wifiStateCallback = callback;
+}
+
+// CardController owns the UI queue on the device; here the test thread drains it
+static std::mutex uiLock;
+static std::deque<std::function<void()>> uiQueue;
+
+std::function<void(std::function<void()>, bool)> globalUIDispatch = [](std::function<void()> func, bool to_front) {
+    std::lock_guard<std::mutex> guard(uiLock);
+    if (to_front) {
+        uiQueue.push_front(std::move(func));
+    } else {
+        uiQueue.push_back(std::move(func));
+    }
+};
+
+// Run queued UI updates, then let LVGL lay out and draw
+static void pumpUI() {
+    while (true) {
+        std::function<void()> func;
+        {
+            std::lock_guard<std::mutex> guard(uiLock);
+            if (uiQueue.empty()) {
+                break;
+            }
+            func = std::move(uiQueue.front());
+            uiQueue.pop_front();
+        }
+        func();
+    }
+    lv_timer_handler();
+}
+
+static void flushDisplay(lv_display_t* display, const lv_area_t* area, uint8_t* pixels) {
+    (void)area;
+    (void)pixels;
+    lv_display_flush_ready(display);
+}
+
+static pid_t mockPid = -1;
+
+static void stopMock() {
+    if (mockPid > 0) {
+        kill(mockPid, SIGTERM);
+        waitpid(mockPid, nullptr, 0);
+        mockPid = -1;
+    }
+}
+
+static bool mockStats(DynamicJsonDocument& stats) {
+    WiFiClient client;
+    HTTPClient http;
+    if (!http.begin(client, "http://127.0.0.1:" + String(POSTHOG_API_PORT) + "/_mock/stats")) {
+        return false;
+    }
+    int code = http.GET();
+    bool ok = code == HTTP_CODE_OK && !deserializeJson(stats, http.getString());
+    http.end();
+    return ok;
+}
+
+// Start mock_posthog.py on the recordings with extra options, and wait until it answers
+static bool startMock(std::vector<std::string> options) {
+    std::vector<std::string> args = {
+        "python3", MOCK_POSTHOG_DIR "/mock_posthog.py",
+        "--plain-http", "--port", std::to_string(POSTHOG_API_PORT),
+        "--recordings", MOCK_POSTHOG_DIR "/test/recordings", "--quiet"};
+    args.insert(args.end(), options.begin(), options.end());
+
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    if (posix_spawnp(&mockPid, "python3", nullptr, nullptr, argv.data(), environ) != 0) {
+        mockPid = -1;
+        return false;
+    }
+
+    DynamicJsonDocument stats(1024);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        if (mockStats(stats)) {
+            return true;
+        }
+        delay(100);
+    }
+    stopMock();
+    return false;
+}
+
+static long mockCounter(const char* name) {
+    DynamicJsonDocument stats(1024);
+    TEST_ASSERT_TRUE_MESSAGE(mockStats(stats), "mock stats unavailable");
+    return stats[name] | 0L;
+}
+
+/**
+ * One boot of the fetch pipeline: a client and event queue, optionally
+ * with a card per insight, and a count of data published per insight.
+ */
+struct Pipeline {
+    EventQueue* events = nullptr;
+    PostHogClient* client = nullptr;
+    std::vector<InsightCard*> cards;
+    std::mutex lock;
+    std::map<std::string, int> published;
+
+    int publishedFor(const char* insight_id) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto count = published.find(insight_id);
+        return count == published.end() ? 0 : count->second;
+    }
+};
+
+static ConfigManager* config;
+static Pipeline* pipeline;
+
+static Pipeline* startPipeline(size_t insight_count, bool with_cards) {
+    pipeline = new Pipeline();
+    pipeline->events = new EventQueue(32);
+    pipeline->events->begin();
+    pipeline->client = new PostHogClient(*config, *pipeline->events);
+
+    if (with_cards) {
+        for (size_t i = 0; i < insight_count; i++) {
+            pipeline->cards.push_back(new InsightCard(lv_screen_active(), *config, *pipeline->events,
+                                                      INSIGHT_IDS[i], SCREEN_WIDTH, SCREEN_HEIGHT));
+        }
+        pumpUI();
+    }
+
+    // Subscribed after the cards, so a counted event has already reached its card
+    Pipeline* counted = pipeline;
+    pipeline->events->subscribe([counted](const Event& event) {
+        if (event.type == EventType::INSIGHT_DATA_RECEIVED) {
+            std::lock_guard<std::mutex> guard(counted->lock);
+            counted->published[event.insightId.c_str()]++;
+        }
+    });
+
+    for (size_t i = 0; i < insight_count; i++) {
+        pipeline->client->requestInsightData(INSIGHT_IDS[i]);
+    }
+    return pipeline;
+}
+
+// Process the client as main.cpp's insight task does until every insight was published `times` times
+static bool runUntilPublished(size_t insight_count, int times, unsigned long timeout) {
+    unsigned long start = millis();
+    while (true) {
+        bool done = true;
+        for (size_t i = 0; i < insight_count; i++) {
+            done = done && pipeline->publishedFor(INSIGHT_IDS[i]) >= times;
+        }
+        pumpUI();
+        if (done) {
+            return true;
+        }
+        if (millis() - start > timeout) {
+            return false;
+        }
+        pipeline->client->process();
+        delay(100);
+    }
+}
+
+static void printMetrics() {
+    DynamicJsonDocument metrics(16384);
+    pipeline->client->writeMetrics(metrics.to<JsonObject>());
+    serializeJson(metrics, Serial);
+    Serial.println();
+}
+
+void setUp() {}
+
+void tearDown() {
+    if (pipeline) {
+        // Stopped before the client, whose OTA subscription refers to it
+        pipeline->events->end();
+        // Waits for the workers to finish any request still in flight
+        delete pipeline->client;
+        // Updates still queued by a failed test refer to the cards, so run them first
+        pumpUI();
+        for (InsightCard* card : pipeline->cards) {
+            delete card;
+        }
+        pumpUI();
+        delete pipeline->events;
+        delete pipeline;
+        pipeline = nullptr;
+    }
+    stopMock();
+}
+
+void test_cold_boot_fills_cards() {
+    TEST_ASSERT_TRUE_MESSAGE(startMock({}), "mock_posthog.py didn't start");
+    unsigned long start = millis();
+    startPipeline(INSIGHT_COUNT, true);
+
+    TEST_ASSERT_TRUE_MESSAGE(runUntilPublished(INSIGHT_COUNT, 1, 20000), "not every insight was published");
+    unsigned long elapsed = millis() - start;
+
+    for (size_t i = 0; i < INSIGHT_COUNT; i++) {
+        lv_obj_t* column = lv_obj_get_child(pipeline->cards[i]->getCard(), 0);
+        TEST_ASSERT_EQUAL_STRING(INSIGHT_TITLES[i], lv_label_get_text(lv_obj_get_child(column, 0)));
+        TEST_ASSERT_GREATER_THAN_MESSAGE(0, lv_obj_get_child_count(lv_obj_get_child(column, 1)), INSIGHT_IDS[i]);
+    }
+
+    long requests = mockCounter("requests");
+    TEST_ASSERT_EQUAL(INSIGHT_COUNT, requests);
+    TEST_ASSERT_EQUAL(0, mockCounter("missing"));
+    ConnectionManager::Stats connections = pipeline->client->getConnectionStats();
+    TEST_ASSERT_LESS_OR_EQUAL(POSTHOG_MAX_CONCURRENT_FETCHES, connections.new_requests);
+
+    lv_mem_monitor_t memory;
+    lv_mem_monitor(&memory);
+    Serial.printf("Cold boot: %u insights in %lu ms (%.1f requests/s), LVGL memory %u%% used\n",
+                  (unsigned)INSIGHT_COUNT, elapsed, requests * 1000.0 / elapsed, (unsigned)memory.used_pct);
+    printMetrics();
+}
+
+void test_refresh_downloads_only_results() {
+    TEST_ASSERT_TRUE_MESSAGE(startMock({}), "mock_posthog.py didn't start");
+    startPipeline(INSIGHT_COUNT, true);
+    TEST_ASSERT_TRUE(runUntilPublished(INSIGHT_COUNT, 1, 20000));
+
+    // Metadata and series are held now, so these go to the query API
+    unsigned long start = millis();
+    for (size_t i = 0; i < INSIGHT_COUNT; i++) {
+        pipeline->client->requestInsightData(INSIGHT_IDS[i]);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(runUntilPublished(INSIGHT_COUNT, 2, 20000), "not every refresh was published");
+    unsigned long elapsed = millis() - start;
+
+    TEST_ASSERT_EQUAL(INSIGHT_COUNT, mockCounter("results_only"));
+    TEST_ASSERT_EQUAL(2 * INSIGHT_COUNT, mockCounter("requests"));
+    TEST_ASSERT_EQUAL(0, mockCounter("missing"));
+    for (size_t i = 0; i < INSIGHT_COUNT; i++) {
+        lv_obj_t* column = lv_obj_get_child(pipeline->cards[i]->getCard(), 0);
+        TEST_ASSERT_EQUAL_STRING(INSIGHT_TITLES[i], lv_label_get_text(lv_obj_get_child(column, 0)));
+    }
+    Serial.printf("Refresh: %u insights in %lu ms\n", (unsigned)INSIGHT_COUNT, elapsed);
+}
+
+void test_fetches_overlap() {
+    // Every request spends this long at the server, so one at a time N insights take N times it
+    const unsigned long latency = 500;
+    const unsigned long one_at_a_time = INSIGHT_COUNT * latency;
+    TEST_ASSERT_TRUE_MESSAGE(startMock({"--latency", std::to_string(latency)}), "mock_posthog.py didn't start");
+
+    unsigned long start = millis();
+    startPipeline(INSIGHT_COUNT, false);
+    TEST_ASSERT_TRUE(runUntilPublished(INSIGHT_COUNT, 1, 20000));
+    unsigned long cold = millis() - start;
+
+    start = millis();
+    for (size_t i = 0; i < INSIGHT_COUNT; i++) {
+        pipeline->client->requestInsightData(INSIGHT_IDS[i]);
+    }
+    TEST_ASSERT_TRUE(runUntilPublished(INSIGHT_COUNT, 2, 20000));
+    unsigned long refresh = millis() - start;
+
+    Serial.printf("%u insights at %lu ms latency: cold %lu ms, refresh %lu ms, %lu ms one at a time\n",
+                  (unsigned)INSIGHT_COUNT, latency, cold, refresh, one_at_a_time);
+    // POSTHOG_MAX_CONCURRENT_FETCHES requests in flight bring this to about N / workers times the latency
+    TEST_ASSERT_LESS_THAN(one_at_a_time * 3 / 4, cold);
+    TEST_ASSERT_LESS_THAN(one_at_a_time * 3 / 4, refresh);
+}
+
+void test_gzip_responses() {
+    TEST_ASSERT_TRUE_MESSAGE(startMock({"--gzip"}), "mock_posthog.py didn't start");
+    startPipeline(INSIGHT_COUNT, false);
+
+    TEST_ASSERT_TRUE(runUntilPublished(INSIGHT_COUNT, 1, 20000));
+    TEST_ASSERT_EQUAL(INSIGHT_COUNT, mockCounter("replayed"));
+}
+
+void test_server_errors_are_retried() {
+    TEST_ASSERT_TRUE_MESSAGE(startMock({"--fail-first", "1"}), "mock_posthog.py didn't start");
+    startPipeline(2, false);
+
+    TEST_ASSERT_TRUE(runUntilPublished(2, 1, 20000));
+    TEST_ASSERT_EQUAL(2, mockCounter("errors"));
+    TEST_ASSERT_EQUAL(4, mockCounter("requests"));
+}
+
+void test_cold_cache_runs_async_query() {
+    TEST_ASSERT_TRUE_MESSAGE(startMock({"--cold-polls", "1"}), "mock_posthog.py didn't start");
+    startPipeline(2, false);
+
+    TEST_ASSERT_TRUE(runUntilPublished(2, 1, 30000));
+    // Cached miss, async start, status poll and the cached result again, per insight
+    TEST_ASSERT_GREATER_OR_EQUAL(8, mockCounter("requests"));
+    TEST_ASSERT_EQUAL(0, mockCounter("errors"));
+}
+
+int main(int argc, char** argv) {
+    lv_init();
+    lv_tick_set_cb([]() -> uint32_t { return millis(); });
+    lv_display_t* display = lv_display_create(SCREEN_WIDTH, SCREEN_HEIGHT);
+    alignas(64) static uint8_t buffer[SCREEN_WIDTH * 20 * sizeof(lv_color16_t)];
+    lv_display_set_flush_cb(display, flushDisplay);
+    lv_display_set_buffers(display, buffer, nullptr, sizeof(buffer), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    Style::init();
+
+    SystemController::begin();
+    config = new ConfigManager();
+    config->begin();
+    config->setTeamId(1);
+    config->setApiKey("phx_mock_personal_api_key");
+    wifiStateCallback(WiFiState::CONNECTED);
+    SystemController::setSystemState(SystemState::SYS_READY);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_cold_boot_fills_cards);
+    RUN_TEST(test_refresh_downloads_only_results);
+    RUN_TEST(test_fetches_overlap);
+    RUN_TEST(test_gzip_responses);
+    RUN_TEST(test_server_errors_are_retried);
+    RUN_TEST(test_cold_cache_runs_async_query);
+    return UNITY_END();
+}
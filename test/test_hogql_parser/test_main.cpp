@@ -0,0 +1,261 @@
+#include <unity.h>
+#include <string>
+#include "posthog/parsers/HogQLParser.h"
+
+// Query API response for `SELECT count() FROM events`, with the fields the filter drops
+static const char* COUNT_RESPONSE =
+    "{\"cache_key\":\"cache_1f0c\",\"is_cached\":true,"
+    "\"last_refresh\":\"2025-06-01T11:45:00.000000Z\","
+    "\"next_allowed_client_refresh\":\"2025-06-01T12:00:00Z\","
+    "\"cache_target_age\":\"2025-06-01T12:15:00.482113+00:00\","
+    "\"columns\":[\"count()\"],\"types\":[[\"count()\",\"UInt64\"]],"
+    "\"hogql\":\"SELECT count() FROM events LIMIT 100\","
+    "\"results\":[[48213]],"
+    "\"timings\":[{\"k\":\"./printer\",\"t\":0.004}],"
+    "\"clickhouse\":\"SELECT count() FROM events WHERE equals(events.team_id, 1) LIMIT 100\"}";
+
+/**
+ * Stream over a response held in memory
+ */
+class StringStream : public Stream {
+public:
+    explicit StringStream(const char* text) : _text(text) {
+        setTimeout(0);
+    }
+
+    int available() override { return (int)(_text.size() - _pos); }
+    int read() override { return _pos < _text.size() ? (uint8_t)_text[_pos++] : -1; }
+    int peek() override { return _pos < _text.size() ? (uint8_t)_text[_pos] : -1; }
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    std::string _text;
+    size_t _pos = 0;
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_numeric_cell() {
+    HogQLParser parser(COUNT_RESPONSE);
+
+    TEST_ASSERT_TRUE(parser.isValid());
+    TEST_ASSERT_TRUE(parser.hasResultData());
+    TEST_ASSERT_EQUAL_DOUBLE(48213.0, parser.getValue());
+
+    char column[32];
+    TEST_ASSERT_TRUE(parser.getColumnName(column, sizeof(column)));
+    TEST_ASSERT_EQUAL_STRING("count()", column);
+}
+
+void test_stream_parses_like_a_string() {
+    HogQLParser fromString(COUNT_RESPONSE);
+    StringStream stream(COUNT_RESPONSE);
+    HogQLParser fromStream(stream);
+
+    TEST_ASSERT_TRUE(fromStream.isValid());
+    TEST_ASSERT_EQUAL_DOUBLE(fromString.getValue(), fromStream.getValue());
+    TEST_ASSERT_EQUAL_UINT32(fromString.getContentDigest(), fromStream.getContentDigest());
+}
+
+void test_string_cells_are_read_as_numbers() {
+    // UInt64 beyond 2^53 and Decimal columns come back as strings
+    HogQLParser big("{\"columns\":[\"sum(revenue)\"],\"results\":[[\"18446744073709551\"]]}");
+    TEST_ASSERT_TRUE(big.hasResultData());
+    TEST_ASSERT_EQUAL_DOUBLE(18446744073709551.0, big.getValue());
+
+    HogQLParser decimal("{\"columns\":[\"avg(price)\"],\"results\":[[\"12.50\"]]}");
+    TEST_ASSERT_EQUAL_DOUBLE(12.5, decimal.getValue());
+
+    HogQLParser text("{\"columns\":[\"any(name)\"],\"results\":[[\"not a number\"]]}");
+    TEST_ASSERT_TRUE(text.hasResultData());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, text.getValue());
+}
+
+void test_null_cell_is_zero() {
+    // e.g. sum() over no rows
+    HogQLParser parser("{\"columns\":[\"sum(amount)\"],\"results\":[[null]]}");
+
+    TEST_ASSERT_TRUE(parser.isValid());
+    TEST_ASSERT_TRUE(parser.hasResultData());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, parser.getValue());
+}
+
+void test_empty_results_have_no_data() {
+    const char* responses[] = {
+        "{\"columns\":[\"count()\"],\"results\":[]}",
+        "{\"columns\":[],\"results\":[[]]}",
+        "{\"results\":null}",
+        "{}",
+    };
+    for (const char* response : responses) {
+        HogQLParser parser(response);
+        TEST_ASSERT_TRUE_MESSAGE(parser.isValid(), response);
+        TEST_ASSERT_FALSE_MESSAGE(parser.hasResultData(), response);
+        TEST_ASSERT_EQUAL_DOUBLE(0.0, parser.getValue());
+    }
+}
+
+void test_missing_columns() {
+    HogQLParser parser("{\"results\":[[7]]}");
+    char column[32] = "unchanged";
+
+    TEST_ASSERT_TRUE(parser.hasResultData());
+    TEST_ASSERT_EQUAL_DOUBLE(7.0, parser.getValue());
+    TEST_ASSERT_FALSE(parser.getColumnName(column, sizeof(column)));
+    TEST_ASSERT_EQUAL_STRING("unchanged", column);
+    TEST_ASSERT_NOT_EQUAL(0, parser.getContentDigest());
+
+    HogQLParser unnamed("{\"columns\":[\"\"],\"results\":[[7]]}");
+    TEST_ASSERT_FALSE(unnamed.getColumnName(column, sizeof(column)));
+}
+
+void test_column_name_is_truncated_to_buffer() {
+    HogQLParser parser("{\"columns\":[\"Weekly active users\"],\"results\":[[1]]}");
+    char column[7];
+
+    TEST_ASSERT_TRUE(parser.getColumnName(column, sizeof(column)));
+    TEST_ASSERT_EQUAL_STRING("Weekly", column);
+}
+
+void test_digest_follows_value_and_column() {
+    HogQLParser base("{\"columns\":[\"count()\"],\"results\":[[10]]}");
+    HogQLParser same("{\"columns\":[\"count()\",\"other\"],\"results\":[[10,99]],\"is_cached\":false}");
+    HogQLParser value("{\"columns\":[\"count()\"],\"results\":[[11]]}");
+    HogQLParser column("{\"columns\":[\"Signups\"],\"results\":[[10]]}");
+
+    TEST_ASSERT_EQUAL_UINT32(base.getContentDigest(), same.getContentDigest());
+    TEST_ASSERT_NOT_EQUAL(base.getContentDigest(), value.getContentDigest());
+    TEST_ASSERT_NOT_EQUAL(base.getContentDigest(), column.getContentDigest());
+}
+
+void test_freshness_fields() {
+    HogQLParser parser(COUNT_RESPONSE);
+    time_t next_refresh = 0;
+    time_t target_age = 0;
+
+    TEST_ASSERT_TRUE(parser.getNextAllowedClientRefresh(&next_refresh));
+    TEST_ASSERT_EQUAL_INT64(1748779200, (int64_t)next_refresh);
+    TEST_ASSERT_TRUE(parser.getCacheTargetAge(&target_age));
+    TEST_ASSERT_EQUAL_INT64(1748780100, (int64_t)target_age);
+
+    HogQLParser missing("{\"results\":[[1]]}");
+    TEST_ASSERT_FALSE(missing.getNextAllowedClientRefresh(&next_refresh));
+    TEST_ASSERT_FALSE(missing.getCacheTargetAge(&target_age));
+}
+
+void test_query_status_running() {
+    // refresh=async on a cold cache: no results yet, poll by ID
+    HogQLParser parser(
+        "{\"query_status\":{\"id\":\"a8f1b2c3-7d4e-4f5a-9b6c-0d1e2f3a4b5c\",\"team_id\":1,"
+        "\"complete\":false,\"error\":false,\"query_async\":true,\"start_time\":\"2025-06-01T12:00:01Z\"}}");
+    char id[64];
+    bool complete = true;
+    bool error = true;
+
+    TEST_ASSERT_TRUE(parser.isValid());
+    TEST_ASSERT_FALSE(parser.hasResultData());
+    TEST_ASSERT_TRUE(parser.getQueryStatus(id, sizeof(id), &complete, &error));
+    TEST_ASSERT_EQUAL_STRING("a8f1b2c3-7d4e-4f5a-9b6c-0d1e2f3a4b5c", id);
+    TEST_ASSERT_FALSE(complete);
+    TEST_ASSERT_FALSE(error);
+}
+
+void test_query_status_complete_with_results() {
+    HogQLParser parser(
+        "{\"columns\":[\"count()\"],\"results\":[[5]],"
+        "\"query_status\":{\"id\":\"q1\",\"complete\":true,\"error\":false}}");
+    char id[8];
+    bool complete = false;
+
+    TEST_ASSERT_TRUE(parser.hasResultData());
+    TEST_ASSERT_TRUE(parser.getQueryStatus(id, sizeof(id), &complete, nullptr));
+    TEST_ASSERT_TRUE(complete);
+}
+
+void test_query_status_error() {
+    HogQLParser parser(
+        "{\"query_status\":{\"id\":\"q2\",\"complete\":true,\"error\":true,"
+        "\"error_message\":\"Unknown table: evnts\"}}");
+    char id[8];
+    bool complete = false;
+    bool error = false;
+
+    TEST_ASSERT_TRUE(parser.getQueryStatus(id, sizeof(id), &complete, &error));
+    TEST_ASSERT_TRUE(complete);
+    TEST_ASSERT_TRUE(error);
+}
+
+void test_query_status_absent_or_unusable() {
+    char id[4];
+
+    HogQLParser none(COUNT_RESPONSE);
+    TEST_ASSERT_FALSE(none.getQueryStatus(id, sizeof(id), nullptr, nullptr));
+
+    HogQLParser no_id("{\"query_status\":{\"complete\":false}}");
+    TEST_ASSERT_FALSE(no_id.getQueryStatus(id, sizeof(id), nullptr, nullptr));
+
+    // An ID that doesn't fit is refused rather than truncated into a different query
+    HogQLParser long_id("{\"query_status\":{\"id\":\"abcd\",\"complete\":false}}");
+    TEST_ASSERT_FALSE(long_id.getQueryStatus(id, sizeof(id), nullptr, nullptr));
+}
+
+void test_invalid_responses() {
+    const char* responses[] = {
+        "",
+        "[[1]]",
+        "{\"results\":[[1]]",
+        "<html>502 Bad Gateway</html>",
+    };
+    for (const char* response : responses) {
+        HogQLParser parser(response);
+        char id[8];
+        TEST_ASSERT_FALSE_MESSAGE(parser.isValid(), response);
+        TEST_ASSERT_FALSE(parser.hasResultData());
+        TEST_ASSERT_EQUAL_UINT32(0, parser.getContentDigest());
+        TEST_ASSERT_FALSE(parser.getQueryStatus(id, sizeof(id), nullptr, nullptr));
+    }
+}
+
+void test_oversized_cell_is_invalid() {
+    // A query returning text instead of an aggregate
+    std::string response = "{\"results\":[[\"";
+    response.append(HogQLParser::DOCUMENT_CAPACITY * 2, 'x');
+    response += "\"]]}";
+    HogQLParser parser(response.c_str());
+
+    TEST_ASSERT_FALSE(parser.isValid());
+}
+
+void test_query_request_body() {
+    String body;
+    TEST_ASSERT_TRUE(HogQLParser::getQueryRequestBody("SELECT count() FROM events WHERE event = \"$pageview\"",
+                                                      "force_cache", body));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"query\":{\"kind\":\"HogQLQuery\",\"query\":\"SELECT count() FROM events WHERE event = \\\"$pageview\\\"\"},"
+        "\"refresh\":\"force_cache\"}",
+        body.c_str());
+
+    TEST_ASSERT_FALSE(HogQLParser::getQueryRequestBody("", "async", body));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_numeric_cell);
+    RUN_TEST(test_stream_parses_like_a_string);
+    RUN_TEST(test_string_cells_are_read_as_numbers);
+    RUN_TEST(test_null_cell_is_zero);
+    RUN_TEST(test_empty_results_have_no_data);
+    RUN_TEST(test_missing_columns);
+    RUN_TEST(test_column_name_is_truncated_to_buffer);
+    RUN_TEST(test_digest_follows_value_and_column);
+    RUN_TEST(test_freshness_fields);
+    RUN_TEST(test_query_status_running);
+    RUN_TEST(test_query_status_complete_with_results);
+    RUN_TEST(test_query_status_error);
+    RUN_TEST(test_query_status_absent_or_unusable);
+    RUN_TEST(test_invalid_responses);
+    RUN_TEST(test_oversized_cell_is_invalid);
+    RUN_TEST(test_query_request_body);
+    return UNITY_END();
+}
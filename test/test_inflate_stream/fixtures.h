@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+
+// An insights API response for a 30-day trend, and the same bytes as sent
+// with Content-Encoding: gzip (with a file name in the header, as the gzip
+// tool writes it) and Content-Encoding: deflate (zlib, RFC 1950).
+
+static const char INSIGHT_JSON[] =
+    "{\"results\":[{\"id\":4211,\"short_id\":\"aB3dE9xZ\",\"name\":\"Daily signups\",\"derived_name\":null,\"query\":{\"ki"
+    "nd\":\"InsightVizNode\",\"source\":{\"kind\":\"TrendsQuery\",\"series\":[{\"kind\":\"EventsNode\",\"event\":\"signed_u"
+    "p\",\"name\":\"signed_up\",\"math\":\"total\"}],\"interval\":\"day\",\"dateRange\":{\"date_from\":\"-30d\"},\"trendsFilt"
+    "er\":{\"display\":\"ActionsLineGraph\"}},\"display\":\"ActionsLineGraph\"},\"result\":[[\"2025-05-01\",20],[\"2025"
+    "-05-02\",57],[\"2025-05-03\",94],[\"2025-05-04\",131],[\"2025-05-05\",55],[\"2025-05-06\",92],[\"2025-05-07\",1"
+    "29],[\"2025-05-08\",53],[\"2025-05-09\",90],[\"2025-05-10\",127],[\"2025-05-11\",51],[\"2025-05-12\",88],[\"202"
+    "5-05-13\",125],[\"2025-05-14\",49],[\"2025-05-15\",86],[\"2025-05-16\",123],[\"2025-05-17\",47],[\"2025-05-18\""
+    ",84],[\"2025-05-19\",121],[\"2025-05-20\",45],[\"2025-05-21\",82],[\"2025-05-22\",119],[\"2025-05-23\",43],[\"2"
+    "025-05-24\",80],[\"2025-05-25\",117],[\"2025-05-26\",41],[\"2025-05-27\",78],[\"2025-05-28\",115],[\"2025-05-2"
+    "9\",39],[\"2025-05-30\",76]],\"last_refresh\":\"2025-05-30T09:12:44.118Z\",\"next_allowed_client_refresh\":\"2"
+    "025-05-30T09:27:44.118Z\",\"cache_target_age\":\"2025-05-30T09:27:44.118Z\",\"created_by\":{\"id\":1,\"uuid\":\""
+    "01890f6c-2b7e-0000-5b8e-5e2a5f0e4c21\",\"distinct_id\":\"x3kq\",\"first_name\":\"Max\",\"email\":\"max@example.c"
+    "om\"},\"description\":\"Users who completed the signup flow, per day\",\"tags\":[],\"timezone\":\"UTC\",\"is_cac"
+    "hed\":true}],\"next\":null,\"previous\":null}";
+
+static const uint8_t INSIGHT_GZIP[] = {
+    0x1f, 0x8b, 0x08, 0x08, 0x8c, 0x76, 0x39, 0x68, 0x02, 0xff, 0x69, 0x6e, 0x73, 0x69, 0x67, 0x68,
+    0x74, 0x2e, 0x6a, 0x73, 0x6f, 0x6e, 0x00, 0x7d, 0x94, 0xcb, 0x6e, 0xdb, 0x30, 0x10, 0x45, 0x7f,
+    0xc5, 0xe0, 0x5a, 0x0e, 0x44, 0x4a, 0xb2, 0x25, 0xaf, 0xfa, 0x4a, 0x8b, 0x02, 0x6d, 0x81, 0x16,
+    0x49, 0x17, 0x0d, 0x02, 0x81, 0x91, 0xc6, 0x36, 0x11, 0xbd, 0x42, 0x52, 0x8e, 0x93, 0xc0, 0xff,
+    0xde, 0x4b, 0xd9, 0x45, 0x3c, 0x8b, 0xc6, 0xf0, 0x86, 0x77, 0xe6, 0x72, 0x8e, 0x06, 0x9c, 0x79,
+    0x11, 0x96, 0xdc, 0xd8, 0x78, 0x27, 0x56, 0x37, 0x2f, 0xc2, 0xd4, 0x62, 0x95, 0x2a, 0x29, 0x23,
+    0xe1, 0xb6, 0xbd, 0xf5, 0x65, 0x38, 0x0b, 0xfd, 0x21, 0xa9, 0x2f, 0x8b, 0xfd, 0x1f, 0x11, 0x89,
+    0x4e, 0xb7, 0x04, 0xe5, 0x93, 0x36, 0xcd, 0xd3, 0xcc, 0x99, 0x4d, 0x37, 0x0e, 0x0e, 0x72, 0x4d,
+    0xd6, 0xec, 0xa8, 0x2e, 0x8f, 0xe1, 0x6e, 0x6c, 0x9a, 0x48, 0x3c, 0x8c, 0x64, 0x9f, 0xc4, 0xea,
+    0x45, 0xdc, 0x9b, 0x2e, 0xdc, 0xf2, 0xb5, 0x43, 0xfe, 0xd6, 0xff, 0x36, 0xcf, 0x3f, 0xfa, 0x9a,
+    0x60, 0x72, 0xfd, 0x68, 0x2b, 0x3a, 0xcb, 0xb8, 0xb2, 0xd4, 0xd5, 0xee, 0xe7, 0xe4, 0x43, 0x18,
+    0x77, 0xd2, 0x91, 0xea, 0x14, 0xbf, 0xdc, 0x51, 0xe7, 0xdd, 0xc9, 0x4d, 0xe1, 0x00, 0x31, 0x40,
+    0xa0, 0xf2, 0x38, 0xbc, 0xd2, 0x9d, 0x4b, 0xad, 0xf6, 0x5b, 0x48, 0xbe, 0xf7, 0xba, 0x11, 0x87,
+    0xdb, 0x48, 0x98, 0xce, 0x93, 0xdd, 0xe1, 0xb0, 0x12, 0xb5, 0x0e, 0x75, 0x6a, 0xed, 0xe9, 0x97,
+    0xee, 0x36, 0x13, 0x49, 0x38, 0x94, 0x6b, 0xdb, 0xb7, 0x08, 0xcf, 0x93, 0xb8, 0x16, 0x87, 0x48,
+    0xf8, 0x09, 0xeb, 0xb3, 0x69, 0x60, 0x9c, 0x72, 0x8c, 0x1b, 0x1a, 0x58, 0x57, 0xe2, 0x7d, 0xe5,
+    0x4d, 0xdf, 0xb9, 0x6f, 0xa6, 0xa3, 0x2f, 0x56, 0x0f, 0x5b, 0x71, 0x40, 0xfa, 0x5b, 0xe1, 0xe8,
+    0xd4, 0x6c, 0x7c, 0xd5, 0x8d, 0x50, 0xb1, 0xca, 0xe6, 0x31, 0xfe, 0x52, 0x44, 0x2a, 0xbe, 0x8d,
+    0xce, 0x14, 0x25, 0xa2, 0x6c, 0xc9, 0x94, 0x44, 0x44, 0x45, 0xca, 0x94, 0x54, 0x44, 0x32, 0x91,
+    0x4c, 0xca, 0x60, 0xcb, 0x98, 0xb2, 0x80, 0x4d, 0x31, 0x65, 0x09, 0x9b, 0x2a, 0x98, 0x94, 0xc3,
+    0x96, 0x30, 0xa5, 0x80, 0x8d, 0x11, 0xc9, 0x38, 0xd8, 0x18, 0x92, 0x04, 0x76, 0xc6, 0xea, 0x4b,
+    0x60, 0xe7, 0x39, 0x53, 0x92, 0x60, 0x63, 0x48, 0x12, 0xdc, 0x29, 0xab, 0x2f, 0x81, 0x9d, 0x2f,
+    0x98, 0xb2, 0x08, 0x36, 0x86, 0x24, 0xc1, 0x9d, 0xf2, 0xfa, 0xc0, 0xce, 0x59, 0x4b, 0x64, 0x11,
+    0x6c, 0x0c, 0x49, 0x81, 0x3b, 0x65, 0xf5, 0x15, 0xb0, 0x73, 0xd6, 0x12, 0x05, 0x6c, 0x29, 0x19,
+    0x92, 0x02, 0x77, 0xca, 0xea, 0x2b, 0x60, 0xe7, 0xac, 0x25, 0x2a, 0x0b, 0x36, 0x86, 0xa4, 0xc0,
+    0x9d, 0xf2, 0xfa, 0xc0, 0x5e, 0xb2, 0x96, 0xa8, 0x3c, 0xd8, 0x38, 0x12, 0xb8, 0x13, 0x56, 0x3f,
+    0x01, 0xf6, 0x72, 0x71, 0x8b, 0xe7, 0xda, 0x68, 0xe7, 0x4b, 0x4b, 0x6b, 0xbc, 0x9b, 0xf0, 0x8e,
+    0x5f, 0x13, 0xae, 0xe2, 0x62, 0x25, 0xd5, 0x2a, 0x4d, 0x2f, 0xa4, 0xcc, 0xa7, 0xd1, 0xa4, 0xbd,
+    0x2f, 0x75, 0xd3, 0xf4, 0x8f, 0x78, 0xfb, 0x55, 0x63, 0x30, 0x1e, 0xff, 0x35, 0xaa, 0xe5, 0x99,
+    0xb1, 0xd2, 0xd5, 0x96, 0x4a, 0xaf, 0xed, 0x86, 0x70, 0x41, 0x98, 0x83, 0x37, 0xb3, 0x2d, 0x61,
+    0x46, 0xea, 0xf2, 0x6e, 0x9a, 0xed, 0xb0, 0x1f, 0xb0, 0x2c, 0xc6, 0x71, 0x5a, 0x14, 0xb1, 0xcc,
+    0x8b, 0x78, 0xbd, 0xa8, 0xe6, 0xea, 0x6e, 0x49, 0xf3, 0x18, 0xbf, 0x79, 0x76, 0x97, 0xd3, 0x3c,
+    0x23, 0xa5, 0xb3, 0x75, 0x4c, 0x69, 0x15, 0xba, 0x1f, 0x26, 0xc4, 0x9b, 0xae, 0x3a, 0x6d, 0x97,
+    0x7d, 0x72, 0xff, 0x00, 0x71, 0x6d, 0x2c, 0xbe, 0xf4, 0x34, 0xc1, 0xdf, 0xf5, 0x3e, 0x8c, 0x78,
+    0x8b, 0x35, 0x83, 0x53, 0xab, 0xf7, 0xef, 0x68, 0xaf, 0xdb, 0xa1, 0xa1, 0x8b, 0x0a, 0xa3, 0x19,
+    0x86, 0x8c, 0x5c, 0x65, 0xcd, 0x10, 0xe6, 0x0b, 0x09, 0xd7, 0xd8, 0x15, 0x6e, 0xf6, 0xb8, 0xed,
+    0x67, 0x08, 0x23, 0x0b, 0x7c, 0x33, 0xbf, 0xa5, 0xd3, 0x82, 0x9a, 0xad, 0xd1, 0x93, 0x68, 0x36,
+    0x90, 0x9d, 0x1d, 0x27, 0xde, 0xeb, 0x4d, 0xd8, 0x2b, 0xe8, 0xae, 0x37, 0x2d, 0x3d, 0xf7, 0x5d,
+    0x28, 0x79, 0x7d, 0xf5, 0x11, 0x21, 0xe3, 0xca, 0xa9, 0x1d, 0x00, 0xf3, 0x76, 0xa4, 0xb0, 0x30,
+    0x42, 0x5f, 0xff, 0xed, 0xb4, 0xc1, 0xd2, 0xce, 0xf4, 0xa3, 0x3b, 0x9e, 0x0f, 0x7f, 0x01, 0x1c,
+    0xa3, 0xc6, 0x54, 0x3c, 0x05, 0x00, 0x00,
+};
+
+static const uint8_t INSIGHT_DEFLATE[] = {
+    0x78, 0xda, 0x7d, 0x94, 0xcb, 0x6e, 0xdb, 0x30, 0x10, 0x45, 0x7f, 0xc5, 0xe0, 0x5a, 0x0e, 0x44,
+    0x4a, 0xb2, 0x25, 0xaf, 0xfa, 0x4a, 0x8b, 0x02, 0x6d, 0x81, 0x16, 0x49, 0x17, 0x0d, 0x02, 0x81,
+    0x91, 0xc6, 0x36, 0x11, 0xbd, 0x42, 0x52, 0x8e, 0x93, 0xc0, 0xff, 0xde, 0x4b, 0xd9, 0x45, 0x3c,
+    0x8b, 0xc6, 0xf0, 0x86, 0x77, 0xe6, 0x72, 0x8e, 0x06, 0x9c, 0x79, 0x11, 0x96, 0xdc, 0xd8, 0x78,
+    0x27, 0x56, 0x37, 0x2f, 0xc2, 0xd4, 0x62, 0x95, 0x2a, 0x29, 0x23, 0xe1, 0xb6, 0xbd, 0xf5, 0x65,
+    0x38, 0x0b, 0xfd, 0x21, 0xa9, 0x2f, 0x8b, 0xfd, 0x1f, 0x11, 0x89, 0x4e, 0xb7, 0x04, 0xe5, 0x93,
+    0x36, 0xcd, 0xd3, 0xcc, 0x99, 0x4d, 0x37, 0x0e, 0x0e, 0x72, 0x4d, 0xd6, 0xec, 0xa8, 0x2e, 0x8f,
+    0xe1, 0x6e, 0x6c, 0x9a, 0x48, 0x3c, 0x8c, 0x64, 0x9f, 0xc4, 0xea, 0x45, 0xdc, 0x9b, 0x2e, 0xdc,
+    0xf2, 0xb5, 0x43, 0xfe, 0xd6, 0xff, 0x36, 0xcf, 0x3f, 0xfa, 0x9a, 0x60, 0x72, 0xfd, 0x68, 0x2b,
+    0x3a, 0xcb, 0xb8, 0xb2, 0xd4, 0xd5, 0xee, 0xe7, 0xe4, 0x43, 0x18, 0x77, 0xd2, 0x91, 0xea, 0x14,
+    0xbf, 0xdc, 0x51, 0xe7, 0xdd, 0xc9, 0x4d, 0xe1, 0x00, 0x31, 0x40, 0xa0, 0xf2, 0x38, 0xbc, 0xd2,
+    0x9d, 0x4b, 0xad, 0xf6, 0x5b, 0x48, 0xbe, 0xf7, 0xba, 0x11, 0x87, 0xdb, 0x48, 0x98, 0xce, 0x93,
+    0xdd, 0xe1, 0xb0, 0x12, 0xb5, 0x0e, 0x75, 0x6a, 0xed, 0xe9, 0x97, 0xee, 0x36, 0x13, 0x49, 0x38,
+    0x94, 0x6b, 0xdb, 0xb7, 0x08, 0xcf, 0x93, 0xb8, 0x16, 0x87, 0x48, 0xf8, 0x09, 0xeb, 0xb3, 0x69,
+    0x60, 0x9c, 0x72, 0x8c, 0x1b, 0x1a, 0x58, 0x57, 0xe2, 0x7d, 0xe5, 0x4d, 0xdf, 0xb9, 0x6f, 0xa6,
+    0xa3, 0x2f, 0x56, 0x0f, 0x5b, 0x71, 0x40, 0xfa, 0x5b, 0xe1, 0xe8, 0xd4, 0x6c, 0x7c, 0xd5, 0x8d,
+    0x50, 0xb1, 0xca, 0xe6, 0x31, 0xfe, 0x52, 0x44, 0x2a, 0xbe, 0x8d, 0xce, 0x14, 0x25, 0xa2, 0x6c,
+    0xc9, 0x94, 0x44, 0x44, 0x45, 0xca, 0x94, 0x54, 0x44, 0x32, 0x91, 0x4c, 0xca, 0x60, 0xcb, 0x98,
+    0xb2, 0x80, 0x4d, 0x31, 0x65, 0x09, 0x9b, 0x2a, 0x98, 0x94, 0xc3, 0x96, 0x30, 0xa5, 0x80, 0x8d,
+    0x11, 0xc9, 0x38, 0xd8, 0x18, 0x92, 0x04, 0x76, 0xc6, 0xea, 0x4b, 0x60, 0xe7, 0x39, 0x53, 0x92,
+    0x60, 0x63, 0x48, 0x12, 0xdc, 0x29, 0xab, 0x2f, 0x81, 0x9d, 0x2f, 0x98, 0xb2, 0x08, 0x36, 0x86,
+    0x24, 0xc1, 0x9d, 0xf2, 0xfa, 0xc0, 0xce, 0x59, 0x4b, 0x64, 0x11, 0x6c, 0x0c, 0x49, 0x81, 0x3b,
+    0x65, 0xf5, 0x15, 0xb0, 0x73, 0xd6, 0x12, 0x05, 0x6c, 0x29, 0x19, 0x92, 0x02, 0x77, 0xca, 0xea,
+    0x2b, 0x60, 0xe7, 0xac, 0x25, 0x2a, 0x0b, 0x36, 0x86, 0xa4, 0xc0, 0x9d, 0xf2, 0xfa, 0xc0, 0x5e,
+    0xb2, 0x96, 0xa8, 0x3c, 0xd8, 0x38, 0x12, 0xb8, 0x13, 0x56, 0x3f, 0x01, 0xf6, 0x72, 0x71, 0x8b,
+    0xe7, 0xda, 0x68, 0xe7, 0x4b, 0x4b, 0x6b, 0xbc, 0x9b, 0xf0, 0x8e, 0x5f, 0x13, 0xae, 0xe2, 0x62,
+    0x25, 0xd5, 0x2a, 0x4d, 0x2f, 0xa4, 0xcc, 0xa7, 0xd1, 0xa4, 0xbd, 0x2f, 0x75, 0xd3, 0xf4, 0x8f,
+    0x78, 0xfb, 0x55, 0x63, 0x30, 0x1e, 0xff, 0x35, 0xaa, 0xe5, 0x99, 0xb1, 0xd2, 0xd5, 0x96, 0x4a,
+    0xaf, 0xed, 0x86, 0x70, 0x41, 0x98, 0x83, 0x37, 0xb3, 0x2d, 0x61, 0x46, 0xea, 0xf2, 0x6e, 0x9a,
+    0xed, 0xb0, 0x1f, 0xb0, 0x2c, 0xc6, 0x71, 0x5a, 0x14, 0xb1, 0xcc, 0x8b, 0x78, 0xbd, 0xa8, 0xe6,
+    0xea, 0x6e, 0x49, 0xf3, 0x18, 0xbf, 0x79, 0x76, 0x97, 0xd3, 0x3c, 0x23, 0xa5, 0xb3, 0x75, 0x4c,
+    0x69, 0x15, 0xba, 0x1f, 0x26, 0xc4, 0x9b, 0xae, 0x3a, 0x6d, 0x97, 0x7d, 0x72, 0xff, 0x00, 0x71,
+    0x6d, 0x2c, 0xbe, 0xf4, 0x34, 0xc1, 0xdf, 0xf5, 0x3e, 0x8c, 0x78, 0x8b, 0x35, 0x83, 0x53, 0xab,
+    0xf7, 0xef, 0x68, 0xaf, 0xdb, 0xa1, 0xa1, 0x8b, 0x0a, 0xa3, 0x19, 0x86, 0x8c, 0x5c, 0x65, 0xcd,
+    0x10, 0xe6, 0x0b, 0x09, 0xd7, 0xd8, 0x15, 0x6e, 0xf6, 0xb8, 0xed, 0x67, 0x08, 0x23, 0x0b, 0x7c,
+    0x33, 0xbf, 0xa5, 0xd3, 0x82, 0x9a, 0xad, 0xd1, 0x93, 0x68, 0x36, 0x90, 0x9d, 0x1d, 0x27, 0xde,
+    0xeb, 0x4d, 0xd8, 0x2b, 0xe8, 0xae, 0x37, 0x2d, 0x3d, 0xf7, 0x5d, 0x28, 0x79, 0x7d, 0xf5, 0x11,
+    0x21, 0xe3, 0xca, 0xa9, 0x1d, 0x00, 0xf3, 0x76, 0xa4, 0xb0, 0x30, 0x42, 0x5f, 0xff, 0xed, 0xb4,
+    0xc1, 0xd2, 0xce, 0xf4, 0xa3, 0x3b, 0x9e, 0x0f, 0x7f, 0x01, 0xaf, 0xe5, 0x70, 0x87,
+};
@@ -0,0 +1,203 @@
+#include <unity.h>
+#include <miniz.h>
+#include <string>
+#include <vector>
+#include "posthog/InflateStream.h"
+#include "posthog/parsers/InsightParser.h"
+#include "fixtures.h"
+
+/**
+ * Response body in memory, handed out a segment at a time like a socket.
+ * Never waits: an empty stream has ended.
+ */
+class BodyStream : public Stream {
+public:
+    BodyStream(const uint8_t* data, size_t length, size_t segment = 536)
+        : _data(data), _length(length), _segment(segment) {
+        setTimeout(0);
+    }
+
+    int available() override {
+        return (int)std::min(_segment, _length - _pos);
+    }
+
+    int read() override {
+        return _pos < _length ? _data[_pos++] : -1;
+    }
+
+    int peek() override {
+        return _pos < _length ? _data[_pos] : -1;
+    }
+
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    const uint8_t* _data;
+    size_t _length;
+    size_t _segment;
+    size_t _pos = 0;
+};
+
+// Read everything the inflater produces
+static std::string drain(InflateStream& inflater) {
+    std::string out;
+    int c;
+    while ((c = inflater.read()) >= 0) {
+        out += (char)c;
+    }
+    return out;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_gzip_fixture_decodes() {
+    BodyStream body(INSIGHT_GZIP, sizeof(INSIGHT_GZIP));
+    InflateStream inflater(body, InflateStream::Format::GZIP);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    std::string out = drain(inflater);
+    TEST_ASSERT_TRUE(inflater.isComplete());
+    TEST_ASSERT_FALSE(inflater.hasError());
+    TEST_ASSERT_EQUAL_STRING(INSIGHT_JSON, out.c_str());
+    TEST_ASSERT_EQUAL(strlen(INSIGHT_JSON), inflater.bytesOut());
+}
+
+void test_deflate_fixture_decodes() {
+    BodyStream body(INSIGHT_DEFLATE, sizeof(INSIGHT_DEFLATE));
+    InflateStream inflater(body, InflateStream::Format::ZLIB);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    std::string out = drain(inflater);
+    TEST_ASSERT_TRUE(inflater.isComplete());
+    TEST_ASSERT_FALSE(inflater.hasError());
+    TEST_ASSERT_EQUAL_STRING(INSIGHT_JSON, out.c_str());
+}
+
+void test_parser_reads_through_inflater() {
+    InsightParser plain(INSIGHT_JSON);
+    BodyStream body(INSIGHT_GZIP, sizeof(INSIGHT_GZIP), 64);
+    InflateStream inflater(body, InflateStream::Format::GZIP);
+    TEST_ASSERT_TRUE(inflater.begin());
+    InsightParser parsed(inflater, InsightParser::MIN_DOCUMENT_CAPACITY * 2);
+
+    TEST_ASSERT_TRUE(parsed.isValid());
+    TEST_ASSERT_EQUAL(30, parsed.getSeriesPointCount());
+    TEST_ASSERT_EQUAL_UINT32(plain.getContentDigest(), parsed.getContentDigest());
+}
+
+void test_output_larger_than_window_decodes() {
+    // Well past the 32KB window, so the circular buffer wraps several times
+    std::string text;
+    for (int i = 0; text.size() < 5 * InflateStream::WINDOW_SIZE; i++) {
+        text += "[\"2025-01-01T" + std::to_string(i % 24) + ":00:00Z\"," + std::to_string(i * 7919 % 10007) + "],";
+    }
+    mz_ulong compressed_length = mz_compressBound(text.size());
+    std::vector<uint8_t> compressed(compressed_length);
+    TEST_ASSERT_EQUAL(MZ_OK, mz_compress(compressed.data(), &compressed_length,
+                                         reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+
+    BodyStream body(compressed.data(), compressed_length);
+    InflateStream inflater(body, InflateStream::Format::ZLIB);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    std::string out = drain(inflater);
+    TEST_ASSERT_TRUE(inflater.isComplete());
+    TEST_ASSERT_EQUAL(text.size(), out.size());
+    TEST_ASSERT_TRUE(text == out);
+}
+
+void test_truncated_gzip_is_an_error() {
+    size_t cut = sizeof(INSIGHT_GZIP) / 2;
+    BodyStream body(INSIGHT_GZIP, cut);
+    InflateStream inflater(body, InflateStream::Format::GZIP);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    std::string out = drain(inflater);
+    TEST_ASSERT_TRUE(inflater.hasError());
+    TEST_ASSERT_FALSE(inflater.isComplete());
+    TEST_ASSERT_LESS_THAN(strlen(INSIGHT_JSON), out.size());
+    // Whatever came out before the cut is correct
+    TEST_ASSERT_EQUAL_INT(0, memcmp(INSIGHT_JSON, out.data(), out.size()));
+}
+
+void test_truncated_gzip_header_is_an_error() {
+    BodyStream body(INSIGHT_GZIP, 6);
+    InflateStream inflater(body, InflateStream::Format::GZIP);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    TEST_ASSERT_EQUAL(-1, inflater.read());
+    TEST_ASSERT_TRUE(inflater.hasError());
+}
+
+void test_truncated_deflate_fails_the_parse() {
+    BodyStream body(INSIGHT_DEFLATE, sizeof(INSIGHT_DEFLATE) - 40);
+    InflateStream inflater(body, InflateStream::Format::ZLIB);
+    TEST_ASSERT_TRUE(inflater.begin());
+    InsightParser parsed(inflater, InsightParser::MIN_DOCUMENT_CAPACITY * 2);
+
+    TEST_ASSERT_FALSE(parsed.isValid());
+    TEST_ASSERT_FALSE(parsed.ranOutOfMemory());
+    TEST_ASSERT_TRUE(inflater.hasError());
+}
+
+void test_wrong_gzip_magic_is_an_error() {
+    std::vector<uint8_t> corrupt(INSIGHT_GZIP, INSIGHT_GZIP + sizeof(INSIGHT_GZIP));
+    corrupt[1] = 0x00;
+    BodyStream body(corrupt.data(), corrupt.size());
+    InflateStream inflater(body, InflateStream::Format::GZIP);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    TEST_ASSERT_EQUAL(-1, inflater.read());
+    TEST_ASSERT_TRUE(inflater.hasError());
+    TEST_ASSERT_EQUAL(0, inflater.bytesOut());
+}
+
+void test_corrupt_deflate_block_is_an_error() {
+    // After the 2-byte zlib header: final block of the reserved type 3
+    std::vector<uint8_t> corrupt(INSIGHT_DEFLATE, INSIGHT_DEFLATE + sizeof(INSIGHT_DEFLATE));
+    corrupt[2] = 0x07;
+    BodyStream body(corrupt.data(), corrupt.size());
+    InflateStream inflater(body, InflateStream::Format::ZLIB);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    drain(inflater);
+    TEST_ASSERT_TRUE(inflater.hasError());
+    TEST_ASSERT_FALSE(inflater.isComplete());
+}
+
+void test_corrupt_zlib_header_is_an_error() {
+    std::vector<uint8_t> corrupt(INSIGHT_DEFLATE, INSIGHT_DEFLATE + sizeof(INSIGHT_DEFLATE));
+    corrupt[1] ^= 0x01; // Header checksum no longer divides by 31
+    BodyStream body(corrupt.data(), corrupt.size());
+    InflateStream inflater(body, InflateStream::Format::ZLIB);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    TEST_ASSERT_EQUAL(-1, inflater.read());
+    TEST_ASSERT_TRUE(inflater.hasError());
+}
+
+void test_gzip_body_declared_as_deflate_is_an_error() {
+    BodyStream body(INSIGHT_GZIP, sizeof(INSIGHT_GZIP));
+    InflateStream inflater(body, InflateStream::Format::ZLIB);
+    TEST_ASSERT_TRUE(inflater.begin());
+
+    TEST_ASSERT_EQUAL(-1, inflater.read());
+    TEST_ASSERT_TRUE(inflater.hasError());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gzip_fixture_decodes);
+    RUN_TEST(test_deflate_fixture_decodes);
+    RUN_TEST(test_parser_reads_through_inflater);
+    RUN_TEST(test_output_larger_than_window_decodes);
+    RUN_TEST(test_truncated_gzip_is_an_error);
+    RUN_TEST(test_truncated_gzip_header_is_an_error);
+    RUN_TEST(test_truncated_deflate_fails_the_parse);
+    RUN_TEST(test_wrong_gzip_magic_is_an_error);
+    RUN_TEST(test_corrupt_deflate_block_is_an_error);
+    RUN_TEST(test_corrupt_zlib_header_is_an_error);
+    RUN_TEST(test_gzip_body_declared_as_deflate_is_an_error);
+    return UNITY_END();
+}
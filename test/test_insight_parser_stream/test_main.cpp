@@ -0,0 +1,137 @@
+#include <unity.h>
+#include <malloc.h>
+#include <string>
+#include "posthog/parsers/InsightParser.h"
+
+// Heap in use, sampled by the stream while the parser reads from it
+static size_t heapInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+/**
+ * Stream that hands out a body a few bytes at a time, the way a socket
+ * delivers a response, and records the most heap in use at any read.
+ */
+class ChunkedStream : public Stream {
+public:
+    ChunkedStream(const std::string& body, size_t chunk) : _body(body), _chunk(chunk) {
+        setTimeout(0);
+    }
+
+    int available() override {
+        return (int)std::min(_chunk, _body.size() - _pos);
+    }
+
+    int read() override {
+        sample();
+        return _pos < _body.size() ? (uint8_t)_body[_pos++] : -1;
+    }
+
+    int peek() override {
+        return _pos < _body.size() ? (uint8_t)_body[_pos] : -1;
+    }
+
+    size_t readBytes(char* buffer, size_t length) override {
+        sample();
+        size_t count = std::min(std::min(length, _chunk), _body.size() - _pos);
+        memcpy(buffer, _body.data() + _pos, count);
+        _pos += count;
+        _reads++;
+        return count;
+    }
+
+    size_t write(uint8_t) override { return 0; }
+
+    void resetPeak() { _peak = heapInUse(); }
+    size_t peak() const { return _peak; }
+    size_t reads() const { return _reads; }
+
+private:
+    const std::string& _body;
+    size_t _chunk;
+    size_t _pos = 0;
+    size_t _peak = 0;
+    size_t _reads = 0;
+
+    void sample() {
+        size_t used = heapInUse();
+        if (used > _peak) {
+            _peak = used;
+        }
+    }
+};
+
+// Trends response with fields the filter drops: a long description and per-point person URLs
+static std::string seriesBody(size_t points, size_t padding) {
+    std::string body = "{\"results\":[{\"name\":\"Daily signups\",\"description\":\"";
+    body.append(padding, 'x');
+    body += "\",\"query\":{\"kind\":\"InsightVizNode\",\"display\":\"ActionsLineGraph\"},\"persons_urls\":[";
+    for (size_t i = 0; i < points; i++) {
+        body += i ? "," : "";
+        body += "{\"url\":\"api/projects/1/persons/trends/?date_from=2025-01-01&entity_id=signed_up&offset=" +
+                std::to_string(i) + "\"}";
+    }
+    body += "],\"result\":[";
+    char point[48];
+    for (size_t i = 0; i < points; i++) {
+        snprintf(point, sizeof(point), "%s[\"2025-%02zu-%02zu\",%zu]", i ? "," : "", i / 28 % 12 + 1, i % 28 + 1, i * 7 % 101);
+        body += point;
+    }
+    body += "],\"last_refresh\":\"2025-06-01T12:00:00Z\"}]}";
+    return body;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_chunked_stream_parses_like_a_string() {
+    std::string body = seriesBody(120, 2000);
+    InsightParser fromString(body.c_str());
+    ChunkedStream stream(body, 7);
+    InsightParser fromStream(stream, 32768);
+
+    TEST_ASSERT_TRUE(fromString.isValid());
+    TEST_ASSERT_TRUE(fromStream.isValid());
+    TEST_ASSERT_EQUAL(InsightParser::InsightType::LINE_GRAPH, fromStream.getInsightType());
+    TEST_ASSERT_EQUAL(120, fromStream.getSeriesPointCount());
+    TEST_ASSERT_EQUAL_UINT32(fromString.getContentDigest(), fromStream.getContentDigest());
+    TEST_ASSERT_GREATER_THAN(100, stream.reads());
+}
+
+void test_peak_heap_bounded_by_document_not_body() {
+    const size_t capacity = 16384;
+    // Slack for the parser object and allocator bookkeeping
+    const size_t slack = 4096;
+
+    for (size_t padding : {64 * 1024, 512 * 1024}) {
+        std::string body = seriesBody(200, padding);
+        ChunkedStream stream(body, 1460);
+
+        size_t before = heapInUse();
+        stream.resetPeak();
+        InsightParser parser(stream, capacity, InsightParser::FilterType::SERIES);
+
+        TEST_ASSERT_TRUE(parser.isValid());
+        TEST_ASSERT_EQUAL(200, parser.getSeriesPointCount());
+        TEST_ASSERT_LESS_OR_EQUAL(capacity + slack, stream.peak() - before);
+        TEST_ASSERT_LESS_THAN(body.size() / 4, stream.peak() - before);
+    }
+}
+
+void test_small_document_reports_out_of_memory() {
+    std::string body = seriesBody(2000, 0);
+    ChunkedStream stream(body, 512);
+    InsightParser parser(stream, InsightParser::MIN_DOCUMENT_CAPACITY);
+
+    TEST_ASSERT_FALSE(parser.isValid());
+    TEST_ASSERT_TRUE(parser.ranOutOfMemory());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_chunked_stream_parses_like_a_string);
+    RUN_TEST(test_peak_heap_bounded_by_document_not_body);
+    RUN_TEST(test_small_document_reports_out_of_memory);
+    return UNITY_END();
+}